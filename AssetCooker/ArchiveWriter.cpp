@@ -0,0 +1,90 @@
+#include "ArchiveWriter.h"
+
+ArchiveWriter::ArchiveWriter()
+{
+
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+
+}
+
+void ArchiveWriter::addFile(const std::string& name, const std::string& path)
+{
+    files.push_back({ name, path });
+}
+
+uint64_t ArchiveWriter::write(const std::string& filename)
+{
+    std::sort(files.begin(), files.end(), [](const PendingFile& a, const PendingFile& b) { return a.name < b.name; });
+    for (size_t i = 1; i < files.size(); i++)
+    {
+        if (files[i].name == files[i - 1].name)
+        {
+            throw std::runtime_error("Archive has duplicate entry: " + files[i].name);
+        }
+    }
+
+    ArchiveHeader header;
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = static_cast<uint32_t>(files.size());
+
+    std::string names;
+    std::vector<ArchiveEntry> entries(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        entries[i].nameLength = static_cast<uint32_t>(files[i].name.size());
+        names += files[i].name;
+    }
+    header.namesSize = static_cast<uint32_t>(names.size());
+
+    // Data starts after table of contents, every entry on aligned offset
+    uint64_t offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + names.size();
+    std::vector<std::vector<char>> contents(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        std::ifstream file(files[i].path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open the file: " + files[i].path);
+        }
+
+        contents[i].resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(contents[i].data(), contents[i].size());
+
+        offset = (offset + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+        entries[i].offset = offset;
+        entries[i].size = contents[i].size();
+        offset += contents[i].size();
+    }
+
+    std::ofstream archive(filename, std::ios::binary | std::ios::trunc);
+    if (!archive.is_open())
+    {
+        throw std::runtime_error("Failed to create archive: " + filename);
+    }
+
+    archive.write(reinterpret_cast<const char*>(&header), sizeof(ArchiveHeader));
+    archive.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ArchiveEntry));
+    archive.write(names.data(), names.size());
+
+    const char padding[ARCHIVE_ALIGNMENT] = {};
+    uint64_t written = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + names.size();
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        archive.write(padding, entries[i].offset - written);
+        archive.write(contents[i].data(), contents[i].size());
+        written = entries[i].offset + entries[i].size;
+    }
+
+    if (!archive.good())
+    {
+        throw std::runtime_error("Failed to write archive: " + filename);
+    }
+
+    return written;
+}
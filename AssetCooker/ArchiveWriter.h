@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "AssetArchive.h"
+
+// Packs files into archive read by engine's AssetArchive.
+// Entries are written sorted by name (engine looks them up with binary search), each one aligned to ARCHIVE_ALIGNMENT.
+class ArchiveWriter
+{
+public:
+    ArchiveWriter();
+
+    // Name is path entry is looked up by (relative to asset root), path is where file is read from
+    void addFile(const std::string& name, const std::string& path);
+
+    // Returns size of written archive
+    uint64_t write(const std::string& filename);
+
+    ~ArchiveWriter();
+
+private:
+    struct PendingFile {
+        std::string name;
+        std::string path;
+    };
+
+    std::vector<PendingFile> files;
+};
@@ -0,0 +1,196 @@
+#include "BlockCompressor.h"
+
+void BlockCompressor::compressBC1(const uint8_t* rgba, uint8_t* block)
+{
+    // Mean colour of block
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            mean[c] += rgba[i * 4 + c];
+        }
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        mean[c] /= 16.0f;
+    }
+
+    // Covariance of colours - endpoints lie on its principal axis
+    float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };   // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++)
+    {
+        float r = rgba[i * 4 + 0] - mean[0];
+        float g = rgba[i * 4 + 1] - mean[1];
+        float b = rgba[i * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // Power iteration
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+
+        float length = std::max(std::max(std::abs(x), std::abs(y)), std::abs(z));
+        if (length < 1e-6f)
+        {
+            break;                                  // Flat block - any axis works
+        }
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    // Extremes along axis
+    float minProjection = 1e30f;
+    float maxProjection = -1e30f;
+    for (int i = 0; i < 16; i++)
+    {
+        float projection = (rgba[i * 4 + 0] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    float axisLength = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (axisLength > 0.0f)
+    {
+        minProjection /= axisLength;
+        maxProjection /= axisLength;
+    }
+
+    float endpoints[2][3];
+    for (int c = 0; c < 3; c++)
+    {
+        endpoints[0][c] = mean[c] + axis[c] * maxProjection;
+        endpoints[1][c] = mean[c] + axis[c] * minProjection;
+    }
+
+    uint16_t color0 = packColor(endpoints[0]);
+    uint16_t color1 = packColor(endpoints[1]);
+
+    // 4 colour mode needs color0 > color1
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        unpackColor(color0, palette[0]);
+        unpackColor(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int bestIndex = 0;
+            int bestDistance = INT32_MAX;
+            for (int p = 0; p < 4; p++)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    int difference = rgba[i * 4 + c] - palette[p][c];
+                    distance += difference * difference;
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+        }
+    }
+
+    memcpy(block + 0, &color0, 2);
+    memcpy(block + 2, &color1, 2);
+    memcpy(block + 4, &indices, 4);
+}
+
+void BlockCompressor::compressBC3(const uint8_t* rgba, uint8_t* block)
+{
+    compressAlpha(rgba, block);
+    compressBC1(rgba, block + 8);
+}
+
+void BlockCompressor::compressAlpha(const uint8_t* rgba, uint8_t* block)
+{
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+        alpha0 = std::max(alpha0, static_cast<int>(rgba[i * 4 + 3]));
+        alpha1 = std::min(alpha1, static_cast<int>(rgba[i * 4 + 3]));
+    }
+
+    // alpha0 > alpha1 - 8 value mode, codes 2..7 interpolate between them
+    int palette[8];
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    for (int k = 2; k < 8; k++)
+    {
+        palette[k] = ((8 - k) * alpha0 + (k - 1) * alpha1) / 7;
+    }
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int bestIndex = 0;
+            int bestDistance = 256;
+            for (int p = 0; p < 8; p++)
+            {
+                int distance = std::abs(rgba[i * 4 + 3] - palette[p]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(bestIndex) << (i * 3);
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(alpha0);
+    block[1] = static_cast<uint8_t>(alpha1);
+    for (int i = 0; i < 6; i++)
+    {
+        block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+uint16_t BlockCompressor::packColor(const float* color)
+{
+    int r = std::min(std::max(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+    int g = std::min(std::max(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+    int b = std::min(std::max(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void BlockCompressor::unpackColor(uint16_t packed, int* color)
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+
+    // Replicate high bits into low ones, same as decoder does
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+
+// CPU encoders for BC1 / BC3 blocks - principal axis endpoint fit, nearest palette entry per texel.
+// Input is always a 4x4 block of RGBA8 texels (row major, 64 bytes).
+class BlockCompressor
+{
+public:
+    // 8 bytes - colour only, 4 colour mode
+    static void compressBC1(const uint8_t* rgba, uint8_t* block);
+
+    // 16 bytes - 8 bytes interpolated alpha followed by BC1 colour block
+    static void compressBC3(const uint8_t* rgba, uint8_t* block);
+
+private:
+    static void compressAlpha(const uint8_t* rgba, uint8_t* block);
+    static uint16_t packColor(const float* color);
+    static void unpackColor(uint16_t packed, int* color);
+};
@@ -0,0 +1,143 @@
+#include "CookCache.h"
+
+CookCache::CookCache()
+{
+
+}
+
+CookCache::~CookCache()
+{
+
+}
+
+CookCache::CookCache(const std::string& root)
+{
+    this->root = root;
+    this->filename = root + "/AssetCache.txt";
+
+    // One line per input: hash <tab> input <tab> output [<tab> output ...]
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string hash, input, output;
+        if (!std::getline(fields, hash, '\t') || !std::getline(fields, input, '\t'))
+        {
+            continue;
+        }
+
+        CookEntry entry;
+        entry.hash = std::stoull(hash, nullptr, 16);
+        while (std::getline(fields, output, '\t'))
+        {
+            entry.outputs.push_back(output);
+        }
+
+        entries[input] = entry;
+    }
+}
+
+uint64_t CookCache::hashContent(const std::vector<char>& data, const std::string& version)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : version)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    for (char c : data)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+uint64_t CookCache::hashDependency(uint64_t hash, const std::string& name, const std::vector<char>& data)
+{
+    // Terminated name, so name and content can't be mistaken for one another
+    for (size_t i = 0; i <= name.size(); i++)
+    {
+        hash = (hash ^ static_cast<uint8_t>(name.c_str()[i])) * 1099511628211ull;
+    }
+    for (char c : data)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+bool CookCache::isUpToDate(const std::string& input, uint64_t hash)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto entry = entries.find(input);
+    if (entry == entries.end() || entry->second.hash != hash)
+    {
+        return false;
+    }
+
+    // Output deleted by hand - cook again
+    for (const auto& output : entry->second.outputs)
+    {
+        if (!std::ifstream(root + "/" + output).good())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<std::string> CookCache::getOutputs(const std::string& input)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto entry = entries.find(input);
+    return entry != entries.end() ? entry->second.outputs : std::vector<std::string>();
+}
+
+std::vector<std::string> CookCache::getAllOutputs()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::string> outputs;
+    for (const auto& entry : entries)
+    {
+        outputs.insert(outputs.end(), entry.second.outputs.begin(), entry.second.outputs.end());
+    }
+
+    return outputs;
+}
+
+void CookCache::update(const std::string& input, uint64_t hash, const std::vector<std::string>& outputs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    CookEntry entry;
+    entry.hash = hash;
+    entry.outputs = outputs;
+    entries[input] = entry;
+}
+
+void CookCache::save()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to write cook cache: " + filename);
+    }
+
+    for (const auto& entry : entries)
+    {
+        file << std::hex << entry.second.hash << std::dec << '\t' << entry.first;
+        for (const auto& output : entry.second.outputs)
+        {
+            file << '\t' << output;
+        }
+        file << '\n';
+    }
+}
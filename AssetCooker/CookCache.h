@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <stdexcept>
+
+// What was produced from an input last time and hash of content it was produced from
+struct CookEntry {
+    uint64_t hash = 0;
+    std::vector<std::string> outputs;
+};
+
+// Content hashes of cooked inputs, stored as text in asset root (paths relative to it, so root can move).
+// Input whose hash (data + cooker version + files it depends on) didn't change and whose outputs still exist is skipped.
+// Safe to use from multiple threads.
+class CookCache
+{
+public:
+    CookCache();
+    CookCache(const std::string& root);
+
+    // FNV-1a 64, seeded with step version so changing cooker settings recooks everything of that step
+    static uint64_t hashContent(const std::vector<char>& data, const std::string& version);
+
+    // Continues hash with another file input depends on - its name (relative to root) and content
+    static uint64_t hashDependency(uint64_t hash, const std::string& name, const std::vector<char>& data);
+
+    bool isUpToDate(const std::string& input, uint64_t hash);
+
+    // Outputs recorded for input (empty if it was never cooked)
+    std::vector<std::string> getOutputs(const std::string& input);
+
+    // Outputs of every cooked input
+    std::vector<std::string> getAllOutputs();
+
+    void update(const std::string& input, uint64_t hash, const std::vector<std::string>& outputs);
+
+    void save();
+
+    ~CookCache();
+
+private:
+    std::string root;
+    std::string filename;
+    std::map<std::string, CookEntry> entries;       // Input path -> entry
+    std::mutex mutex;
+};
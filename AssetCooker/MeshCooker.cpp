@@ -0,0 +1,37 @@
+#include "MeshCooker.h"
+
+#include <cstdio>
+
+MeshCooker::MeshCooker()
+{
+
+}
+
+MeshCooker::~MeshCooker()
+{
+
+}
+
+std::string MeshCooker::cook(const std::string& input)
+{
+    ModelImporter importer(&threadPool);
+    std::vector<MeshData> meshes = importer.importObj(input);
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        MeshOptimizationStats stats = MeshOptimizer::optimize(&meshes[i]);
+
+        std::string lodTriangles;
+        for (const auto& lod : meshes[i].lods)
+        {
+            lodTriangles += (lodTriangles.empty() ? "" : "/") + std::to_string(lod.indexCount / 3);
+        }
+        printf("  %s [%zu]: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %u vertices welded, %u LODs (%s triangles)\n", input.c_str(), i,
+            stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr, stats.weldedVertices, stats.lodCount, lodTriangles.c_str());
+    }
+
+    std::string output = input.substr(0, input.find_last_of('.')) + ".vmesh";
+    MeshFile::write(output, meshes);
+
+    return output;
+}
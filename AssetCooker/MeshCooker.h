@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "ModelImporter.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+const char* const MESH_COOKER_VERSION = "mesh-5";           // Part of content hash - bump when output changes
+
+// Whole version of cooked models - output also changes with importer and mesh file format
+const std::string MESH_COOK_VERSION = std::string(MESH_COOKER_VERSION) + "/" + MODEL_IMPORTER_VERSION + "/vmesh-" + std::to_string(MESH_FILE_VERSION);
+
+// OBJ model -> binary mesh file (name.vmesh) the runtime streams without parsing.
+// Submeshes get a LOD chain and are optimized for vertex cache, overdraw and vertex fetch before writing, cache stats are printed.
+class MeshCooker
+{
+public:
+    MeshCooker();
+
+    // Returns path of written file
+    std::string cook(const std::string& input);
+
+    ~MeshCooker();
+
+private:
+    // Own pool for parsing - cook itself runs on a thread of cooker's pool, which can't wait on its own tasks
+    ThreadPool threadPool;
+};
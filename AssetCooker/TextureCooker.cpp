@@ -0,0 +1,221 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "TextureCooker.h"
+
+#include "stb_image.h"
+
+static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const uint32_t KTX2_HEADER_SIZE = 80;
+static const uint32_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+// Data Format Descriptor values (Khronos Data Format Specification)
+static const uint32_t KHR_DF_MODEL_BC1A = 128;
+static const uint32_t KHR_DF_MODEL_BC3 = 130;
+static const uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+static const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+static const uint32_t KHR_DF_CHANNEL_BC3_ALPHA = 15;
+
+TextureCooker::TextureCooker()
+{
+
+}
+
+TextureCooker::~TextureCooker()
+{
+
+}
+
+std::string TextureCooker::cook(const std::string& input, const std::vector<char>& data)
+{
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data.data()), static_cast<int>(data.size()), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        throw std::runtime_error("Failed to decode texture: " + input);
+    }
+
+    bool hasAlpha = false;
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+    {
+        if (pixels[i * 4 + 3] != 255)
+        {
+            hasAlpha = true;
+            break;
+        }
+    }
+
+    std::vector<Level> mipChain = buildMipChain(pixels, width, height);
+    stbi_image_free(pixels);
+
+    std::vector<std::vector<uint8_t>> compressedLevels;
+    for (const auto& level : mipChain)
+    {
+        compressedLevels.push_back(compressLevel(level, hasAlpha));
+    }
+
+    // name.tga -> name.bc1.ktx2
+    std::string output = input.substr(0, input.find_last_of('.')) + (hasAlpha ? ".bc3.ktx2" : ".bc1.ktx2");
+    writeKtx2(output, hasAlpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK, width, height, compressedLevels);
+
+    return output;
+}
+
+std::vector<TextureCooker::Level> TextureCooker::buildMipChain(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    std::vector<Level> levels(1);
+    levels[0].width = width;
+    levels[0].height = height;
+    levels[0].data.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+    // 2x2 box filter, odd edge reuses last texel - same result as linear blit on GPU
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        const Level& source = levels.back();
+
+        Level level;
+        level.width = std::max(source.width / 2, 1u);
+        level.height = std::max(source.height / 2, 1u);
+        level.data.resize(static_cast<size_t>(level.width) * level.height * 4);
+
+        for (uint32_t y = 0; y < level.height; y++)
+        {
+            uint32_t y0 = std::min(y * 2, source.height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, source.height - 1);
+
+            for (uint32_t x = 0; x < level.width; x++)
+            {
+                uint32_t x0 = std::min(x * 2, source.width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, source.width - 1);
+
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    uint32_t sum = source.data[(y0 * source.width + x0) * 4 + c] + source.data[(y0 * source.width + x1) * 4 + c]
+                        + source.data[(y1 * source.width + x0) * 4 + c] + source.data[(y1 * source.width + x1) * 4 + c];
+                    level.data[(y * level.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+
+        levels.push_back(std::move(level));
+    }
+
+    return levels;
+}
+
+std::vector<uint8_t> TextureCooker::compressLevel(const Level& level, bool hasAlpha)
+{
+    uint32_t blocksX = (level.width + 3) / 4;
+    uint32_t blocksY = (level.height + 3) / 4;
+    size_t blockSize = hasAlpha ? 16 : 8;
+
+    std::vector<uint8_t> compressed(blocksX * blocksY * blockSize);
+    uint8_t texels[64];
+
+    for (uint32_t by = 0; by < blocksY; by++)
+    {
+        for (uint32_t bx = 0; bx < blocksX; bx++)
+        {
+            // Gather 4x4 texels, blocks reaching past edge repeat edge texels
+            for (uint32_t y = 0; y < 4; y++)
+            {
+                uint32_t sourceY = std::min(by * 4 + y, level.height - 1);
+                for (uint32_t x = 0; x < 4; x++)
+                {
+                    uint32_t sourceX = std::min(bx * 4 + x, level.width - 1);
+                    memcpy(texels + (y * 4 + x) * 4, level.data.data() + (sourceY * level.width + sourceX) * 4, 4);
+                }
+            }
+
+            uint8_t* block = compressed.data() + (by * blocksX + bx) * blockSize;
+            if (hasAlpha)
+            {
+                BlockCompressor::compressBC3(texels, block);
+            }
+            else
+            {
+                BlockCompressor::compressBC1(texels, block);
+            }
+        }
+    }
+
+    return compressed;
+}
+
+void TextureCooker::writeKtx2(const std::string& filename, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels)
+{
+    bool isBC3 = format == VK_FORMAT_BC3_UNORM_BLOCK;
+    uint32_t levelCount = static_cast<uint32_t>(levels.size());
+
+    // Data Format Descriptor - basic block with one sample per compressed plane
+    std::vector<uint32_t> dfd;
+    uint32_t sampleCount = isBC3 ? 2 : 1;
+    uint32_t blockBytes = isBC3 ? 16 : 8;
+    dfd.push_back(4 + 24 + 16 * sampleCount);                                               // dfdTotalSize
+    dfd.push_back(0);                                                                       // vendorId, descriptorType
+    dfd.push_back(2 | ((24 + 16 * sampleCount) << 16));                                     // versionNumber, descriptorBlockSize
+    dfd.push_back((isBC3 ? KHR_DF_MODEL_BC3 : KHR_DF_MODEL_BC1A) | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+    dfd.push_back(3 | (3 << 8));                                                            // texelBlockDimension 4x4 (stored minus one)
+    dfd.push_back(blockBytes);                                                              // bytesPlane0
+    dfd.push_back(0);
+    if (isBC3)
+    {
+        // Alpha in first 64 bits, colour in second
+        dfd.insert(dfd.end(), { 0 | (63 << 16) | (KHR_DF_CHANNEL_BC3_ALPHA << 24), 0, 0, 0xFFFFFFFF });
+        dfd.insert(dfd.end(), { 64 | (63 << 16), 0, 0, 0xFFFFFFFF });
+    }
+    else
+    {
+        dfd.insert(dfd.end(), { 0 | (63 << 16), 0, 0, 0xFFFFFFFF });
+    }
+
+    uint32_t dfdOffset = KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_SIZE * levelCount;
+    uint32_t dfdLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+    // Level data follows, smallest level first, each aligned to block size
+    std::vector<uint64_t> levelOffsets(levelCount);
+    uint64_t offset = dfdOffset + dfdLength;
+    for (int32_t i = levelCount - 1; i >= 0; i--)
+    {
+        offset = (offset + 15) & ~15ull;
+        levelOffsets[i] = offset;
+        offset += levels[i].size();
+    }
+
+    std::vector<uint8_t> file(offset, 0);
+    auto write32 = [&file](size_t position, uint32_t value) { memcpy(file.data() + position, &value, 4); };
+    auto write64 = [&file](size_t position, uint64_t value) { memcpy(file.data() + position, &value, 8); };
+
+    memcpy(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    write32(12, static_cast<uint32_t>(format));     // vkFormat
+    write32(16, 1);                                 // typeSize
+    write32(20, width);                             // pixelWidth
+    write32(24, height);                            // pixelHeight
+    write32(28, 0);                                 // pixelDepth
+    write32(32, 0);                                 // layerCount
+    write32(36, 1);                                 // faceCount
+    write32(40, levelCount);                        // levelCount
+    write32(44, 0);                                 // supercompressionScheme
+    write32(48, dfdOffset);
+    write32(52, dfdLength);
+    write32(56, 0);                                 // kvdByteOffset
+    write32(60, 0);                                 // kvdByteLength
+    write64(64, 0);                                 // sgdByteOffset
+    write64(72, 0);                                 // sgdByteLength
+
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        size_t indexPosition = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_SIZE;
+        write64(indexPosition, levelOffsets[i]);
+        write64(indexPosition + 8, levels[i].size());
+        write64(indexPosition + 16, levels[i].size());
+        memcpy(file.data() + levelOffsets[i], levels[i].data(), levels[i].size());
+    }
+
+    memcpy(file.data() + dfdOffset, dfd.data(), dfdLength);
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        throw std::runtime_error("Failed to write cooked texture: " + filename);
+    }
+    stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+}
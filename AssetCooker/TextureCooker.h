@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include "BlockCompressor.h"
+
+const char* const TEXTURE_COOKER_VERSION = "texture-1";     // Part of content hash - bump when output changes
+
+// Source image -> KTX2 with full mip chain in block compressed format.
+// Opaque images become BC1 (name.bc1.ktx2), images with alpha BC3 (name.bc3.ktx2) - runtime TextureLoader picks them up instead of the source.
+class TextureCooker
+{
+public:
+    TextureCooker();
+
+    // Returns path of written file
+    std::string cook(const std::string& input, const std::vector<char>& data);
+
+    ~TextureCooker();
+
+private:
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Level> buildMipChain(const uint8_t* pixels, uint32_t width, uint32_t height);
+    std::vector<uint8_t> compressLevel(const Level& level, bool hasAlpha);
+    void writeKtx2(const std::string& filename, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels);
+};
@@ -0,0 +1,252 @@
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+
+#include "ThreadPool.h"
+#include "CookCache.h"
+#include "TextureCooker.h"
+#include "MeshCooker.h"
+#include "ArchiveWriter.h"
+
+namespace fs = std::filesystem;
+
+// Kind of asset cooker handles - inputs are found by directory and extension
+struct CookStep {
+    std::string directory;                                  // Relative to asset root
+    std::vector<std::string> extensions;
+    std::string version;                                    // Hashed with input, changing it recooks every input of step
+    std::function<std::vector<std::string>(const std::string& input, const std::vector<char>& data)> cook;
+
+    // Other files cook reads for input (may not exist) - hashed with it, none if empty
+    std::function<std::vector<std::string>(const std::string& input, const std::vector<char>& data)> dependencies;
+};
+
+struct CookResult {
+    std::string input;
+    bool cooked = false;
+    bool failed = false;
+    double milliseconds = 0.0;
+};
+
+static std::vector<char> readBinaryFile(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open the file: " + filename);
+    }
+
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+
+    return data;
+}
+
+int main(int argc, char** argv)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // Usage: AssetCooker [asset root] [--force] [--pack]
+    // Default root is engine project directory (working directory of cooker is its own project directory)
+    // --pack writes cooked outputs and compiled shaders into root/Assets.pak
+    std::string root = "../VulkanGraphicEngine";
+    bool force = false;
+    bool pack = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--force") == 0)
+        {
+            force = true;
+        }
+        else if (strcmp(argv[i], "--pack") == 0)
+        {
+            pack = true;
+        }
+        else
+        {
+            root = argv[i];
+        }
+    }
+
+    TextureCooker textureCooker;
+    MeshCooker meshCooker;
+
+    std::vector<CookStep> steps = {
+        { "Textures", { ".tga", ".png", ".jpg", ".bmp" }, TEXTURE_COOKER_VERSION,
+            [&textureCooker](const std::string& input, const std::vector<char>& data)
+            {
+                return std::vector<std::string>{ textureCooker.cook(input, data) };
+            },
+            nullptr },
+        { "Models", { ".obj" }, MESH_COOK_VERSION,
+            [&meshCooker](const std::string& input, const std::vector<char>&)
+            {
+                return std::vector<std::string>{ meshCooker.cook(input) };
+            },
+            [](const std::string& input, const std::vector<char>& data)
+            {
+                return ModelImporter::getMaterialLibraries(input, data);
+            } },
+    };
+
+    CookCache cache(root);
+
+    // Gather inputs of every step
+    std::vector<std::pair<const CookStep*, std::string>> inputs;
+    for (const auto& step : steps)
+    {
+        fs::path directory = fs::path(root) / step.directory;
+        if (!fs::exists(directory))
+        {
+            continue;
+        }
+
+        for (const auto& entry : fs::directory_iterator(directory))
+        {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+            if (entry.is_regular_file() && std::find(step.extensions.begin(), step.extensions.end(), extension) != step.extensions.end())
+            {
+                inputs.push_back({ &step, fs::relative(entry.path(), root).generic_string() });
+            }
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+
+    // Every input is independent - cook them on all hardware threads
+    std::vector<std::future<CookResult>> results;
+    {
+        ThreadPool threadPool;
+
+        for (const auto& input : inputs)
+        {
+            results.push_back(threadPool.submit([&cache, &input, &root, force]
+            {
+                Clock::time_point cookStart = Clock::now();
+
+                CookResult result;
+                result.input = input.second;
+
+                try
+                {
+                    std::vector<char> data = readBinaryFile(root + "/" + input.second);
+                    uint64_t hash = CookCache::hashContent(data, input.first->version);
+                    if (input.first->dependencies)
+                    {
+                        // Missing dependency is hashed empty - it appearing later recooks input
+                        for (const auto& dependency : input.first->dependencies(root + "/" + input.second, data))
+                        {
+                            std::vector<char> dependencyData;
+                            if (fs::exists(dependency))
+                            {
+                                dependencyData = readBinaryFile(dependency);
+                            }
+                            hash = CookCache::hashDependency(hash, fs::relative(dependency, root).generic_string(), dependencyData);
+                        }
+                    }
+
+                    if (force || !cache.isUpToDate(input.second, hash))
+                    {
+                        // Outputs of previous cook may have different names (e.g. texture gained alpha)
+                        for (const auto& output : cache.getOutputs(input.second))
+                        {
+                            std::remove((root + "/" + output).c_str());
+                        }
+
+                        std::vector<std::string> outputs;
+                        for (const auto& output : input.first->cook(root + "/" + input.second, data))
+                        {
+                            outputs.push_back(fs::relative(output, root).generic_string());
+                        }
+
+                        cache.update(input.second, hash, outputs);
+                        result.cooked = true;
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    printf("ERROR: %s\n", e.what());
+                    result.failed = true;
+                }
+
+                result.milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - cookStart).count();
+                return result;
+            }));
+        }
+    }
+
+    int cookedCount = 0;
+    int failedCount = 0;
+    for (auto& future : results)
+    {
+        CookResult result = future.get();
+        if (result.failed)
+        {
+            failedCount++;
+        }
+        else if (result.cooked)
+        {
+            cookedCount++;
+            printf("  cooked %s (%.1f ms)\n", result.input.c_str(), result.milliseconds);
+        }
+    }
+
+    cache.save();
+
+    double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    printf("%zu inputs: %d cooked, %zu up to date, %d failed in %.1f ms\n", inputs.size(), cookedCount,
+        inputs.size() - cookedCount - failedCount, failedCount, totalMs);
+
+    if (pack && failedCount == 0)
+    {
+        ArchiveWriter archiveWriter;
+        size_t entryCount = 0;
+
+        // Outputs of inputs removed since they were cooked may be gone already
+        for (const auto& output : cache.getAllOutputs())
+        {
+            if (fs::exists(fs::path(root) / output))
+            {
+                archiveWriter.addFile(output, root + "/" + output);
+                entryCount++;
+            }
+        }
+
+        fs::path shaders = fs::path(root) / "Shaders";
+        if (fs::exists(shaders))
+        {
+            for (const auto& entry : fs::directory_iterator(shaders))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == ".spv")
+                {
+                    archiveWriter.addFile(fs::relative(entry.path(), root).generic_string(), entry.path().string());
+                    entryCount++;
+                }
+            }
+        }
+
+        try
+        {
+            uint64_t archiveSize = archiveWriter.write(root + "/" + ASSET_ARCHIVE_FILE);
+            printf("Packed %zu entries into %s (%llu KB)\n", entryCount, ASSET_ARCHIVE_FILE, static_cast<unsigned long long>(archiveSize / 1024));
+        }
+        catch (const std::exception& e)
+        {
+            printf("ERROR: %s\n", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
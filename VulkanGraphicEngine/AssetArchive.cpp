@@ -0,0 +1,225 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+AssetArchive::AssetArchive()
+{
+
+}
+
+AssetArchive::~AssetArchive()
+{
+    close();
+}
+
+bool AssetArchive::open(const std::string& filename)
+{
+    if (!mapFile(filename))
+    {
+        return false;
+    }
+
+    ArchiveHeader header;
+    if (fileSize < sizeof(ArchiveHeader))
+    {
+        close();
+        throw std::runtime_error("Asset archive is too small: " + filename);
+    }
+    memcpy(&header, base, sizeof(ArchiveHeader));
+
+    if (memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header.version != ARCHIVE_VERSION)
+    {
+        close();
+        throw std::runtime_error("File is not a supported asset archive: " + filename);
+    }
+
+    // Table of contents is used in place - mapping is page aligned and entries start at 16 byte offset
+    uint64_t tocEnd = sizeof(ArchiveHeader) + static_cast<uint64_t>(header.entryCount) * sizeof(ArchiveEntry) + header.namesSize;
+    if (tocEnd > fileSize)
+    {
+        close();
+        throw std::runtime_error("Asset archive table of contents is truncated: " + filename);
+    }
+
+    entryCount = header.entryCount;
+    entries = reinterpret_cast<const ArchiveEntry*>(base + sizeof(ArchiveHeader));
+    names = base + sizeof(ArchiveHeader) + entryCount * sizeof(ArchiveEntry);
+
+    // Bounds are compared without adding offset and size, which could wrap around on a broken archive
+    for (uint32_t i = 0; i < entryCount; i++)
+    {
+        const ArchiveEntry& entry = entries[i];
+        if (entry.offset > fileSize || entry.size > fileSize - entry.offset ||
+            entry.nameOffset > header.namesSize || entry.nameLength > header.namesSize - entry.nameOffset)
+        {
+            close();
+            throw std::runtime_error("Asset archive entry is out of bounds: " + filename);
+        }
+
+        // Data is handed out in place - SPIR-V and texture blocks rely on this alignment
+        if (entry.offset % ARCHIVE_ALIGNMENT != 0)
+        {
+            close();
+            throw std::runtime_error("Asset archive entry is not aligned: " + filename);
+        }
+    }
+
+    return true;
+}
+
+bool AssetArchive::isOpen() const
+{
+    return base != nullptr;
+}
+
+bool AssetArchive::find(const std::string& name, const char** data, size_t* size) const
+{
+    // Entries are sorted by name - binary search
+    uint32_t first = 0;
+    uint32_t last = entryCount;
+    while (first < last)
+    {
+        uint32_t middle = (first + last) / 2;
+        const ArchiveEntry& entry = entries[middle];
+
+        int comparison = name.compare(0, std::string::npos, names + entry.nameOffset, entry.nameLength);
+        if (comparison == 0)
+        {
+            *data = base + entry.offset;
+            *size = static_cast<size_t>(entry.size);
+            return true;
+        }
+
+        if (comparison < 0)
+        {
+            last = middle;
+        }
+        else
+        {
+            first = middle + 1;
+        }
+    }
+
+    return false;
+}
+
+std::vector<std::string> AssetArchive::getNames() const
+{
+    std::vector<std::string> entryNames;
+    for (uint32_t i = 0; i < entryCount; i++)
+    {
+        entryNames.push_back(std::string(names + entries[i].nameOffset, entries[i].nameLength));
+    }
+
+    return entryNames;
+}
+
+void AssetArchive::close()
+{
+    unmapFile();
+
+    entries = nullptr;
+    entryCount = 0;
+    names = nullptr;
+}
+
+#ifdef _WIN32
+
+bool AssetArchive::mapFile(const std::string& filename)
+{
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map asset archive: " + filename);
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    base = static_cast<const char*>(view);
+    fileSize = static_cast<size_t>(size.QuadPart);
+
+    return true;
+}
+
+void AssetArchive::unmapFile()
+{
+    if (base)
+    {
+        UnmapViewOfFile(base);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+    }
+
+    base = nullptr;
+    fileSize = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#else
+
+bool AssetArchive::mapFile(const std::string& filename)
+{
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    fstat(descriptor, &fileStat);
+
+    void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(descriptor);
+        throw std::runtime_error("Failed to map asset archive: " + filename);
+    }
+
+    fileDescriptor = descriptor;
+    base = static_cast<const char*>(view);
+    fileSize = static_cast<size_t>(fileStat.st_size);
+
+    return true;
+}
+
+void AssetArchive::unmapFile()
+{
+    if (base)
+    {
+        munmap(const_cast<char*>(base), fileSize);
+        ::close(fileDescriptor);
+    }
+
+    base = nullptr;
+    fileSize = 0;
+    fileDescriptor = -1;
+}
+
+#endif
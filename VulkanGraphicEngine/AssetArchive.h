@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// Packed archive layout (written by AssetCooker --pack):
+// ArchiveHeader | ArchiveEntry[entryCount] sorted by name | name table | entry data, each entry aligned to ARCHIVE_ALIGNMENT
+const char ARCHIVE_MAGIC[4] = { 'V', 'G', 'E', 'P' };
+const uint32_t ARCHIVE_VERSION = 1;
+const uint64_t ARCHIVE_ALIGNMENT = 64;          // Keeps SPIR-V word aligned and texture blocks cache line aligned
+const char ASSET_ARCHIVE_FILE[] = "Assets.pak"; // Opened by renderer when present, loose files are used otherwise
+
+struct ArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesSize;                         // Bytes of name table after entries
+};
+
+struct ArchiveEntry {
+    uint64_t offset;                            // From start of archive
+    uint64_t size;
+    uint32_t nameOffset;                        // Into name table, names are not null terminated
+    uint32_t nameLength;
+};
+
+// Read-only view of a packed archive mapped into memory.
+// Entries are pointers straight into the mapping - they can be handed to Vulkan or copied into staging without a heap copy.
+// Pointers stay valid until close() or destruction. Lookups are safe from multiple threads.
+class AssetArchive
+{
+public:
+    AssetArchive();
+    AssetArchive(const AssetArchive&) = delete;             // Owns mapping - unmapped by destructor
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    // False if file doesn't exist, throws if it isn't a valid archive (entries out of bounds or not aligned to ARCHIVE_ALIGNMENT)
+    bool open(const std::string& filename);
+    bool isOpen() const;
+
+    // Entry by path relative to asset root, e.g. "Shaders/vert.spv"
+    bool find(const std::string& name, const char** data, size_t* size) const;
+    std::vector<std::string> getNames() const;
+
+    void close();
+
+    ~AssetArchive();
+
+private:
+    const char* base = nullptr;
+    size_t fileSize = 0;
+    const ArchiveEntry* entries = nullptr;
+    uint32_t entryCount = 0;
+    const char* names = nullptr;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    bool mapFile(const std::string& filename);
+    void unmapFile();
+};
@@ -0,0 +1,436 @@
+#include "AssetStreamer.h"
+
+AssetStreamer::AssetStreamer()
+{
+
+}
+
+AssetStreamer::~AssetStreamer()
+{
+
+}
+
+void AssetStreamer::start(MemoryAllocator* allocator, GeometryArena* geometryArena, TextureLoader* textureLoader, VkPhysicalDevice physicalDevice, VkDevice device, QueueFamilyIndices queueFamilyIndices, VkQueue transferQueue, VkQueue graphicsQueue,
+    std::mutex* queueMutex, VkDeviceSize stagingSize)
+{
+    this->allocator = allocator;
+    this->geometryArena = geometryArena;
+    this->textureLoader = textureLoader;
+    this->archive = textureLoader->getArchive();
+    this->device = device;
+
+    // Command pools can't be used by two threads at once - worker gets its own
+    transferCommandPool = createCommandPool(queueFamilyIndices.transferFamily);
+    acquireCommandPool = queueFamilyIndices.separateTransfer() ? createCommandPool(queueFamilyIndices.graphicsFamily) : transferCommandPool;
+
+    stagingRing = StagingRing(allocator, device, transferQueue, transferCommandPool, graphicsQueue, acquireCommandPool, queueMutex, stagingSize);
+    mipGenerator = MipGenerator(physicalDevice, device, archive);
+    uploadBatch = UploadBatch(&stagingRing, &mipGenerator, queueFamilyIndices.transferFamily, queueFamilyIndices.graphicsFamily);
+
+    stopping = false;
+    worker = std::thread(&AssetStreamer::run, this);
+}
+
+AssetHandle AssetStreamer::requestTexture(const std::string& filename, float priority)
+{
+    StreamRequest request;
+    request.priority = priority;
+    request.isTexture = true;
+    request.filename = filename;
+
+    return addRequest(request);
+}
+
+AssetHandle AssetStreamer::requestMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, AssetHandle texture, float priority,
+    VertexLayout vertexLayout)
+{
+    StreamRequest request;
+    request.priority = priority;
+    request.isTexture = false;
+    request.vertices = std::move(vertices);
+    request.indices = std::move(indices);
+    request.vertexLayout = vertexLayout;
+    request.texture = texture;
+
+    return addRequest(request);
+}
+
+AssetHandle AssetStreamer::requestMesh(const std::string& meshFile, uint32_t submesh, AssetHandle texture, float priority)
+{
+    StreamRequest request;
+    request.priority = priority;
+    request.isTexture = false;
+    request.filename = meshFile;
+    request.submesh = submesh;
+    request.texture = texture;
+
+    return addRequest(request);
+}
+
+AssetHandle AssetStreamer::addRequest(StreamRequest& request)
+{
+    AssetHandle handle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        handle = static_cast<AssetHandle>(states.size());
+        states.push_back(AssetState::Queued);
+
+        request.handle = handle;
+        request.sequence = nextSequence++;
+        requests.push_back(std::move(request));
+    }
+
+    condition.notify_one();
+    return handle;
+}
+
+void AssetStreamer::setPriority(AssetHandle handle, float priority)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& request : requests)
+    {
+        if (request.handle == handle)
+        {
+            request.priority = priority;
+            return;
+        }
+    }
+}
+
+bool AssetStreamer::cancel(AssetHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (handle >= states.size())
+    {
+        return false;
+    }
+
+    switch (states[handle])
+    {
+    case AssetState::Queued:
+        // Not picked up yet - just forget request
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            if (requests[i].handle == handle)
+            {
+                requests.erase(requests.begin() + i);
+                break;
+            }
+        }
+        states[handle] = AssetState::Cancelled;
+        return true;
+
+    case AssetState::Loading:
+    case AssetState::Uploading:
+        // Worker checks state and releases asset once it is safe to do so
+        states[handle] = AssetState::Cancelled;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+AssetState AssetStreamer::getState(AssetHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (handle >= states.size())
+    {
+        return AssetState::Failed;
+    }
+
+    return states[handle];
+}
+
+void AssetStreamer::update(std::vector<StreamedTexture>* textures, std::vector<StreamedMesh>* meshes)
+{
+    // Only swaps lists under lock - never waits for worker
+    std::lock_guard<std::mutex> lock(mutex);
+
+    textures->insert(textures->end(), readyTextures.begin(), readyTextures.end());
+    meshes->insert(meshes->end(), readyMeshes.begin(), readyMeshes.end());
+    readyTextures.clear();
+    readyMeshes.clear();
+}
+
+void AssetStreamer::run()
+{
+    while (true)
+    {
+        StreamRequest request;
+        bool hasRequest;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            // Sleep until there is work - while uploads are in flight wake up regularly to check their fences
+            if (inFlight.empty())
+            {
+                condition.wait(lock, [this] { return stopping || !requests.empty(); });
+            }
+            else
+            {
+                condition.wait_for(lock, std::chrono::milliseconds(1), [this] { return stopping || !requests.empty(); });
+            }
+
+            if (stopping)
+            {
+                break;
+            }
+
+            hasRequest = popRequest(&request);
+        }
+
+        completeUploads();
+
+        if (hasRequest)
+        {
+            loadRequest(request);
+        }
+    }
+}
+
+bool AssetStreamer::popRequest(StreamRequest* request)
+{
+    if (requests.empty())
+    {
+        return false;
+    }
+
+    // Most urgent request - lowest priority value, oldest first
+    size_t best = 0;
+    for (size_t i = 1; i < requests.size(); i++)
+    {
+        if (requests[i].priority < requests[best].priority ||
+            (requests[i].priority == requests[best].priority && requests[i].sequence < requests[best].sequence))
+        {
+            best = i;
+        }
+    }
+
+    *request = std::move(requests[best]);
+    requests.erase(requests.begin() + best);
+    states[request->handle] = AssetState::Loading;
+
+    return true;
+}
+
+void AssetStreamer::loadRequest(StreamRequest& request)
+{
+    InFlightUpload upload = {};
+    upload.isTexture = request.isTexture;
+    bool hasGeometry = false;                   // Mesh got its range of geometry arena
+
+    try
+    {
+        if (request.isTexture)
+        {
+            // Read and decode file (or cooked compressed variant)
+            TextureData texture = textureLoader->load(request.filename);
+
+            VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            if (texture.generateMipmaps)
+            {
+                usage |= mipGenerator.getRequiredUsage(texture.format);
+            }
+
+            upload.texture.handle = request.handle;
+            upload.texture.image = createImage(allocator, device, texture.width, texture.height, texture.format, VK_IMAGE_TILING_OPTIMAL, usage,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &upload.texture.memory, texture.mipLevels);
+            upload.texture.info = TextureLoader::getInfo(texture, upload.texture.memory);
+
+            // Stage pixels, record copy and mip generation - image ends up shader readable on graphics queue
+            uploadBatch.uploadTexture(texture, upload.texture.image);
+        }
+        else
+        {
+            // Texture index is filled in by renderer once texture is resident too
+            upload.mesh.handle = request.handle;
+            upload.mesh.texture = request.texture;
+            if (request.filename.empty())
+            {
+                upload.mesh.mesh = Mesh(geometryArena, &uploadBatch, &request.vertices, &request.indices, 0, request.vertexLayout);
+                hasGeometry = true;
+            }
+            else
+            {
+                // Geometry goes from file to staging in ring sized pieces - never held in memory as a whole
+                MeshFile meshFile;
+                meshFile.open(request.filename, archive);
+                uint32_t submesh = request.submesh;
+                if (submesh >= meshFile.getSubmeshCount())
+                {
+                    throw std::runtime_error("Mesh file has no such submesh (" + request.filename + ")!");
+                }
+
+                // Stored already in its vertex layout - uploaded without conversion
+                upload.mesh.mesh = Mesh(geometryArena, &uploadBatch, meshFile.getVertexLayout(submesh), meshFile.getDequantization(submesh),
+                    meshFile.getSubmesh(submesh).vertexCount, [&meshFile, submesh](void* destination, VkDeviceSize offset, VkDeviceSize size)
+                    {
+                        meshFile.readVertices(submesh, offset, destination, size);
+                    },
+                    meshFile.getSubmesh(submesh).indexCount, meshFile.hasShortIndices(submesh) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32, [&meshFile, submesh](void* destination, VkDeviceSize offset, VkDeviceSize size)
+                    {
+                        meshFile.readIndices(submesh, offset, destination, size);
+                    }, 0);
+                hasGeometry = true;
+
+                glm::vec3 boundsMin, boundsMax;
+                memcpy(&boundsMin, meshFile.getSubmesh(submesh).boundsMin, sizeof(boundsMin));
+                memcpy(&boundsMax, meshFile.getSubmesh(submesh).boundsMax, sizeof(boundsMax));
+                upload.mesh.mesh.setBounds(boundsMin, boundsMax);
+                upload.mesh.mesh.setLods(meshFile.getLods(submesh));
+            }
+        }
+
+        upload.token = uploadBatch.submit();
+    }
+    catch (const std::exception& e)
+    {
+        printf("ERROR: %s\n", e.what());
+
+        // Commands of failed request must not go out with next one - once they are dropped (and any part submitted
+        // early finished), nothing uses what request created
+        uploadBatch.discard();
+        if (request.isTexture && upload.texture.image != VK_NULL_HANDLE)
+        {
+            vkDestroyImage(device, upload.texture.image, nullptr);
+            allocator->free(&upload.texture.memory);
+        }
+        else if (!request.isTexture && hasGeometry)
+        {
+            upload.mesh.mesh.freeGeometry();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (states[request.handle] != AssetState::Cancelled)
+        {
+            states[request.handle] = AssetState::Failed;
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (states[request.handle] == AssetState::Loading)
+        {
+            states[request.handle] = AssetState::Uploading;
+        }
+    }
+
+    // Even cancelled asset has to wait for its copies before it can be destroyed
+    inFlight.push_back(upload);
+}
+
+void AssetStreamer::completeUploads()
+{
+    for (size_t i = 0; i < inFlight.size(); )
+    {
+        InFlightUpload& upload = inFlight[i];
+        if (!stagingRing.isComplete(upload.token))
+        {
+            i++;
+            continue;
+        }
+
+        AssetHandle handle = upload.isTexture ? upload.texture.handle : upload.mesh.handle;
+        bool cancelled;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            cancelled = states[handle] == AssetState::Cancelled;
+            if (!cancelled)
+            {
+                states[handle] = AssetState::Resident;
+                if (upload.isTexture)
+                {
+                    readyTextures.push_back(upload.texture);
+                }
+                else
+                {
+                    readyMeshes.push_back(upload.mesh);
+                }
+            }
+        }
+
+        if (cancelled)
+        {
+            destroyUpload(upload);
+        }
+
+        inFlight.erase(inFlight.begin() + i);
+    }
+}
+
+void AssetStreamer::destroyUpload(InFlightUpload& upload)
+{
+    if (upload.isTexture)
+    {
+        vkDestroyImage(device, upload.texture.image, nullptr);
+        allocator->free(&upload.texture.memory);
+    }
+    else
+    {
+        upload.mesh.mesh.freeGeometry();
+    }
+}
+
+VkCommandPool AssetStreamer::createCommandPool(uint32_t queueFamilyIndex)
+{
+    VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;       // Upload command buffers are recorded once and freed
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+    VkCommandPool commandPool;
+    VkResult result = vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a Streaming Command Pool!");
+    }
+
+    return commandPool;
+}
+
+void AssetStreamer::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    worker.join();
+
+    // Worker is gone - finish its uploads here and release everything nobody claimed
+    stagingRing.flush();
+    for (auto& upload : inFlight)
+    {
+        destroyUpload(upload);
+    }
+    inFlight.clear();
+
+    for (auto& texture : readyTextures)
+    {
+        vkDestroyImage(device, texture.image, nullptr);
+        allocator->free(&texture.memory);
+    }
+    readyTextures.clear();
+
+    for (auto& mesh : readyMeshes)
+    {
+        mesh.mesh.freeGeometry();
+    }
+    readyMeshes.clear();
+
+    mipGenerator.destroy();
+    stagingRing.destroy();
+
+    if (acquireCommandPool != transferCommandPool)
+    {
+        vkDestroyCommandPool(device, acquireCommandPool, nullptr);
+    }
+    vkDestroyCommandPool(device, transferCommandPool, nullptr);
+}
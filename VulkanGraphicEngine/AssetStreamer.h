@@ -0,0 +1,133 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "Utilities.h"
+#include "StagingRing.h"
+#include "UploadBatch.h"
+#include "TextureLoader.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+
+typedef uint32_t AssetHandle;
+
+const AssetHandle INVALID_ASSET = UINT32_MAX;  // Never resident - e.g. texture of a mesh drawn without one
+
+enum class AssetState {
+    Queued,         // Waiting for worker thread
+    Loading,        // Worker reads and decodes file, stages data
+    Uploading,      // Copies submitted, waiting for GPU
+    Resident,       // Ready to use - handed over by update()
+    Failed,         // File couldn't be loaded
+    Cancelled       // Cancelled before it became resident
+};
+
+// Texture image uploaded by streamer, shader readable and owned by graphics queue family
+struct StreamedTexture {
+    AssetHandle handle;
+    VkImage image;
+    MemoryAllocation memory;
+    TextureInfo info;
+};
+
+// Mesh uploaded by streamer, texture is handle of streamed texture it is drawn with
+struct StreamedMesh {
+    AssetHandle handle;
+    AssetHandle texture;
+    Mesh mesh;
+};
+
+// Loads assets on a background thread: file is read and decoded, data staged and copied on transfer queue.
+// Requests return handle straight away, finished assets are collected by update() - nothing ever waits for GPU on caller's thread.
+class AssetStreamer
+{
+public:
+    AssetStreamer();
+
+    // Worker owns its own staging ring and command pools, only allocator, geometry arena and queues (through queueMutex) are shared
+    void start(MemoryAllocator* allocator, GeometryArena* geometryArena, TextureLoader* textureLoader, VkPhysicalDevice physicalDevice, VkDevice device, QueueFamilyIndices queueFamilyIndices, VkQueue transferQueue, VkQueue graphicsQueue,
+        std::mutex* queueMutex, VkDeviceSize stagingSize = STAGING_RING_SIZE);
+
+    // Lower priority value is loaded first (e.g. distance to camera), same priorities load in request order
+    AssetHandle requestTexture(const std::string& filename, float priority);
+    AssetHandle requestMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, AssetHandle texture, float priority,
+        VertexLayout vertexLayout = VertexLayout::Standard);
+
+    // Submesh of mesh file - read piece by piece straight into staging memory on worker thread
+    AssetHandle requestMesh(const std::string& meshFile, uint32_t submesh, AssetHandle texture, float priority);
+
+    void setPriority(AssetHandle handle, float priority);   // Only affects requests still queued
+    bool cancel(AssetHandle handle);                        // False if asset is already resident, failed or cancelled
+    AssetState getState(AssetHandle handle);
+
+    // Move assets that became resident since last call to given lists - caller owns them from now on
+    void update(std::vector<StreamedTexture>* textures, std::vector<StreamedMesh>* meshes);
+
+    void destroy();
+
+    ~AssetStreamer();
+
+private:
+    struct StreamRequest {
+        AssetHandle handle;
+        float priority;
+        uint64_t sequence;                      // Request order - breaks priority ties
+        bool isTexture;
+        std::string filename;                   // Texture file, or mesh file when mesh data is empty
+        uint32_t submesh;
+        std::vector<Vertex> vertices;           // Mesh data
+        std::vector<uint32_t> indices;
+        VertexLayout vertexLayout;
+        AssetHandle texture;
+    };
+
+    struct InFlightUpload {
+        UploadToken token;
+        bool isTexture;
+        StreamedTexture texture;
+        StreamedMesh mesh;
+    };
+
+    MemoryAllocator* allocator;
+    GeometryArena* geometryArena;
+    TextureLoader* textureLoader;
+    const AssetArchive* archive;
+    VkDevice device;
+
+    // Worker thread only
+    VkCommandPool transferCommandPool;
+    VkCommandPool acquireCommandPool;           // Graphics family pool for ownership acquire (same as transfer pool without separate transfer family)
+    StagingRing stagingRing;
+    MipGenerator mipGenerator;
+    UploadBatch uploadBatch;
+    std::vector<InFlightUpload> inFlight;
+
+    // Shared with worker - guarded by mutex
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+    uint64_t nextSequence = 0;
+    std::vector<StreamRequest> requests;
+    std::vector<AssetState> states;             // State of every asset, indexed by handle
+    std::vector<StreamedTexture> readyTextures;
+    std::vector<StreamedMesh> readyMeshes;
+
+    void run();
+    bool popRequest(StreamRequest* request);
+    void loadRequest(StreamRequest& request);
+    void completeUploads();
+    void destroyUpload(InFlightUpload& upload);
+
+    AssetHandle addRequest(StreamRequest& request);
+    VkCommandPool createCommandPool(uint32_t queueFamilyIndex);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+#include "Utilities.h"
+
+// Hierarchical depth (HZB) of depth buffer for occlusion culling - every texel of a level holds the farthest depth of all
+// texels it covers in level below, level 0 is half of depth buffer size. Built by a compute shader (depthreduce.comp).
+// Levels stay in GENERAL layout - written as storage images, sampled with texelFetch by culling shader.
+class DepthPyramid
+{
+public:
+    DepthPyramid();
+    DepthPyramid(MemoryAllocator* allocator, VkDevice device, const AssetArchive* archive, VkImage depthImage, VkImageView depthImageView,
+        VkFormat depthFormat, VkExtent2D depthExtent);
+
+    // Depth buffer has to be in DEPTH_STENCIL_ATTACHMENT_OPTIMAL with its contents stored - it is back in that layout afterwards.
+    // Has to be recorded outside of render pass.
+    void build(VkCommandBuffer commandBuffer);
+
+    VkImageView getImageView();                 // All levels
+    VkSampler getSampler();                     // Nearest, clamped
+    VkExtent2D getExtent();                     // Of level 0
+    uint32_t getLevelCount();
+
+    void destroy();
+
+    ~DepthPyramid();
+
+private:
+    MemoryAllocator* allocator;
+    VkDevice device;
+
+    VkImage depthImage;
+    VkImageAspectFlags depthAspect;             // Depth, and stencil for formats having it - barriers need both
+    VkExtent2D extent;
+    uint32_t levelCount;
+    bool initialised = false;                   // Levels were transitioned to GENERAL by an earlier build
+
+    VkImage image;
+    MemoryAllocation imageMemory;
+    VkImageView imageView;
+    std::vector<VkImageView> levelViews;
+    VkSampler sampler;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    std::vector<VkDescriptorSet> descriptorSets;  // Set i writes level i - reads depth buffer (i == 0) or level i - 1
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+
+    void createImage();
+    void createDescriptorSets(VkImageView depthImageView);
+    void createComputePipeline(const AssetArchive* archive);
+};
@@ -0,0 +1,276 @@
+#include "FrustumCuller.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRUSTUM_CULLER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+void BoundingSpheres::clear()
+{
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+}
+
+void BoundingSpheres::add(const glm::vec4& sphere)
+{
+    centerX.push_back(sphere.x);
+    centerY.push_back(sphere.y);
+    centerZ.push_back(sphere.z);
+    radius.push_back(sphere.w);
+}
+
+size_t BoundingSpheres::size() const
+{
+    return radius.size();
+}
+
+FrustumCuller::FrustumCuller()
+{
+    if (isKernelSupported(CullKernel::Avx2))
+    {
+        kernel = CullKernel::Avx2;
+    }
+    else if (isKernelSupported(CullKernel::Sse))
+    {
+        kernel = CullKernel::Sse;
+    }
+}
+
+FrustumCuller::~FrustumCuller()
+{
+
+}
+
+void FrustumCuller::setKernel(CullKernel kernel)
+{
+    while (!isKernelSupported(kernel))
+    {
+        kernel = static_cast<CullKernel>(static_cast<uint32_t>(kernel) - 1);
+    }
+    this->kernel = kernel;
+}
+
+CullKernel FrustumCuller::getKernel()
+{
+    return kernel;
+}
+
+void FrustumCuller::cull(const BoundingSpheres& spheres, const glm::vec4 planes[6], std::vector<uint32_t>* visible)
+{
+    // Kernels write an index for every sphere and only advance past visible ones - room for all of them
+    visible->resize(spheres.size());
+
+    uint32_t count = 0;
+    size_t end = 0;
+    if (kernel == CullKernel::Avx2)
+    {
+        count = cullAvx2(spheres, planes, visible->data(), &end);
+    }
+    else if (kernel == CullKernel::Sse)
+    {
+        count = cullSse(spheres, planes, visible->data(), &end);
+    }
+
+    // Spheres left after last full group
+    count += cullScalar(spheres, end, planes, visible->data() + count);
+    visible->resize(count);
+}
+
+bool FrustumCuller::isKernelSupported(CullKernel kernel)
+{
+    switch (kernel)
+    {
+    case CullKernel::Scalar:
+        return true;
+
+#ifdef FRUSTUM_CULLER_X86
+    case CullKernel::Sse:
+        // Part of every x64 CPU
+        return true;
+
+    case CullKernel::Avx2:
+    {
+#if defined(_MSC_VER)
+        // CPU has AVX2 and OS saves YMM registers (OSXSAVE, XCR0 bits 1 and 2)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+#endif
+
+    default:
+        return false;
+    }
+}
+
+const char* FrustumCuller::getKernelName(CullKernel kernel)
+{
+    switch (kernel)
+    {
+    case CullKernel::Sse:   return "SSE";
+    case CullKernel::Avx2:  return "AVX2";
+    default:                return "scalar";
+    }
+}
+
+void FrustumCuller::getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+    // Rows of matrix (GLM is column major) - clip space point is inside when -w <= x, y <= w and 0 <= z <= w
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    planes[0] = rows[3] + rows[0];      // Left
+    planes[1] = rows[3] - rows[0];      // Right
+    planes[2] = rows[3] + rows[1];      // Bottom (top with flipped Y)
+    planes[3] = rows[3] - rows[1];      // Top
+    planes[4] = rows[2];                // Near
+    planes[5] = rows[3] - rows[2];      // Far
+
+    // Unit normals - plane distance is then in world units, comparable with sphere radius
+    for (int i = 0; i < 6; i++)
+    {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+uint32_t FrustumCuller::cullScalar(const BoundingSpheres& spheres, size_t begin, const glm::vec4 planes[6], uint32_t* visible)
+{
+    uint32_t count = 0;
+    for (size_t i = begin; i < spheres.size(); i++)
+    {
+        bool outside = false;
+        for (int p = 0; p < 6; p++)
+        {
+            float distance = planes[p].x * spheres.centerX[i] + planes[p].y * spheres.centerY[i] + planes[p].z * spheres.centerZ[i] + planes[p].w;
+            outside |= distance < -spheres.radius[i];
+        }
+
+        // Index is always written, count only moves on when sphere is visible - no branch on result
+        visible[count] = static_cast<uint32_t>(i);
+        count += outside ? 0 : 1;
+    }
+
+    return count;
+}
+
+#ifdef FRUSTUM_CULLER_X86
+
+uint32_t FrustumCuller::cullSse(const BoundingSpheres& spheres, const glm::vec4 planes[6], uint32_t* visible, size_t* end)
+{
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+    }
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    uint32_t count = 0;
+    size_t groupEnd = spheres.size() / 4 * 4;
+    for (size_t i = 0; i < groupEnd; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&spheres.centerX[i]);
+        __m128 y = _mm_loadu_ps(&spheres.centerY[i]);
+        __m128 z = _mm_loadu_ps(&spheres.centerZ[i]);
+        __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(&spheres.radius[i]), signBit);
+
+        // Same operation order as scalar kernel - ((x * px + y * py) + z * pz) + pw
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_mul_ps(planeZ[p], z)), planeW[p]);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+        }
+
+        int visibleMask = ~_mm_movemask_ps(outside);
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            visible[count] = static_cast<uint32_t>(i + j);
+            count += (visibleMask >> j) & 1;
+        }
+    }
+
+    *end = groupEnd;
+    return count;
+}
+
+AVX2_FUNCTION uint32_t FrustumCuller::cullAvx2(const BoundingSpheres& spheres, const glm::vec4 planes[6], uint32_t* visible, size_t* end)
+{
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX[p] = _mm256_set1_ps(planes[p].x);
+        planeY[p] = _mm256_set1_ps(planes[p].y);
+        planeZ[p] = _mm256_set1_ps(planes[p].z);
+        planeW[p] = _mm256_set1_ps(planes[p].w);
+    }
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    uint32_t count = 0;
+    size_t groupEnd = spheres.size() / 8 * 8;
+    for (size_t i = 0; i < groupEnd; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(&spheres.centerX[i]);
+        __m256 y = _mm256_loadu_ps(&spheres.centerY[i]);
+        __m256 z = _mm256_loadu_ps(&spheres.centerZ[i]);
+        __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(&spheres.radius[i]), signBit);
+
+        // No fused multiply-add - it would round differently from scalar kernel
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                _mm256_mul_ps(planeZ[p], z)), planeW[p]);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negRadius, _CMP_LT_OQ));
+        }
+
+        int visibleMask = ~_mm256_movemask_ps(outside);
+        for (uint32_t j = 0; j < 8; j++)
+        {
+            visible[count] = static_cast<uint32_t>(i + j);
+            count += (visibleMask >> j) & 1;
+        }
+    }
+
+    *end = groupEnd;
+    return count;
+}
+
+#else
+
+uint32_t FrustumCuller::cullSse(const BoundingSpheres&, const glm::vec4[6], uint32_t*, size_t* end)
+{
+    *end = 0;
+    return 0;
+}
+
+uint32_t FrustumCuller::cullAvx2(const BoundingSpheres&, const glm::vec4[6], uint32_t*, size_t* end)
+{
+    *end = 0;
+    return 0;
+}
+
+#endif
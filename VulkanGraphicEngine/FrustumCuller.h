@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+struct CullStats {
+    uint32_t totalObjects = 0;
+    uint32_t visibleObjects = 0;
+    uint32_t occludedObjects = 0;               // Inside frustum, hidden behind depth of the frame (occlusion culling only)
+    uint32_t disoccludedObjects = 0;            // Hidden by previous frame's depth, visible in this one - part of visibleObjects
+};
+
+// Bounding spheres in structure of arrays layout - every component in its own array, so SIMD kernels load 4 / 8 objects at once
+struct BoundingSpheres {
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+
+    void clear();
+    void add(const glm::vec4& sphere);          // Center xyz, radius w
+    size_t size() const;
+};
+
+// Instruction set of culling kernel - Sse tests 4 spheres per instruction, Avx2 8, Scalar one
+enum class CullKernel : uint32_t {
+    Scalar = 0,
+    Sse = 1,
+    Avx2 = 2
+};
+
+// Frustum culling of bounding spheres on CPU. Every kernel gives exactly the same result - the plane distance is computed
+// in the same order (and rounding) in all of them. Kernel the CPU doesn't support falls back to the best one it does.
+class FrustumCuller
+{
+public:
+    FrustumCuller();                            // Best kernel of CPU
+
+    void setKernel(CullKernel kernel);
+    CullKernel getKernel();
+
+    // Indices of spheres intersecting frustum, ascending - visible is resized to their count
+    void cull(const BoundingSpheres& spheres, const glm::vec4 planes[6], std::vector<uint32_t>* visible);
+
+    static bool isKernelSupported(CullKernel kernel);
+    static const char* getKernelName(CullKernel kernel);
+
+    // Normalised planes (inside - dot(plane.xyz, point) + plane.w >= 0) of Vulkan clip volume (depth 0 to 1)
+    static void getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+    ~FrustumCuller();
+
+private:
+    CullKernel kernel = CullKernel::Scalar;
+
+    // Kernels write visible indices of spheres [begin, size) to visible, return their count
+    static uint32_t cullScalar(const BoundingSpheres& spheres, size_t begin, const glm::vec4 planes[6], uint32_t* visible);
+    static uint32_t cullSse(const BoundingSpheres& spheres, const glm::vec4 planes[6], uint32_t* visible, size_t* end);
+    static uint32_t cullAvx2(const BoundingSpheres& spheres, const glm::vec4 planes[6], uint32_t* visible, size_t* end);
+};
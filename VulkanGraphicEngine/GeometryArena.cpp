@@ -0,0 +1,311 @@
+#include "GeometryArena.h"
+
+GeometryArena::GeometryArena()
+{
+
+}
+
+GeometryArena::~GeometryArena()
+{
+
+}
+
+GeometryArena::GeometryArena(MemoryAllocator* allocator, VkDevice device, VkQueue graphicsQueue, VkCommandPool graphicsCommandPool, std::mutex* queueMutex,
+    VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity)
+{
+    this->allocator = allocator;
+    this->device = device;
+    this->graphicsQueue = graphicsQueue;
+    this->graphicsCommandPool = graphicsCommandPool;
+    this->queueMutex = queueMutex;
+    this->vertexCapacity = vertexCapacity;
+    this->indexCapacity = indexCapacity;
+    mutex = std::make_shared<std::mutex>();
+
+    // TRANSFER_SRC - compaction copies geometry inside its own buffer
+    createBuffer(allocator, device, vertexCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertexBuffer, &vertexBufferMemory);
+    createBuffer(allocator, device, indexCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indexBuffer, &indexBufferMemory);
+
+    vertexFreeRanges.push_back({ 0, vertexCapacity });
+    indexFreeRanges.push_back({ 0, indexCapacity });
+}
+
+GeometryAllocation GeometryArena::allocate(VkDeviceSize vertexSize, VkDeviceSize indexSize)
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    // Sizes are rounded up to alignment - no padding holes are left between neighbours, so compaction closes every gap
+    GeometryAllocation allocation;
+    vertexSize = (vertexSize + GEOMETRY_VERTEX_ALIGNMENT - 1) / GEOMETRY_VERTEX_ALIGNMENT * GEOMETRY_VERTEX_ALIGNMENT;
+    indexSize = (indexSize + GEOMETRY_INDEX_ALIGNMENT - 1) / GEOMETRY_INDEX_ALIGNMENT * GEOMETRY_INDEX_ALIGNMENT;
+    allocation.vertexSize = vertexSize;
+    allocation.indexSize = indexSize;
+
+    if (vertexSize > 0 && !allocateRange(&vertexFreeRanges, vertexSize, GEOMETRY_VERTEX_ALIGNMENT, &allocation.vertexOffset))
+    {
+        throw std::runtime_error("Geometry arena has no space left for vertex data!");
+    }
+    if (indexSize > 0 && !allocateRange(&indexFreeRanges, indexSize, GEOMETRY_INDEX_ALIGNMENT, &allocation.indexOffset))
+    {
+        if (vertexSize > 0)
+        {
+            freeRange(&vertexFreeRanges, allocation.vertexOffset, vertexSize);
+        }
+        throw std::runtime_error("Geometry arena has no space left for index data!");
+    }
+
+    allocationCount++;
+    return allocation;
+}
+
+void GeometryArena::free(GeometryAllocation* allocation)
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    if (allocation->vertexSize > 0)
+    {
+        freeRange(&vertexFreeRanges, allocation->vertexOffset, allocation->vertexSize);
+    }
+    if (allocation->indexSize > 0)
+    {
+        freeRange(&indexFreeRanges, allocation->indexOffset, allocation->indexSize);
+    }
+
+    allocationCount--;
+    *allocation = GeometryAllocation();
+}
+
+VkDeviceSize GeometryArena::compact(const std::vector<GeometryAllocation*>& allocations)
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    // Lowest allocation first - each one is released and allocated again, first fit never puts it higher than it was
+    std::vector<GeometryMove> moves;
+    std::vector<GeometryAllocation*> sorted = allocations;
+
+    std::sort(sorted.begin(), sorted.end(), [](const GeometryAllocation* a, const GeometryAllocation* b) { return a->vertexOffset < b->vertexOffset; });
+    for (GeometryAllocation* allocation : sorted)
+    {
+        if (allocation->vertexSize == 0)
+        {
+            continue;
+        }
+
+        VkDeviceSize offset;
+        freeRange(&vertexFreeRanges, allocation->vertexOffset, allocation->vertexSize);
+        allocateRange(&vertexFreeRanges, allocation->vertexSize, GEOMETRY_VERTEX_ALIGNMENT, &offset);
+        if (offset != allocation->vertexOffset)
+        {
+            moves.push_back({ vertexBuffer, allocation->vertexOffset, offset, allocation->vertexSize });
+            allocation->vertexOffset = offset;
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const GeometryAllocation* a, const GeometryAllocation* b) { return a->indexOffset < b->indexOffset; });
+    for (GeometryAllocation* allocation : sorted)
+    {
+        if (allocation->indexSize == 0)
+        {
+            continue;
+        }
+
+        VkDeviceSize offset;
+        freeRange(&indexFreeRanges, allocation->indexOffset, allocation->indexSize);
+        allocateRange(&indexFreeRanges, allocation->indexSize, GEOMETRY_INDEX_ALIGNMENT, &offset);
+        if (offset != allocation->indexOffset)
+        {
+            moves.push_back({ indexBuffer, allocation->indexOffset, offset, allocation->indexSize });
+            allocation->indexOffset = offset;
+        }
+    }
+
+    if (moves.empty())
+    {
+        return 0;
+    }
+
+    VkCommandBuffer commandBuffer = beginCommandBuffer(device, graphicsCommandPool);
+
+    VkDeviceSize movedBytes = 0;
+    for (const auto& move : moves)
+    {
+        recordMove(commandBuffer, move);
+        movedBytes += move.size;
+    }
+
+    // Moved geometry is read by draws submitted later
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    {
+        std::lock_guard<std::mutex> queueLock(*queueMutex);
+        VkResult result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit geometry compaction!");
+        }
+        vkQueueWaitIdle(graphicsQueue);
+    }
+
+    vkFreeCommandBuffers(device, graphicsCommandPool, 1, &commandBuffer);
+
+    return movedBytes;
+}
+
+void GeometryArena::recordMove(VkCommandBuffer commandBuffer, const GeometryMove& move)
+{
+    // Regions of a copy must not overlap - a range moving by less than its size is copied in pieces of the distance,
+    // each piece waits until previous one read what it is going to overwrite
+    VkDeviceSize pieceSize = std::min(move.srcOffset - move.dstOffset, move.size);
+
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    for (VkDeviceSize copied = 0; copied < move.size; copied += pieceSize)
+    {
+        VkBufferCopy copyRegion = {};
+        copyRegion.srcOffset = move.srcOffset + copied;
+        copyRegion.dstOffset = move.dstOffset + copied;
+        copyRegion.size = std::min(pieceSize, move.size - copied);
+        vkCmdCopyBuffer(commandBuffer, move.buffer, move.buffer, 1, &copyRegion);
+
+        // Also keeps later moves from overwriting ranges this one still reads
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+}
+
+VkBuffer GeometryArena::getVertexBuffer()
+{
+    return vertexBuffer;
+}
+
+VkBuffer GeometryArena::getIndexBuffer()
+{
+    return indexBuffer;
+}
+
+GeometryArenaStats GeometryArena::getStats()
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    GeometryArenaStats stats;
+    stats.allocationCount = allocationCount;
+    stats.vertexCapacity = vertexCapacity;
+    stats.indexCapacity = indexCapacity;
+
+    VkDeviceSize largestVertexRange, largestIndexRange;
+    VkDeviceSize freeVertexBytes = getFreeBytes(vertexFreeRanges, &largestVertexRange);
+    VkDeviceSize freeIndexBytes = getFreeBytes(indexFreeRanges, &largestIndexRange);
+    stats.vertexBytes = vertexCapacity - freeVertexBytes;
+    stats.indexBytes = indexCapacity - freeIndexBytes;
+
+    if (freeVertexBytes > 0)
+    {
+        stats.fragmentation = 1.0f - static_cast<float>(largestVertexRange) / static_cast<float>(freeVertexBytes);
+    }
+    if (freeIndexBytes > 0)
+    {
+        stats.fragmentation = std::max(stats.fragmentation, 1.0f - static_cast<float>(largestIndexRange) / static_cast<float>(freeIndexBytes));
+    }
+
+    return stats;
+}
+
+void GeometryArena::destroy()
+{
+    vkDestroyBuffer(device, vertexBuffer, nullptr);
+    allocator->free(&vertexBufferMemory);
+    vkDestroyBuffer(device, indexBuffer, nullptr);
+    allocator->free(&indexBufferMemory);
+}
+
+bool GeometryArena::allocateRange(std::vector<FreeRange>* freeRanges, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+{
+    // First fit - keeps geometry packed towards start of buffer
+    for (size_t i = 0; i < freeRanges->size(); i++)
+    {
+        FreeRange& range = (*freeRanges)[i];
+        VkDeviceSize alignedOffset = (range.offset + alignment - 1) / alignment * alignment;
+        VkDeviceSize padding = alignedOffset - range.offset;
+        if (padding + size > range.size)
+        {
+            continue;
+        }
+
+        // Alignment padding stays free in front, rest of range after allocation
+        FreeRange tail = { alignedOffset + size, range.size - padding - size };
+        if (padding > 0)
+        {
+            range.size = padding;
+            if (tail.size > 0)
+            {
+                freeRanges->insert(freeRanges->begin() + i + 1, tail);
+            }
+        }
+        else if (tail.size > 0)
+        {
+            range = tail;
+        }
+        else
+        {
+            freeRanges->erase(freeRanges->begin() + i);
+        }
+
+        *offset = alignedOffset;
+        return true;
+    }
+
+    return false;
+}
+
+void GeometryArena::freeRange(std::vector<FreeRange>* freeRanges, VkDeviceSize offset, VkDeviceSize size)
+{
+    // Keep free ranges sorted and merged with neighbours
+    auto next = std::lower_bound(freeRanges->begin(), freeRanges->end(), offset,
+        [](const FreeRange& range, VkDeviceSize value) { return range.offset < value; });
+    auto inserted = freeRanges->insert(next, { offset, size });
+
+    auto following = inserted + 1;
+    if (following != freeRanges->end() && inserted->offset + inserted->size == following->offset)
+    {
+        inserted->size += following->size;
+        inserted = freeRanges->erase(following) - 1;
+    }
+
+    if (inserted != freeRanges->begin())
+    {
+        auto previous = inserted - 1;
+        if (previous->offset + previous->size == inserted->offset)
+        {
+            previous->size += inserted->size;
+            freeRanges->erase(inserted);
+        }
+    }
+}
+
+VkDeviceSize GeometryArena::getFreeBytes(const std::vector<FreeRange>& freeRanges, VkDeviceSize* largestRange)
+{
+    VkDeviceSize freeBytes = 0;
+    *largestRange = 0;
+    for (const auto& range : freeRanges)
+    {
+        freeBytes += range.size;
+        *largestRange = std::max(*largestRange, range.size);
+    }
+
+    return freeBytes;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+
+#include "Utilities.h"
+
+const VkDeviceSize GEOMETRY_VERTEX_ARENA_SIZE = 128 * 1024 * 1024;     // Vertex data of all meshes
+const VkDeviceSize GEOMETRY_INDEX_ARENA_SIZE = 64 * 1024 * 1024;       // Index data of all meshes
+const VkDeviceSize GEOMETRY_VERTEX_ALIGNMENT = 32;                      // Multiple of stride of every vertex layout - a range starts at a whole vertex of its layout
+const VkDeviceSize GEOMETRY_INDEX_ALIGNMENT = 4;                        // Whole index of either index type
+
+// Vertex and index data of one mesh inside geometry arena - byte offsets into shared buffers, sizes include alignment padding
+struct GeometryAllocation {
+    VkDeviceSize vertexOffset = 0;
+    VkDeviceSize vertexSize = 0;
+    VkDeviceSize indexOffset = 0;
+    VkDeviceSize indexSize = 0;
+};
+
+struct GeometryArenaStats {
+    uint32_t allocationCount = 0;
+    VkDeviceSize vertexBytes = 0;               // Handed out to meshes
+    VkDeviceSize vertexCapacity = 0;
+    VkDeviceSize indexBytes = 0;
+    VkDeviceSize indexCapacity = 0;
+    float fragmentation = 0.0f;                 // 0 - free space of each buffer is contiguous, close to 1 - scattered in small ranges
+};
+
+// Geometry of every mesh lives in one device local vertex buffer and one index buffer, so they are bound once per frame
+// and meshes are just ranges drawn with vertexOffset / firstIndex.
+// Freed ranges merge with free neighbours, compact() slides geometry towards start of buffers to close gaps left behind.
+// allocate and free are safe to use from multiple threads (streaming thread creates meshes).
+class GeometryArena
+{
+public:
+    GeometryArena();
+    GeometryArena(MemoryAllocator* allocator, VkDevice device, VkQueue graphicsQueue, VkCommandPool graphicsCommandPool, std::mutex* queueMutex,
+        VkDeviceSize vertexCapacity = GEOMETRY_VERTEX_ARENA_SIZE, VkDeviceSize indexCapacity = GEOMETRY_INDEX_ARENA_SIZE);
+
+    // Throws if either buffer has no free range big enough
+    GeometryAllocation allocate(VkDeviceSize vertexSize, VkDeviceSize indexSize);
+    void free(GeometryAllocation* allocation);
+
+    // Moves given allocations as close to start of buffers as free space allows and updates them in place - allocations not given
+    // (e.g. uploads still in flight) stay where they are. GPU must not be using moved geometry - caller waits for device idle.
+    // Copies run on graphics queue and are finished on return. Returns number of bytes moved.
+    VkDeviceSize compact(const std::vector<GeometryAllocation*>& allocations);
+
+    VkBuffer getVertexBuffer();
+    VkBuffer getIndexBuffer();
+    GeometryArenaStats getStats();
+
+    void destroy();
+
+    ~GeometryArena();
+
+private:
+    // Free part of buffer, sorted by offset and merged with neighbours when released
+    struct FreeRange {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    // Copy of a range to lower offset in same buffer
+    struct GeometryMove {
+        VkBuffer buffer;
+        VkDeviceSize srcOffset;
+        VkDeviceSize dstOffset;
+        VkDeviceSize size;
+    };
+
+    MemoryAllocator* allocator;
+    VkDevice device;
+    VkQueue graphicsQueue;
+    VkCommandPool graphicsCommandPool;
+    std::mutex* queueMutex;                     // Graphics queue is shared with streaming thread
+
+    VkBuffer vertexBuffer;
+    MemoryAllocation vertexBufferMemory;
+    VkDeviceSize vertexCapacity;
+    std::vector<FreeRange> vertexFreeRanges;
+
+    VkBuffer indexBuffer;
+    MemoryAllocation indexBufferMemory;
+    VkDeviceSize indexCapacity;
+    std::vector<FreeRange> indexFreeRanges;
+
+    uint32_t allocationCount = 0;
+
+    std::shared_ptr<std::mutex> mutex;          // Shared, so arena can still be assigned like other renderer parts
+
+    static bool allocateRange(std::vector<FreeRange>* freeRanges, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset);
+    static void freeRange(std::vector<FreeRange>* freeRanges, VkDeviceSize offset, VkDeviceSize size);
+    static VkDeviceSize getFreeBytes(const std::vector<FreeRange>& freeRanges, VkDeviceSize* largestRange);
+
+    void recordMove(VkCommandBuffer commandBuffer, const GeometryMove& move);
+};
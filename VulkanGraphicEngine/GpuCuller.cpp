@@ -0,0 +1,322 @@
+#include "GpuCuller.h"
+
+GpuCuller::GpuCuller()
+{
+
+}
+
+GpuCuller::~GpuCuller()
+{
+
+}
+
+GpuCuller::GpuCuller(MemoryAllocator* allocator, VkDevice device, const AssetArchive* archive, UniformRing* uniformRing, UniformRing* objectRing,
+    UniformRing* indirectRing, DepthPyramid* depthPyramid)
+{
+    this->device = device;
+    this->uniformRing = uniformRing;
+    this->indirectRing = indirectRing;
+    this->depthPyramid = depthPyramid;
+
+    // Every object drawn in a frame may be a candidate - and may be found occluded (count and index of each after candidates)
+    cullRing = UniformRing(allocator, device, sizeof(CullObject), MAX_INSTANCES * (sizeof(CullObject) + sizeof(uint32_t)) + 2 * sizeof(CullObject),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+    createDescriptorSet(objectRing);
+    createComputePipeline(archive);
+}
+
+void GpuCuller::beginFrame(int frame)
+{
+    currentFrame = frame;
+    cullRing.beginFrame(frame);
+
+    PendingCounts& pending = pendingCounts[frame];
+    if (pending.counts.empty())
+    {
+        return;
+    }
+
+    stats = CullStats();
+    stats.totalObjects = pending.totalObjects;
+    for (const uint32_t* count : pending.counts)
+    {
+        stats.visibleObjects += *count;
+    }
+    for (const uint32_t* count : pending.lateCounts)
+    {
+        stats.disoccludedObjects += *count;
+    }
+    stats.visibleObjects += stats.disoccludedObjects;
+    stats.occludedObjects = pending.occludedCount ? *pending.occludedCount - stats.disoccludedObjects : 0;
+    pending = PendingCounts();
+}
+
+void GpuCuller::add(uint32_t list, const CullObject& object)
+{
+    candidates[list].push_back(object);
+}
+
+std::array<CullDrawList, CULL_DRAW_LISTS> GpuCuller::record(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection, bool occlusion)
+{
+    std::array<CullDrawList, CULL_DRAW_LISTS> drawLists = {};
+    lateDrawLists = {};
+    lateParams = CullParams();
+    this->viewProjection = viewProjection;
+
+    CullParams params = {};
+    FrustumCuller::getFrustumPlanes(viewProjection, params.planes);
+
+    std::array<uint32_t, CULL_DRAW_LISTS> listSizes;
+    uint32_t objectCount = 0;
+    for (uint32_t i = 0; i < CULL_DRAW_LISTS; i++)
+    {
+        listSizes[i] = static_cast<uint32_t>(candidates[i].size());
+        objectCount += listSizes[i];
+    }
+    if (objectCount == 0)
+    {
+        return drawLists;
+    }
+
+    // Candidates of all lists one after another, every list gets room for all of its candidates in indirect ring
+    uint32_t cullOffset;
+    CullObject* cullObjects = static_cast<CullObject*>(cullRing.allocate(objectCount * sizeof(CullObject), &cullOffset));
+    params.firstObject = static_cast<uint32_t>(cullOffset / sizeof(CullObject));
+    params.objectCount = objectCount;
+
+    uint32_t listEnd = 0;
+    for (uint32_t i = 0; i < CULL_DRAW_LISTS; i++)
+    {
+        memcpy(cullObjects + listEnd, candidates[i].data(), listSizes[i] * sizeof(CullObject));
+        listEnd += listSizes[i];
+        params.listEnds[i] = listEnd;
+        candidates[i].clear();
+    }
+
+    PendingCounts& pending = pendingCounts[currentFrame];
+    pending.totalObjects = objectCount;
+    allocateDrawLists(listSizes, &drawLists, &params, &pending.counts);
+
+    // Pyramid of an earlier frame is only a guess of what occludes - late phase tests what it hid against depth of this frame
+    if (occlusion && pyramidBuilt)
+    {
+        uint32_t retestOffset;
+        uint32_t* retest = static_cast<uint32_t*>(cullRing.allocate((objectCount + 1) * sizeof(uint32_t), &retestOffset));
+        retest[0] = 0;
+        pending.occludedCount = retest;
+
+        params.pyramidViewProjection = pyramidViewProjection;
+        params.pyramidSize = glm::vec2(static_cast<float>(depthPyramid->getExtent().width), static_cast<float>(depthPyramid->getExtent().height));
+        params.retestOffset = retestOffset / sizeof(uint32_t);
+        params.occlusion = 1;
+
+        // Any candidate may turn out disoccluded
+        lateParams = params;
+        lateParams.phase = 1;
+        lateParams.pyramidViewProjection = viewProjection;
+        allocateDrawLists(listSizes, &lateDrawLists, &lateParams, &pending.lateCounts);
+    }
+
+    dispatch(commandBuffer, params);
+
+    return drawLists;
+}
+
+std::array<CullDrawList, CULL_DRAW_LISTS> GpuCuller::recordLate(VkCommandBuffer commandBuffer)
+{
+    // Pyramid now holds depth of this frame - next frame's early phase reprojects it by this view-projection
+    pyramidViewProjection = viewProjection;
+    pyramidBuilt = true;
+
+    if (lateParams.objectCount > 0)
+    {
+        dispatch(commandBuffer, lateParams);
+    }
+
+    return lateDrawLists;
+}
+
+CullStats GpuCuller::getStats()
+{
+    return stats;
+}
+
+void GpuCuller::allocateDrawLists(const std::array<uint32_t, CULL_DRAW_LISTS>& listSizes, std::array<CullDrawList, CULL_DRAW_LISTS>* drawLists,
+    CullParams* params, std::vector<const uint32_t*>* counts)
+{
+    for (uint32_t i = 0; i < CULL_DRAW_LISTS; i++)
+    {
+        if (listSizes[i] == 0)
+        {
+            continue;
+        }
+
+        uint32_t commandOffset;
+        indirectRing->allocate(listSizes[i] * sizeof(VkDrawIndexedIndirectCommand), &commandOffset);
+
+        // Count starts at zero - memory is host coherent, write is visible to dispatch once frame is submitted
+        uint32_t countOffset;
+        uint32_t* count = static_cast<uint32_t*>(indirectRing->allocate(sizeof(uint32_t), &countOffset));
+        *count = 0;
+        counts->push_back(count);
+
+        (*drawLists)[i].commandOffset = commandOffset;
+        (*drawLists)[i].countOffset = countOffset;
+        (*drawLists)[i].maxDrawCount = listSizes[i];
+        params->commandOffsets[i] = commandOffset / sizeof(uint32_t);
+        params->countOffsets[i] = countOffset / sizeof(uint32_t);
+    }
+}
+
+void GpuCuller::dispatch(VkCommandBuffer commandBuffer, const CullParams& params)
+{
+    uint32_t paramsOffset = uniformRing->push(params);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 1, &paramsOffset);
+    vkCmdDispatch(commandBuffer, (params.objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // Commands and counts are read by indirect draws of this frame and by host once frame's fence signals,
+    // occluded objects by late phase
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::destroy()
+{
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    cullRing.destroy();
+}
+
+void GpuCuller::createDescriptorSet(UniformRing* objectRing)
+{
+    // Binding 0 : cull params (dynamic offset in uniform ring), 1 : candidates, 2 : objects, 3 : indirect ring (commands and counts),
+    // 4 : cull ring again (occluded objects), 5 : depth pyramid
+    std::array<VkDescriptorSetLayoutBinding, 6> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutCreateInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Culling Descriptor Set Layout!");
+    }
+
+    std::array<VkDescriptorPoolSize, 3> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSizes[0].descriptorCount = 1;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = 4;
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[2].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolCreateInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Culling Descriptor Pool!");
+    }
+
+    VkDescriptorSetAllocateInfo setAllocInfo = {};
+    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocInfo.descriptorPool = descriptorPool;
+    setAllocInfo.descriptorSetCount = 1;
+    setAllocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device, &setAllocInfo, &descriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate Culling Descriptor Set!");
+    }
+
+    // Whole rings - frames are told apart by offsets in cull params
+    std::array<VkDescriptorBufferInfo, 5> bufferInfos = {};
+    bufferInfos[0].buffer = uniformRing->getBuffer();
+    bufferInfos[0].range = sizeof(CullParams);
+    bufferInfos[1].buffer = cullRing.getBuffer();
+    bufferInfos[1].range = VK_WHOLE_SIZE;
+    bufferInfos[2].buffer = objectRing->getBuffer();
+    bufferInfos[2].range = VK_WHOLE_SIZE;
+    bufferInfos[3].buffer = indirectRing->getBuffer();
+    bufferInfos[3].range = VK_WHOLE_SIZE;
+    bufferInfos[4].buffer = cullRing.getBuffer();
+    bufferInfos[4].range = VK_WHOLE_SIZE;
+
+    // Pyramid stays in GENERAL layout
+    VkDescriptorImageInfo pyramidInfo = {};
+    pyramidInfo.sampler = depthPyramid->getSampler();
+    pyramidInfo.imageView = depthPyramid->getImageView();
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::array<VkWriteDescriptorSet, 6> descriptorWrites = {};
+    for (uint32_t i = 0; i < descriptorWrites.size(); i++)
+    {
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = descriptorSet;
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].dstArrayElement = 0;
+        descriptorWrites[i].descriptorType = bindings[i].descriptorType;
+        descriptorWrites[i].descriptorCount = 1;
+        if (i < bufferInfos.size())
+        {
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+        }
+    }
+    descriptorWrites[5].pImageInfo = &pyramidInfo;
+
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+}
+
+void GpuCuller::createComputePipeline(const AssetArchive* archive)
+{
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Culling Pipeline Layout!");
+    }
+
+    VkShaderModule computeShaderModule = loadShaderModule(device, archive, "Shaders/cull.spv");
+
+    VkComputePipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineCreateInfo.stage.module = computeShaderModule;
+    pipelineCreateInfo.stage.pName = "main";
+    pipelineCreateInfo.layout = pipelineLayout;
+
+    VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+    vkDestroyShaderModule(device, computeShaderModule, nullptr);
+
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Culling Pipeline!");
+    }
+}
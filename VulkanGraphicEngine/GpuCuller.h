@@ -0,0 +1,125 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <stdexcept>
+#include <vector>
+#include <array>
+
+#include "Utilities.h"
+#include "UniformRing.h"
+#include "FrustumCuller.h"
+#include "DepthPyramid.h"
+
+const uint32_t CULL_DRAW_LISTS = 4;             // Indirect calls culled draws are split into - one per pipeline / index type (uvec4 in cull.comp)
+const uint32_t CULL_GROUP_SIZE = 64;            // local_size_x of cull.comp
+
+// Candidate draw of a single object - element of cull object ring, layout matches CullObject in cull.comp (std430)
+struct CullObject {
+    glm::vec4 sphere;                           // Bounding sphere in space of stored positions - object's model (with dequantization) takes it to world
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t objectIndex;                       // Element of object storage buffer - firstInstance of draw
+};
+
+// Where culled commands of one list are in indirect ring
+struct CullDrawList {
+    VkDeviceSize commandOffset = 0;
+    VkDeviceSize countOffset = 0;
+    uint32_t maxDrawCount = 0;                  // Candidates of list - 0 if list is empty
+};
+
+// Frustum and occlusion culling on GPU - candidate objects are tested against frustum planes by a compute shader, which appends
+// indirect draw commands of visible ones into indirect ring and counts them with atomics. Counts stay in host visible memory,
+// so they are read back once frame's fence was waited on.
+// Occlusion culling has two phases. Early phase tests objects against depth pyramid of previous frame (reprojected by its
+// view-projection) and draws visible ones. Objects it found occluded are tested again by late phase, against pyramid built
+// from depth of early draws - the ones that became visible (disoccluded) this frame are drawn then.
+class GpuCuller
+{
+public:
+    GpuCuller();
+    GpuCuller(MemoryAllocator* allocator, VkDevice device, const AssetArchive* archive, UniformRing* uniformRing, UniformRing* objectRing,
+        UniformRing* indirectRing, DepthPyramid* depthPyramid);
+
+    // Reads back visible counts of frame that last used this frame's regions - its fence has to be waited on
+    void beginFrame(int frame);
+
+    // Candidate for draw list - objects of one list have to share pipeline and index type
+    void add(uint32_t list, const CullObject& object);
+
+    // Writes candidates, records culling dispatch (outside of render pass) and barrier for indirect draws reading its output
+    // occlusion - occluded objects are left for late phase, depth pyramid then has to be built and recordLate called this frame
+    std::array<CullDrawList, CULL_DRAW_LISTS> record(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection, bool occlusion);
+
+    // Late phase - depth pyramid was just built from depth of early draws. Lists are empty if early phase didn't test occlusion.
+    std::array<CullDrawList, CULL_DRAW_LISTS> recordLate(VkCommandBuffer commandBuffer);
+
+    CullStats getStats();                       // Of latest frame device finished
+
+    void destroy();
+
+    ~GpuCuller();
+
+private:
+    // Uniform data of a dispatch - layout matches CullParams in cull.comp (std140)
+    struct CullParams {
+        glm::vec4 planes[6];
+        glm::mat4 pyramidViewProjection;        // View-projection depth pyramid was rendered with
+        glm::uvec4 listEnds;                    // Exclusive end of every list in dispatched candidates
+        glm::uvec4 commandOffsets;              // Output of every list in indirect ring, in uint32 elements
+        glm::uvec4 countOffsets;
+        glm::vec2 pyramidSize;                  // Of level 0
+        uint32_t firstObject;                   // Element of cull object ring dispatch starts at
+        uint32_t objectCount;
+        uint32_t retestOffset;                  // Count and candidates of occluded objects in cull ring, in uint32 elements
+        uint32_t phase;                         // 0 - early (all candidates), 1 - late (occluded ones)
+        uint32_t occlusion;                     // Early phase tests depth pyramid
+        uint32_t padding;
+    };
+
+    // Counts written by frame's dispatches, read after its fence
+    struct PendingCounts {
+        uint32_t totalObjects = 0;
+        std::vector<const uint32_t*> counts;
+        std::vector<const uint32_t*> lateCounts;
+        const uint32_t* occludedCount = nullptr; // Found occluded by early phase
+    };
+
+    VkDevice device;
+    UniformRing* uniformRing;
+    UniformRing* indirectRing;
+    DepthPyramid* depthPyramid;
+
+    UniformRing cullRing;                       // Candidates of current frame
+
+    std::array<std::vector<CullObject>, CULL_DRAW_LISTS> candidates;
+    std::array<PendingCounts, MAX_FRAME_DRAWS> pendingCounts;
+    int currentFrame = 0;
+    CullStats stats;
+
+    // Late phase of frame being recorded - prepared by record, dispatched by recordLate
+    CullParams lateParams;
+    std::array<CullDrawList, CULL_DRAW_LISTS> lateDrawLists;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::mat4 pyramidViewProjection = glm::mat4(1.0f);
+    bool pyramidBuilt = false;                  // Pyramid holds depth seen through pyramidViewProjection
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+
+    void createDescriptorSet(UniformRing* objectRing);
+    void createComputePipeline(const AssetArchive* archive);
+
+    // Room for commands and zeroed count of every non-empty list, in list and params
+    void allocateDrawLists(const std::array<uint32_t, CULL_DRAW_LISTS>& listSizes, std::array<CullDrawList, CULL_DRAW_LISTS>* drawLists,
+        CullParams* params, std::vector<const uint32_t*>* counts);
+    void dispatch(VkCommandBuffer commandBuffer, const CullParams& params);
+};
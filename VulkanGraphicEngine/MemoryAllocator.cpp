@@ -0,0 +1,396 @@
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+
+MemoryAllocator::MemoryAllocator()
+{
+
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+
+}
+
+MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    this->physicalDevice = physicalDevice;
+    this->device = device;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    // Two pools for every memory type - one for linear resources (buffers), one for optimal resources (images)
+    pools.resize(memoryProperties.memoryTypeCount * 2);
+    for (uint32_t i = 0; i < pools.size(); i++)
+    {
+        pools[i].memoryTypeIndex = i / 2;
+    }
+
+    dedicatedBytes.resize(memoryProperties.memoryHeapCount, 0);
+
+    mutex = std::make_shared<std::mutex>();
+}
+
+MemoryAllocation MemoryAllocator::allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties)
+{
+    // Ask driver whether buffer would be better off in its own memory
+    VkMemoryDedicatedRequirements dedicatedRequirements = {};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 memoryRequirements = {};
+    memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memoryRequirements.pNext = &dedicatedRequirements;
+
+    VkBufferMemoryRequirementsInfo2 requirementsInfo = {};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.buffer = buffer;
+
+    vkGetBufferMemoryRequirements2(device, &requirementsInfo, &memoryRequirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo = {};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.buffer = buffer;
+
+    bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    MemoryAllocation allocation = allocate(memoryRequirements.memoryRequirements, properties, true, dedicated, &dedicatedInfo);
+
+    VkResult result = vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to bind Buffer Memory!");
+    }
+
+    return allocation;
+}
+
+MemoryAllocation MemoryAllocator::allocateImageMemory(VkImage image, VkMemoryPropertyFlags properties)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements = {};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 memoryRequirements = {};
+    memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memoryRequirements.pNext = &dedicatedRequirements;
+
+    VkImageMemoryRequirementsInfo2 requirementsInfo = {};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.image = image;
+
+    vkGetImageMemoryRequirements2(device, &requirementsInfo, &memoryRequirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo = {};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.image = image;
+
+    bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    MemoryAllocation allocation = allocate(memoryRequirements.memoryRequirements, properties, false, dedicated, &dedicatedInfo);
+
+    VkResult result = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to bind Image Memory!");
+    }
+
+    return allocation;
+}
+
+void MemoryAllocator::free(MemoryAllocation* allocation)
+{
+    if (allocation->memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    MemoryPool& pool = pools[allocation->poolIndex];
+    uint32_t heapIndex = memoryProperties.memoryTypes[pool.memoryTypeIndex].heapIndex;
+
+    // Dedicated allocation owns whole device memory
+    if (allocation->blockIndex < 0)
+    {
+        vkFreeMemory(device, allocation->memory, nullptr);
+        dedicatedBytes[heapIndex] -= allocation->size;
+        dedicatedCount--;
+
+        *allocation = MemoryAllocation();
+        return;
+    }
+
+    MemoryBlock& block = pool.blocks[allocation->blockIndex];
+
+    // Put range back in offset order and merge it with free neighbours
+    FreeRange range = { allocation->offset, allocation->size };
+    auto next = std::lower_bound(block.freeRanges.begin(), block.freeRanges.end(), range,
+        [](const FreeRange& a, const FreeRange& b) { return a.offset < b.offset; });
+    auto inserted = block.freeRanges.insert(next, range);
+
+    if (inserted + 1 != block.freeRanges.end() && inserted->offset + inserted->size == (inserted + 1)->offset)
+    {
+        inserted->size += (inserted + 1)->size;
+        block.freeRanges.erase(inserted + 1);
+    }
+    if (inserted != block.freeRanges.begin() && (inserted - 1)->offset + (inserted - 1)->size == inserted->offset)
+    {
+        (inserted - 1)->size += inserted->size;
+        block.freeRanges.erase(inserted);
+    }
+
+    block.allocationCount--;
+
+    // Release empty block, unless it is the last one in pool (keeps alloc/free of a single resource from hitting the driver every time)
+    if (block.allocationCount == 0)
+    {
+        size_t liveBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(),
+            [](const MemoryBlock& b) { return b.memory != VK_NULL_HANDLE; });
+
+        if (liveBlocks > 1)
+        {
+            vkFreeMemory(device, block.memory, nullptr);
+            block.memory = VK_NULL_HANDLE;
+            block.mappedData = nullptr;
+            block.freeRanges.clear();
+        }
+    }
+
+    *allocation = MemoryAllocation();
+}
+
+MemoryStats MemoryAllocator::getStats()
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    MemoryStats stats;
+    stats.dedicatedCount = dedicatedCount;
+    stats.allocationCount = dedicatedCount;
+
+    stats.heaps.resize(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+    {
+        stats.heaps[i].heapSize = memoryProperties.memoryHeaps[i].size;
+        stats.heaps[i].allocatedBytes = dedicatedBytes[i];
+        stats.heaps[i].usedBytes = dedicatedBytes[i];
+    }
+
+    VkDeviceSize totalFree = 0;
+    VkDeviceSize largestFree = 0;
+
+    for (const auto& pool : pools)
+    {
+        uint32_t heapIndex = memoryProperties.memoryTypes[pool.memoryTypeIndex].heapIndex;
+
+        for (const auto& block : pool.blocks)
+        {
+            if (block.memory == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            VkDeviceSize blockFree = 0;
+            for (const auto& range : block.freeRanges)
+            {
+                blockFree += range.size;
+                largestFree = std::max(largestFree, range.size);
+            }
+
+            totalFree += blockFree;
+            stats.blockCount++;
+            stats.allocationCount += block.allocationCount;
+            stats.heaps[heapIndex].allocatedBytes += block.size;
+            stats.heaps[heapIndex].usedBytes += block.size - blockFree;
+        }
+    }
+
+    // Fragmentation : How much of free space can't be used by the biggest possible allocation
+    if (totalFree > 0)
+    {
+        stats.fragmentation = 1.0f - (float)largestFree / (float)totalFree;
+    }
+
+    return stats;
+}
+
+void MemoryAllocator::destroy()
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    for (auto& pool : pools)
+    {
+        for (auto& block : pool.blocks)
+        {
+            if (block.memory != VK_NULL_HANDLE)
+            {
+                vkFreeMemory(device, block.memory, nullptr);
+            }
+        }
+        pool.blocks.clear();
+    }
+}
+
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, bool dedicated,
+    const VkMemoryDedicatedAllocateInfo* dedicatedInfo)
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    uint32_t memoryTypeIndex = findMemoryTypeIndex(requirements.memoryTypeBits, properties);
+
+    MemoryAllocation allocation;
+    allocation.poolIndex = memoryTypeIndex * 2 + (linear ? 0 : 1);
+    allocation.size = requirements.size;
+
+    // Big resources (e.g. large images, depth buffer) would waste most of a block - give them memory of their own
+    if (dedicated || requirements.size >= DEDICATED_ALLOCATION_THRESHOLD)
+    {
+        allocation.memory = allocateDeviceMemory(requirements.size, memoryTypeIndex, dedicatedInfo, &allocation.mappedData);
+        allocation.offset = 0;
+        allocation.blockIndex = -1;
+
+        dedicatedBytes[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] += requirements.size;
+        dedicatedCount++;
+
+        return allocation;
+    }
+
+    MemoryPool& pool = pools[allocation.poolIndex];
+
+    // Try to fit allocation in one of existing blocks
+    for (size_t i = 0; i < pool.blocks.size(); i++)
+    {
+        MemoryBlock& block = pool.blocks[i];
+        if (block.memory != VK_NULL_HANDLE && allocateFromBlock(&block, requirements.size, requirements.alignment, &allocation.offset))
+        {
+            allocation.memory = block.memory;
+            allocation.blockIndex = static_cast<int>(i);
+            allocation.mappedData = block.mappedData ? static_cast<char*>(block.mappedData) + allocation.offset : nullptr;
+            return allocation;
+        }
+    }
+
+    // No space left - create new block (reusing slot of released block if possible, so block indices stay valid)
+    MemoryBlock newBlock = {};
+    newBlock.size = std::max(getBlockSize(memoryTypeIndex), requirements.size);
+    newBlock.memory = allocateDeviceMemory(newBlock.size, memoryTypeIndex, nullptr, &newBlock.mappedData);
+    newBlock.freeRanges.push_back({ 0, newBlock.size });
+
+    auto emptySlot = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+        [](const MemoryBlock& b) { return b.memory == VK_NULL_HANDLE; });
+
+    size_t blockIndex = emptySlot - pool.blocks.begin();
+    if (emptySlot == pool.blocks.end())
+    {
+        pool.blocks.push_back(newBlock);
+    }
+    else
+    {
+        *emptySlot = newBlock;
+    }
+
+    MemoryBlock& block = pool.blocks[blockIndex];
+    allocateFromBlock(&block, requirements.size, requirements.alignment, &allocation.offset);
+
+    allocation.memory = block.memory;
+    allocation.blockIndex = static_cast<int>(blockIndex);
+    allocation.mappedData = block.mappedData ? static_cast<char*>(block.mappedData) + allocation.offset : nullptr;
+
+    return allocation;
+}
+
+bool MemoryAllocator::allocateFromBlock(MemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+{
+    // Best fit - pick free range that leaves the least space behind
+    size_t bestRange = block->freeRanges.size();
+    VkDeviceSize bestLeftover = 0;
+
+    for (size_t i = 0; i < block->freeRanges.size(); i++)
+    {
+        const FreeRange& range = block->freeRanges[i];
+
+        // Align offset up (alignment is always a power of two)
+        VkDeviceSize alignedOffset = (range.offset + alignment - 1) & ~(alignment - 1);
+        VkDeviceSize padding = alignedOffset - range.offset;
+
+        if (range.size < padding + size)
+        {
+            continue;
+        }
+
+        VkDeviceSize leftover = range.size - padding - size;
+        if (bestRange == block->freeRanges.size() || leftover < bestLeftover)
+        {
+            bestRange = i;
+            bestLeftover = leftover;
+        }
+    }
+
+    if (bestRange == block->freeRanges.size())
+    {
+        return false;
+    }
+
+    FreeRange range = block->freeRanges[bestRange];
+    VkDeviceSize alignedOffset = (range.offset + alignment - 1) & ~(alignment - 1);
+    VkDeviceSize padding = alignedOffset - range.offset;
+
+    // Split range into padding in front of allocation and space left after it
+    block->freeRanges.erase(block->freeRanges.begin() + bestRange);
+    if (bestLeftover > 0)
+    {
+        block->freeRanges.insert(block->freeRanges.begin() + bestRange, { alignedOffset + size, bestLeftover });
+    }
+    if (padding > 0)
+    {
+        block->freeRanges.insert(block->freeRanges.begin() + bestRange, { range.offset, padding });
+    }
+
+    block->allocationCount++;
+    *offset = alignedOffset;
+
+    return true;
+}
+
+VkDeviceMemory MemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, const void* pNext, void** mappedData)
+{
+    VkMemoryAllocateInfo memoryAllocateInfo = {};
+    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryAllocateInfo.pNext = pNext;
+    memoryAllocateInfo.allocationSize = size;
+    memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkDeviceMemory memory;
+    VkResult result = vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate Device Memory!");
+    }
+
+    // Host visible memory stays mapped for its whole lifetime - allocations just get a pointer into it
+    *mappedData = nullptr;
+    if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mappedData);
+    }
+
+    return memory;
+}
+
+uint32_t MemoryAllocator::findMemoryTypeIndex(uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        if ((allowedTypes & (1 << i))                                                           // Index of memory type must match corresponding bit in allowedTypes
+            && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties     // Desired property bit flags are part of memory type's property flags
+            )
+        {
+            return i;       // This memory type is valid
+        }
+    }
+
+    throw std::runtime_error("Failed to find a matching Memory Type!");
+}
+
+VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryTypeIndex)
+{
+    // Small heaps (e.g. 256MB host visible VRAM) shouldn't be eaten by a few blocks
+    VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+    return std::min(MEMORY_BLOCK_SIZE, heapSize / 8);
+}
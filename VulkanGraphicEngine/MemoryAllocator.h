@@ -0,0 +1,93 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+const VkDeviceSize MEMORY_BLOCK_SIZE = 64 * 1024 * 1024;                 // Size of a single device memory block sub-allocations are taken from
+const VkDeviceSize DEDICATED_ALLOCATION_THRESHOLD = MEMORY_BLOCK_SIZE / 2; // Resources at least this big get their own device memory
+
+// Part of device memory given to a single buffer or image
+struct MemoryAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;     // Device memory allocation lives in (shared with other allocations unless dedicated)
+    VkDeviceSize offset = 0;                    // Offset of allocation in memory
+    VkDeviceSize size = 0;                      // Size of allocation
+    uint32_t poolIndex = 0;                     // Pool allocation was taken from (memory type + linear/optimal resource)
+    int blockIndex = -1;                        // Block in pool allocation was taken from, -1 for dedicated allocations
+    void* mappedData = nullptr;                 // Pointer to start of allocation if memory is host visible (persistently mapped), otherwise nullptr
+};
+
+struct MemoryHeapStats {
+    VkDeviceSize heapSize = 0;                  // Size of heap reported by device
+    VkDeviceSize allocatedBytes = 0;            // Bytes taken from heap by blocks and dedicated allocations
+    VkDeviceSize usedBytes = 0;                 // Bytes handed out to resources
+};
+
+struct MemoryStats {
+    uint32_t allocationCount = 0;               // Number of live allocations (sub-allocations + dedicated)
+    uint32_t blockCount = 0;                    // Number of live shared blocks
+    uint32_t dedicatedCount = 0;                // Number of live dedicated allocations
+    float fragmentation = 0.0f;                 // 0 - all free space in blocks is contiguous, close to 1 - free space is scattered in small ranges
+    std::vector<MemoryHeapStats> heaps;         // Stats for each memory heap of physical device
+};
+
+// Safe to use from multiple threads - every public function locks allocator
+class MemoryAllocator
+{
+public:
+    MemoryAllocator();
+    MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+
+    MemoryAllocation allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties);
+    MemoryAllocation allocateImageMemory(VkImage image, VkMemoryPropertyFlags properties);
+    void free(MemoryAllocation* allocation);
+
+    MemoryStats getStats();
+
+    void destroy();
+
+    ~MemoryAllocator();
+
+private:
+    // Free part of block, sorted by offset and merged with neighbours when released
+    struct FreeRange {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct MemoryBlock {
+        VkDeviceMemory memory;
+        VkDeviceSize size;
+        void* mappedData;
+        uint32_t allocationCount;
+        std::vector<FreeRange> freeRanges;
+    };
+
+    // Linear (buffers) and optimal (images) resources use separate pools, so bufferImageGranularity never has to be respected inside a block
+    struct MemoryPool {
+        uint32_t memoryTypeIndex;
+        std::vector<MemoryBlock> blocks;
+    };
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+
+    std::vector<MemoryPool> pools;                  // Two pools for each memory type: [type * 2] - linear, [type * 2 + 1] - optimal
+    std::vector<VkDeviceSize> dedicatedBytes;       // Bytes allocated by dedicated allocations for each heap
+    uint32_t dedicatedCount = 0;
+
+    std::shared_ptr<std::mutex> mutex;              // Shared, so allocator can still be assigned like other renderer parts
+
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, bool dedicated,
+        const VkMemoryDedicatedAllocateInfo* dedicatedInfo);
+    bool allocateFromBlock(MemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset);
+    VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, const void* pNext, void** mappedData);
+
+    uint32_t findMemoryTypeIndex(uint32_t allowedTypes, VkMemoryPropertyFlags properties);
+    VkDeviceSize getBlockSize(uint32_t memoryTypeIndex);
+};
@@ -10,18 +10,122 @@ Mesh::~Mesh()
 
 }
 
-Mesh::Mesh(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue transferQueue,
-    VkCommandPool transferCommandPool, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, int textureIndex)
+Mesh::Mesh(GeometryArena* geometryArena, UploadBatch* uploadBatch,
+    std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, int textureIndex, VertexLayout vertexLayout)
 {
+    // Checked before geometry is allocated - nothing to release when it throws
+    setTextureIndex(textureIndex);
+
     vertexCount = vertices->size();
     indexCount = indices->size();
-    this->physicalDevice = physicalDevice;
-    this->device = device;
-    createVertexBuffer(transferQueue, transferCommandPool, vertices);
-    createIndexBuffer(transferQueue, transferCommandPool, indices);
+    this->geometryArena = geometryArena;
+    this->vertexLayout = vertexLayout;
+
+    glm::vec3 boundsMin, boundsMax;
+    VertexPacker::getBounds(*vertices, &boundsMin, &boundsMax);
+    setBounds(boundsMin, boundsMax);
+    setLods({ { 0, static_cast<uint32_t>(indexCount), 0.0f } });
+
+    // Standard layout is uploaded as it is, other layouts are packed first
+    const void* vertexData = vertices->data();
+    std::vector<unsigned char> packedVertices;
+    if (vertexLayout != VertexLayout::Standard)
+    {
+        packedVertices = VertexPacker::pack(vertexLayout, *vertices, boundsMin, boundsMax);
+        dequantization = VertexPacker::getDequantization(vertexLayout, boundsMin, boundsMax);
+        vertexData = packedVertices.data();
+    }
+
+    // Small meshes store indices as 16 bit - half of index memory and bandwidth
+    indexType = selectIndexType(static_cast<uint32_t>(vertexCount));
+    const void* indexData = indices->data();
+    std::vector<uint16_t> shortIndices;
+    if (indexType == VK_INDEX_TYPE_UINT16)
+    {
+        shortIndices.resize(indices->size());
+        for (size_t i = 0; i < indices->size(); i++)
+        {
+            shortIndices[i] = static_cast<uint16_t>((*indices)[i]);
+        }
+        indexData = shortIndices.data();
+    }
+
+    createGeometry(uploadBatch, [vertexData](void* destination, VkDeviceSize offset, VkDeviceSize size)
+    {
+        memcpy(destination, static_cast<const char*>(vertexData) + offset, static_cast<size_t>(size));
+    },
+    [indexData](void* destination, VkDeviceSize offset, VkDeviceSize size)
+    {
+        memcpy(destination, static_cast<const char*>(indexData) + offset, static_cast<size_t>(size));
+    });
 
     model.model = glm::mat4(1.0f);
-    this->textureIndex = textureIndex;
+}
+
+Mesh::Mesh(GeometryArena* geometryArena, UploadBatch* uploadBatch, VertexLayout vertexLayout, const glm::mat4& dequantization,
+    uint32_t vertexCount, const UploadSource& vertexSource, uint32_t indexCount, VkIndexType indexType, const UploadSource& indexSource, int textureIndex)
+{
+    // Checked before geometry is allocated - nothing to release when it throws
+    setTextureIndex(textureIndex);
+
+    this->vertexCount = vertexCount;
+    this->indexCount = indexCount;
+    this->indexType = indexType;
+    this->geometryArena = geometryArena;
+    this->vertexLayout = vertexLayout;
+    this->dequantization = dequantization;
+    setLods({ { 0, indexCount, 0.0f } });
+    createGeometry(uploadBatch, vertexSource, indexSource);
+
+    model.model = glm::mat4(1.0f);
+}
+
+VkIndexType Mesh::selectIndexType(uint32_t vertexCount)
+{
+    return vertexCount <= MAX_UINT16_INDEX_VERTICES ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+uint32_t Mesh::getIndexSize(VkIndexType indexType)
+{
+    return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void Mesh::getVertexInputDescription(VertexLayout vertexLayout, VkVertexInputBindingDescription* bindingDescription,
+    std::vector<VkVertexInputAttributeDescription>* attributeDescriptions)
+{
+    // How to data for a single vertex (including info such as position, colour, texture coords, normals etc.)
+    bindingDescription->binding = 0;                                // Can bind multiple streams of data, this defines which one
+    bindingDescription->stride = VertexPacker::getStride(vertexLayout);  // Size of a single vertex in buffer
+    bindingDescription->inputRate = VK_VERTEX_INPUT_RATE_VERTEX;    // How to move between data after each vertex
+
+    // How the data for an attribute is defined within a vertex
+    // Location in shader stays same for all layouts - formats converted by vertex fetch make them all arrive as float
+    attributeDescriptions->resize(3);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        (*attributeDescriptions)[i].binding = 0;
+        (*attributeDescriptions)[i].location = i;
+    }
+
+    if (vertexLayout == VertexLayout::Compact)
+    {
+        // Position : SNORM16 in [-1, 1] of mesh bounds, dequantization is part of model matrix
+        (*attributeDescriptions)[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+        (*attributeDescriptions)[0].offset = offsetof(CompactVertex, pos);
+        (*attributeDescriptions)[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+        (*attributeDescriptions)[1].offset = offsetof(CompactVertex, col);
+        (*attributeDescriptions)[2].format = VK_FORMAT_R16G16_SFLOAT;
+        (*attributeDescriptions)[2].offset = offsetof(CompactVertex, tex);
+    }
+    else
+    {
+        (*attributeDescriptions)[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        (*attributeDescriptions)[0].offset = offsetof(Vertex, pos);
+        (*attributeDescriptions)[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+        (*attributeDescriptions)[1].offset = offsetof(Vertex, col);
+        (*attributeDescriptions)[2].format = VK_FORMAT_R32G32_SFLOAT;
+        (*attributeDescriptions)[2].offset = offsetof(Vertex, tex);
+    }
 }
 
 void Mesh::setModel(glm::mat4 newModel)
@@ -34,95 +138,177 @@ Model Mesh::getModel()
     return model;
 }
 
+VertexLayout Mesh::getVertexLayout()
+{
+    return vertexLayout;
+}
+
+glm::mat4 Mesh::getDequantization()
+{
+    return dequantization;
+}
+
 int Mesh::getTextureIndex()
 {
     return textureIndex;
 }
 
-int Mesh::getVertexCount()
+void Mesh::setTextureIndex(int textureIndex)
 {
-    return vertexCount;
+    // Goes to shader as it is - index outside descriptor array would be out of bounds access on GPU
+    if (textureIndex < 0 || textureIndex >= MAX_TEXTURES)
+    {
+        throw std::runtime_error("Mesh texture index " + std::to_string(textureIndex) + " is outside texture descriptor array!");
+    }
+    this->textureIndex = textureIndex;
 }
 
-int Mesh::getIndexCount()
+glm::vec4 Mesh::getColour()
 {
-    return indexCount;
+    return colour;
+}
+
+void Mesh::setColour(const glm::vec4& colour)
+{
+    this->colour = colour;
+}
+
+void Mesh::setLods(const std::vector<MeshLod>& lods)
+{
+    this->lods = lods;
+}
+
+void Mesh::setBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+    boundsHalfSize = (boundsMax - boundsMin) * 0.5f;
+}
+
+void Mesh::getBounds(glm::vec3* boundsMin, glm::vec3* boundsMax)
+{
+    *boundsMin = boundsCenter - boundsHalfSize;
+    *boundsMax = boundsCenter + boundsHalfSize;
 }
 
-VkBuffer Mesh::getVertexBuffer()
+glm::vec4 Mesh::getBoundingSphere(const glm::mat4& instanceModel)
 {
-    return vertexBuffer;
+    float scale = std::max(glm::length(glm::vec3(instanceModel[0])), std::max(glm::length(glm::vec3(instanceModel[1])), glm::length(glm::vec3(instanceModel[2]))));
+    return glm::vec4(glm::vec3(instanceModel * glm::vec4(boundsCenter, 1.0f)), boundsRadius * scale);
+}
+
+glm::vec4 Mesh::getStoredBoundingSphere()
+{
+    if (vertexLayout == VertexLayout::Standard)
+    {
+        return glm::vec4(boundsCenter, boundsRadius);
+    }
+
+    // Dequantization only scales and translates - undo it for center, shortest axis scales radius
+    glm::vec3 scale(dequantization[0][0], dequantization[1][1], dequantization[2][2]);
+    glm::vec3 center = (boundsCenter - glm::vec3(dequantization[3])) / scale;
+    return glm::vec4(center, boundsRadius / std::min(scale.x, std::min(scale.y, scale.z)));
 }
 
-VkBuffer Mesh::getIndexBuffer()
+uint32_t Mesh::getLodCount()
 {
-    return indexBuffer;
+    return static_cast<uint32_t>(lods.size());
 }
 
-void Mesh::destroyBuffers()
+const MeshLod& Mesh::getLod(uint32_t lod)
 {
-    vkDestroyBuffer(device, vertexBuffer, nullptr);
-    vkFreeMemory(device, vertexBufferMemory, nullptr);
-    vkDestroyBuffer(device, indexBuffer, nullptr);
-    vkFreeMemory(device, indexBufferMemory, nullptr);
+    return lods[lod];
 }
 
-void Mesh::createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex> * vertices)
+uint32_t Mesh::selectLod(const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError)
 {
-    VkDeviceSize bufferSize = sizeof(Vertex) * vertices->size();
+    return selectLod(model.model, cameraPosition, pixelsPerUnit, maxPixelError);
+}
+
+uint32_t Mesh::selectLod(const glm::mat4& instanceModel, const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError)
+{
+    // Single level - nothing to select
+    if (lods.size() == 1)
+    {
+        return 0;
+    }
+
+    // Largest axis scale of model matrix scales error and radius alike
+    float scale = std::max(glm::length(glm::vec3(instanceModel[0])), std::max(glm::length(glm::vec3(instanceModel[1])), glm::length(glm::vec3(instanceModel[2]))));
+    glm::vec3 center = glm::vec3(instanceModel * glm::vec4(boundsCenter, 1.0f));
 
-    // Staging Buffer - temporary - "stage" vertex data before transferring to GPU
-    VkBuffer stagingBuffer;
-    VkDeviceMemory staggingBufferMemory;
+    // Inside bounds (or very close) - full detail
+    float distance = glm::length(center - cameraPosition) - boundsRadius * scale;
+    if (distance <= 0.0f)
+    {
+        return 0;
+    }
 
-    // Create Staging Buffer and allocate memory to it
-    // VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT  : CPU can interact with memory 
-    // VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : Allow placement of data straight into buffer after mapping (otherwise would have to specify manually)
-    createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &staggingBufferMemory);
+    uint32_t selected = 0;
+    for (uint32_t i = 1; i < lods.size(); i++)
+    {
+        if (lods[i].error * scale * pixelsPerUnit / distance > maxPixelError)
+        {
+            break;
+        }
+        selected = i;
+    }
 
-    // MAP MEMORY TO VERTEX BUFFER
-    void * data;                                                                  // 1. Create pointer to a point in normal memory
-    vkMapMemory(device, staggingBufferMemory, 0, bufferSize, 0, &data);           // 2. Map the Vertex Buffer Memory to the pointer - create a relationship between these two
-    memcpy(data, vertices->data(), (size_t) bufferSize);                          // 3. Copy memory from vertices to the pointer - data is in vertexBufferMemory
-    vkUnmapMemory(device, staggingBufferMemory);                                  // 4. Unmap the vertex buffer memory - destroy relationship 
+    return selected;
+}
 
-    // Create Buffer with TRANSFER_DST_BIT to mark as recipient of transfer data
-    // VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : Only visible to GPU
-    createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertexBuffer, &vertexBufferMemory);
+int Mesh::getVertexCount()
+{
+    return vertexCount;
+}
 
-    // Copy staging buffer to vertex buffer on GPU
-    copyBuffer(device, transferQueue, transferCommandPool, stagingBuffer, vertexBuffer, bufferSize);
+int Mesh::getIndexCount()
+{
+    return indexCount;
+}
 
-    // Clean up staging buffer parts
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, staggingBufferMemory, nullptr);
+VkIndexType Mesh::getIndexType()
+{
+    return indexType;
 }
 
-void Mesh::createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices)
+int32_t Mesh::getVertexOffset()
 {
-    VkDeviceSize bufferSize = sizeof(uint32_t) * indices->size();
+    return static_cast<int32_t>(geometry.vertexOffset / VertexPacker::getStride(vertexLayout));
+}
 
-    // Temporary Buffer to Stage vertext data before transferring to GPU
-    VkBuffer stagingBuffer;
-    VkDeviceMemory staggingBufferMemory;
-    createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &staggingBufferMemory);
+uint32_t Mesh::getFirstIndex()
+{
+    return static_cast<uint32_t>(geometry.indexOffset / getIndexSize(indexType));
+}
 
-    // MAP MEMORY TO VERTEX BUFFER
-    void* data;
-    vkMapMemory(device, staggingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices->data(), (size_t)bufferSize);
-    vkUnmapMemory(device, staggingBufferMemory);
+GeometryAllocation* Mesh::getGeometry()
+{
+    return &geometry;
+}
 
-    createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indexBuffer, &indexBufferMemory);
+void Mesh::freeGeometry()
+{
+    geometryArena->free(&geometry);
+}
 
-    // Copy staging buffer to GPU access buffer
-    copyBuffer(device, transferQueue, transferCommandPool, stagingBuffer, indexBuffer, bufferSize);
+void Mesh::createGeometry(UploadBatch* uploadBatch, const UploadSource& vertexSource, const UploadSource& indexSource)
+{
+    VkDeviceSize vertexSize = static_cast<VkDeviceSize>(VertexPacker::getStride(vertexLayout)) * vertexCount;
+    VkDeviceSize indexSize = static_cast<VkDeviceSize>(getIndexSize(indexType)) * indexCount;
+    geometry = geometryArena->allocate(vertexSize, indexSize);
 
-    // Destroy + Release staging buffer parts
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, staggingBufferMemory, nullptr);
+    // "Stage" data and record copies into arena buffers on GPU - executed when batch is submitted
+    try
+    {
+        uploadBatch->copyToBuffer(vertexSource, vertexSize, geometryArena->getVertexBuffer(), geometry.vertexOffset);
+        uploadBatch->copyToBuffer(indexSource, indexSize, geometryArena->getIndexBuffer(), geometry.indexOffset);
+    }
+    catch (...)
+    {
+        // Source failed (e.g. file read) - range can be given back only once no copy into it is left in batch or in flight
+        uploadBatch->discard();
+        geometryArena->free(&geometry);
+        throw;
+    }
 }
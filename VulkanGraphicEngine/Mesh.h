@@ -4,8 +4,40 @@
 #include <GLFW/glfw3.h>
 
 #include <vector>
+#include <algorithm>
 
 #include "Utilities.h"
+#include "UploadBatch.h"
+#include "VertexLayout.h"
+#include "GeometryArena.h"
+
+// Index buffers of all meshes in scene - savings of 16 bit indices against storing everything as 32 bit
+struct IndexStats {
+    uint32_t meshCount = 0;
+    uint32_t uint16MeshCount = 0;               // Meshes using 16 bit indices
+    VkDeviceSize indexBytes = 0;                // Index buffer data as stored
+    VkDeviceSize uint32IndexBytes = 0;          // Same indices as 32 bit
+};
+
+const float LOD_MAX_PIXEL_ERROR = 1.0f;         // Screen space error in pixels a LOD may have at LOD bias 1
+
+// Triangles drawn last frame against drawing every mesh at full detail
+struct LodStats {
+    uint32_t drawCount = 0;
+    uint32_t instanceCount = 0;
+    uint64_t triangles = 0;
+    uint64_t fullTriangles = 0;
+    uint32_t lodInstances[MAX_MESH_LODS] = {};  // Instances drawn at each detail level
+};
+
+// Cost of recording last frame on CPU - indirect drawing keeps API calls constant however many objects there are
+struct DrawStats {
+    uint32_t drawCalls = 0;                     // vkCmdDraw* calls recorded
+    uint32_t indirectDraws = 0;                 // Draws issued from indirect buffer by those calls
+    double recordMs = 0.0;                      // Writing objects / draws and recording command buffer
+    uint32_t bindCalls = 0;                     // vkCmdBind* calls of graphics state recorded
+    uint32_t avoidedBinds = 0;                  // Pipeline / index buffer binds skipped by bindDrawState because state was already bound
+};
 
 struct Model {
     // Where the object is positioned in the world
@@ -13,43 +45,100 @@ struct Model {
     glm::mat4 model;
 };
 
+// Everything shaders need about one drawn object (instance) - element of per-frame object storage buffer, read at gl_InstanceIndex
+// Layout matches ObjectData in shader.vert (std430)
+struct ObjectData {
+    glm::mat4 model;                            // Model with mesh's dequantization already applied
+    glm::vec4 colour;                           // Multiplies texture colour
+    uint32_t textureIndex;                      // Element of texture descriptor array
+    uint32_t padding[3];
+};
+
 class Mesh
 {
 public:
     Mesh();
-    Mesh(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue transferQueue,
-        VkCommandPool transferCommandPool, std::vector<Vertex> * vertices, std::vector<uint32_t> * indices, int textureIndex);
+    Mesh(GeometryArena* geometryArena, UploadBatch* uploadBatch,
+        std::vector<Vertex> * vertices, std::vector<uint32_t> * indices, int textureIndex, VertexLayout vertexLayout = VertexLayout::Standard);
+
+    // Vertex data already in given layout and index data are written straight into staging memory by sources (e.g. streamed from mesh file)
+    // Indices are given in indexType. When a source throws, upload batch is discarded and geometry freed before exception is passed on.
+    Mesh(GeometryArena* geometryArena, UploadBatch* uploadBatch, VertexLayout vertexLayout, const glm::mat4& dequantization,
+        uint32_t vertexCount, const UploadSource& vertexSource, uint32_t indexCount, VkIndexType indexType, const UploadSource& indexSource, int textureIndex);
+
+    // Pipeline vertex input matching layout - every layout feeds same shader locations
+    // Smallest index type able to address vertexCount vertices
+    static VkIndexType selectIndexType(uint32_t vertexCount);
+    static uint32_t getIndexSize(VkIndexType indexType);
+
+    static void getVertexInputDescription(VertexLayout vertexLayout, VkVertexInputBindingDescription* bindingDescription,
+        std::vector<VkVertexInputAttributeDescription>* attributeDescriptions);
 
     void setModel(glm::mat4 model);
     Model getModel();
 
+    VertexLayout getVertexLayout();
+    glm::mat4 getDequantization();              // Stored positions to mesh space - applied before model matrix
+
     int getTextureIndex();
+    void setTextureIndex(int textureIndex);     // Throws when outside [0, MAX_TEXTURES)
+
+    glm::vec4 getColour();
+    void setColour(const glm::vec4& colour);
+
+    // Index ranges of detail levels (full detail first) and mesh space bounds they are selected by
+    void setLods(const std::vector<MeshLod>& lods);
+    void setBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    uint32_t getLodCount();
+    const MeshLod& getLod(uint32_t lod);
+
+    // World space bounding sphere (center, radius) of mesh placed by model - radius scaled by largest axis scale
+    glm::vec4 getBoundingSphere(const glm::mat4& instanceModel);
+
+    // Mesh space bounding box - set by setBounds
+    void getBounds(glm::vec3* boundsMin, glm::vec3* boundsMax);
+
+    // Bounding sphere (center, radius) in space of stored positions - before dequantization, radius conservative for quantized layouts
+    glm::vec4 getStoredBoundingSphere();
+
+    // Coarsest level whose error projected at bounding sphere's nearest point stays within maxPixelError
+    // pixelsPerUnit - screen pixels covered by one unit at distance one (viewport height / 2 * projection[1][1])
+    uint32_t selectLod(const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError);
+    uint32_t selectLod(const glm::mat4& instanceModel, const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError);   // Instance with its own model
 
     int getVertexCount();
-    int getIndexCount();
-    VkBuffer getVertexBuffer();
-    VkBuffer getIndexBuffer();
+    int getIndexCount();                        // All levels together
+    VkIndexType getIndexType();
+
+    // Where geometry is in arena buffers - vertexOffset / firstIndex of draws
+    int32_t getVertexOffset();
+    uint32_t getFirstIndex();
+    GeometryAllocation* getGeometry();          // Updated in place when arena is compacted
 
-    void destroyBuffers();
+    void freeGeometry();
 
     ~Mesh();
 
 private:
     Model model;
-    int textureIndex;
+    int textureIndex = 0;
+    glm::vec4 colour = glm::vec4(1.0f);
 
-    int vertexCount;
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
+    VertexLayout vertexLayout = VertexLayout::Standard;
+    glm::mat4 dequantization = glm::mat4(1.0f);
 
+    int vertexCount;
     int indexCount;
-    VkBuffer indexBuffer;
-    VkDeviceMemory indexBufferMemory;
+    std::vector<MeshLod> lods;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+    glm::vec3 boundsHalfSize = glm::vec3(0.0f);
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
-    VkPhysicalDevice physicalDevice;
-    VkDevice device;
+    GeometryArena* geometryArena;
+    GeometryAllocation geometry;
 
-    void createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex> * vertices);
-    void createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices);
+    // Arena ranges for vertices and indices, data copied into them by upload batch
+    void createGeometry(UploadBatch* uploadBatch, const UploadSource& vertexSource, const UploadSource& indexSource);
 };
 
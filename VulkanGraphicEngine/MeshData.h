@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Vertex data representation
+struct Vertex {
+    glm::vec3 pos;  // Vertex position (x, y, z)
+    glm::vec3 col;  // Vertex colour (r, g, b)
+    glm::vec2 tex;  // Texture Coords (u, v)
+};
+
+const uint32_t MAX_UINT16_INDEX_VERTICES = 65535;       // Meshes with at most this many vertices get 16 bit indices
+
+const uint32_t MAX_MESH_LODS = 5;                       // Detail levels of a mesh, including full one
+
+// Range of indices drawn at one detail level - all levels index the same vertices
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;                                // Largest deviation from full mesh, in mesh space units
+};
+
+// Geometry drawn with a single texture - one per material of an imported model
+struct MeshData {
+    std::string texture;                        // File in Textures/, empty if material has none
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;              // Indices of every LOD, one after another
+    std::vector<MeshLod> lods;                  // Empty - single level of all indices
+};
+
+// Binary mesh file (.vmesh) layout:
+// MeshFileHeader | MeshFileSubmesh[submeshCount] | MeshLod[lods of all submeshes] | name table |
+// vertex and index data of every submesh, each aligned to MESH_FILE_ALIGNMENT
+const char MESH_FILE_MAGIC[4] = { 'V', 'G', 'E', 'M' };
+const uint32_t MESH_FILE_VERSION = 4;
+const uint64_t MESH_FILE_ALIGNMENT = 16;
+
+struct MeshFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t submeshCount;
+    uint32_t namesSize;
+};
+
+struct MeshFileSubmesh {
+    uint64_t vertexOffset;                      // From start of file
+    uint64_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t vertexLayout;                      // VertexLayout vertices are stored in, uploaded as they are
+    uint32_t vertexStride;
+    uint32_t indexSize;                         // 2 or 4 bytes - 16 bit when vertex count allows
+    uint32_t lodCount;
+    uint32_t textureOffset;                     // Into name table, not null terminated
+    uint32_t textureLength;
+    float boundsMin[3];                         // Bounding box of positions (Compact positions are relative to it)
+    float boundsMax[3];
+    uint32_t firstLod;                          // Into LOD table, LOD index ranges are relative to submesh's index data
+    uint32_t reserved;
+};
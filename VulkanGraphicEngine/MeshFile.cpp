@@ -0,0 +1,290 @@
+#include "MeshFile.h"
+
+MeshFile::MeshFile()
+{
+
+}
+
+MeshFile::~MeshFile()
+{
+
+}
+
+void MeshFile::open(const std::string& filename, const AssetArchive* archive)
+{
+    close();
+    this->filename = filename;
+
+    const char* archived;
+    size_t archivedSize;
+    if (archive && archive->isOpen() && archive->find(filename, &archived, &archivedSize))
+    {
+        mappedData = archived;
+        mappedSize = archivedSize;
+    }
+    else
+    {
+        file.open(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open the file: " + filename);
+        }
+    }
+
+    MeshFileHeader header;
+    read(0, &header, sizeof(MeshFileHeader));
+    if (memcmp(header.magic, MESH_FILE_MAGIC, sizeof(MESH_FILE_MAGIC)) != 0)
+    {
+        throw std::runtime_error("File is not a mesh file (" + filename + ")!");
+    }
+    if (header.version != MESH_FILE_VERSION)
+    {
+        throw std::runtime_error("Mesh file has version " + std::to_string(header.version) + ", expected " + std::to_string(MESH_FILE_VERSION) + " (" + filename + ")!");
+    }
+    submeshes.resize(header.submeshCount);
+    names.resize(header.namesSize);
+    read(sizeof(MeshFileHeader), submeshes.data(), submeshes.size() * sizeof(MeshFileSubmesh));
+
+    uint64_t lodCount = 0;
+    for (const auto& submesh : submeshes)
+    {
+        lodCount += submesh.lodCount;
+    }
+    lods.resize(static_cast<size_t>(lodCount));
+    uint64_t lodTableOffset = sizeof(MeshFileHeader) + submeshes.size() * sizeof(MeshFileSubmesh);
+    read(lodTableOffset, lods.data(), lods.size() * sizeof(MeshLod));
+    read(lodTableOffset + lods.size() * sizeof(MeshLod), &names[0], names.size());
+
+    for (const auto& submesh : submeshes)
+    {
+        if (submesh.lodCount == 0 || submesh.lodCount > MAX_MESH_LODS || static_cast<uint64_t>(submesh.firstLod) + submesh.lodCount > lods.size())
+        {
+            throw std::runtime_error("Mesh file has invalid LOD table (" + filename + ")!");
+        }
+        for (uint32_t i = submesh.firstLod; i < submesh.firstLod + submesh.lodCount; i++)
+        {
+            if (static_cast<uint64_t>(lods[i].firstIndex) + lods[i].indexCount > submesh.indexCount)
+            {
+                throw std::runtime_error("Mesh file LOD is out of bounds (" + filename + ")!");
+            }
+        }
+        if (submesh.textureOffset + submesh.textureLength > names.size())
+        {
+            throw std::runtime_error("Mesh file texture name is out of bounds (" + filename + ")!");
+        }
+        if (submesh.vertexLayout >= VERTEX_LAYOUT_COUNT || submesh.vertexStride != VertexPacker::getStride(static_cast<VertexLayout>(submesh.vertexLayout)))
+        {
+            throw std::runtime_error("Mesh file has unknown vertex layout (" + filename + ")!");
+        }
+        if (submesh.indexSize != sizeof(uint16_t) && submesh.indexSize != sizeof(uint32_t))
+        {
+            throw std::runtime_error("Mesh file has unknown index size (" + filename + ")!");
+        }
+    }
+}
+
+uint32_t MeshFile::getSubmeshCount()
+{
+    return static_cast<uint32_t>(submeshes.size());
+}
+
+const MeshFileSubmesh& MeshFile::getSubmesh(uint32_t index)
+{
+    return submeshes[index];
+}
+
+std::string MeshFile::getTexture(uint32_t index)
+{
+    return names.substr(submeshes[index].textureOffset, submeshes[index].textureLength);
+}
+
+VertexLayout MeshFile::getVertexLayout(uint32_t index)
+{
+    return static_cast<VertexLayout>(submeshes[index].vertexLayout);
+}
+
+bool MeshFile::hasShortIndices(uint32_t index)
+{
+    return submeshes[index].indexSize == sizeof(uint16_t);
+}
+
+std::vector<MeshLod> MeshFile::getLods(uint32_t index)
+{
+    return std::vector<MeshLod>(lods.begin() + submeshes[index].firstLod, lods.begin() + submeshes[index].firstLod + submeshes[index].lodCount);
+}
+
+glm::mat4 MeshFile::getDequantization(uint32_t index)
+{
+    glm::vec3 boundsMin, boundsMax;
+    memcpy(&boundsMin, submeshes[index].boundsMin, sizeof(boundsMin));
+    memcpy(&boundsMax, submeshes[index].boundsMax, sizeof(boundsMax));
+
+    return VertexPacker::getDequantization(getVertexLayout(index), boundsMin, boundsMax);
+}
+
+void MeshFile::readVertices(uint32_t index, uint64_t offset, void* destination, uint64_t size)
+{
+    if (offset + size > static_cast<uint64_t>(submeshes[index].vertexCount) * submeshes[index].vertexStride)
+    {
+        throw std::runtime_error("Read past vertex data of submesh (" + filename + ")!");
+    }
+    read(submeshes[index].vertexOffset + offset, destination, size);
+}
+
+void MeshFile::readIndices(uint32_t index, uint64_t offset, void* destination, uint64_t size)
+{
+    if (offset + size > static_cast<uint64_t>(submeshes[index].indexCount) * submeshes[index].indexSize)
+    {
+        throw std::runtime_error("Read past index data of submesh (" + filename + ")!");
+    }
+    read(submeshes[index].indexOffset + offset, destination, size);
+}
+
+void MeshFile::close()
+{
+    if (file.is_open())
+    {
+        file.close();
+    }
+    file.clear();
+
+    mappedData = nullptr;
+    mappedSize = 0;
+    submeshes.clear();
+    lods.clear();
+    names.clear();
+}
+
+void MeshFile::read(uint64_t offset, void* destination, uint64_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (mappedData)
+    {
+        if (offset + size > mappedSize)
+        {
+            throw std::runtime_error("Mesh file is truncated (" + filename + ")!");
+        }
+        memcpy(destination, mappedData + offset, static_cast<size_t>(size));
+        return;
+    }
+
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(static_cast<char*>(destination), static_cast<std::streamsize>(size));
+    if (!file)
+    {
+        throw std::runtime_error("Mesh file is truncated (" + filename + ")!");
+    }
+}
+
+uint64_t MeshFile::write(const std::string& filename, const std::vector<MeshData>& meshes, bool compact)
+{
+    MeshFileHeader header = {};
+    memcpy(header.magic, MESH_FILE_MAGIC, sizeof(MESH_FILE_MAGIC));
+    header.version = MESH_FILE_VERSION;
+    header.submeshCount = static_cast<uint32_t>(meshes.size());
+
+    std::string textureNames;
+    std::vector<MeshFileSubmesh> table(meshes.size());
+    std::vector<MeshLod> lodTable;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        table[i].textureOffset = static_cast<uint32_t>(textureNames.size());
+        table[i].textureLength = static_cast<uint32_t>(meshes[i].texture.size());
+        textureNames += meshes[i].texture;
+
+        // Mesh without LODs is stored as a single level of all its indices
+        table[i].firstLod = static_cast<uint32_t>(lodTable.size());
+        if (meshes[i].lods.empty())
+        {
+            lodTable.push_back({ 0, static_cast<uint32_t>(meshes[i].indices.size()), 0.0f });
+        }
+        else
+        {
+            lodTable.insert(lodTable.end(), meshes[i].lods.begin(), meshes[i].lods.end());
+        }
+        table[i].lodCount = static_cast<uint32_t>(lodTable.size()) - table[i].firstLod;
+    }
+    header.namesSize = static_cast<uint32_t>(textureNames.size());
+
+    // Vertices then indices of every submesh, each block aligned
+    std::vector<std::vector<unsigned char>> packedVertices(meshes.size());
+    std::vector<std::vector<uint16_t>> shortIndices(meshes.size());
+    uint64_t tablesSize = sizeof(MeshFileHeader) + table.size() * sizeof(MeshFileSubmesh) + lodTable.size() * sizeof(MeshLod) + textureNames.size();
+    uint64_t offset = tablesSize;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const MeshData& mesh = meshes[i];
+
+        glm::vec3 boundsMin, boundsMax;
+        VertexPacker::getBounds(mesh.vertices, &boundsMin, &boundsMax);
+        memcpy(table[i].boundsMin, &boundsMin, sizeof(table[i].boundsMin));
+        memcpy(table[i].boundsMax, &boundsMax, sizeof(table[i].boundsMax));
+
+        VertexLayout layout = compact ? VertexPacker::selectLayout(mesh.vertices) : VertexLayout::Standard;
+        packedVertices[i] = VertexPacker::pack(layout, mesh.vertices, boundsMin, boundsMax);
+        table[i].vertexLayout = static_cast<uint32_t>(layout);
+        table[i].vertexStride = VertexPacker::getStride(layout);
+
+        offset = (offset + MESH_FILE_ALIGNMENT - 1) & ~(MESH_FILE_ALIGNMENT - 1);
+        table[i].vertexOffset = offset;
+        table[i].vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        offset += packedVertices[i].size();
+
+        offset = (offset + MESH_FILE_ALIGNMENT - 1) & ~(MESH_FILE_ALIGNMENT - 1);
+        table[i].indexOffset = offset;
+        table[i].indexCount = static_cast<uint32_t>(mesh.indices.size());
+        table[i].indexSize = sizeof(uint32_t);
+        if (mesh.vertices.size() <= MAX_UINT16_INDEX_VERTICES)
+        {
+            table[i].indexSize = sizeof(uint16_t);
+            shortIndices[i].resize(mesh.indices.size());
+            for (size_t j = 0; j < mesh.indices.size(); j++)
+            {
+                shortIndices[i][j] = static_cast<uint16_t>(mesh.indices[j]);
+            }
+        }
+        offset += static_cast<uint64_t>(mesh.indices.size()) * table[i].indexSize;
+    }
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        throw std::runtime_error("Failed to create mesh file: " + filename);
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(MeshFileHeader));
+    output.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(MeshFileSubmesh));
+    output.write(reinterpret_cast<const char*>(lodTable.data()), lodTable.size() * sizeof(MeshLod));
+    output.write(textureNames.data(), textureNames.size());
+
+    const char padding[MESH_FILE_ALIGNMENT] = {};
+    uint64_t written = tablesSize;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        output.write(padding, table[i].vertexOffset - written);
+        output.write(reinterpret_cast<const char*>(packedVertices[i].data()), packedVertices[i].size());
+        written = table[i].vertexOffset + packedVertices[i].size();
+
+        output.write(padding, table[i].indexOffset - written);
+        if (table[i].indexSize == sizeof(uint16_t))
+        {
+            output.write(reinterpret_cast<const char*>(shortIndices[i].data()), shortIndices[i].size() * sizeof(uint16_t));
+        }
+        else
+        {
+            output.write(reinterpret_cast<const char*>(meshes[i].indices.data()), meshes[i].indices.size() * sizeof(uint32_t));
+        }
+        written = table[i].indexOffset + static_cast<uint64_t>(meshes[i].indices.size()) * table[i].indexSize;
+    }
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write mesh file: " + filename);
+    }
+
+    return written;
+}
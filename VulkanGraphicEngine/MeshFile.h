@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include "MeshData.h"
+#include "VertexLayout.h"
+#include "AssetArchive.h"
+
+// Binary mesh file (.vmesh) - loads without any parsing, vertex and index data are stored exactly as uploaded.
+// Only header and submesh table are read on open, geometry is read submesh by submesh in pieces of caller's choosing,
+// so model can go straight into staging memory without ever being resident in RAM as a whole.
+class MeshFile
+{
+public:
+    MeshFile();
+
+    // From asset archive when it has file (path relative to asset root, e.g. "Models/house.vmesh"), otherwise from disk
+    // Throws if file is missing or isn't a valid mesh file
+    void open(const std::string& filename, const AssetArchive* archive = nullptr);
+
+    uint32_t getSubmeshCount();
+    const MeshFileSubmesh& getSubmesh(uint32_t index);
+    std::string getTexture(uint32_t index);
+    VertexLayout getVertexLayout(uint32_t index);
+    bool hasShortIndices(uint32_t index);       // Indices are uint16_t instead of uint32_t
+    glm::mat4 getDequantization(uint32_t index);
+    std::vector<MeshLod> getLods(uint32_t index);  // Index ranges relative to submesh's indices, full detail first
+
+    // Read part of vertex (in submesh's layout) / index data of submesh - offset and size are in bytes
+    void readVertices(uint32_t index, uint64_t offset, void* destination, uint64_t size);
+    void readIndices(uint32_t index, uint64_t offset, void* destination, uint64_t size);
+
+    void close();
+
+    // Compact layout is used for every submesh whose data fits it, unless compact is false - returns size of written file
+    static uint64_t write(const std::string& filename, const std::vector<MeshData>& meshes, bool compact = true);
+
+    ~MeshFile();
+
+private:
+    std::string filename;
+    const char* mappedData = nullptr;           // File data when it comes from archive
+    uint64_t mappedSize = 0;
+    std::ifstream file;
+
+    std::vector<MeshFileSubmesh> submeshes;
+    std::vector<MeshLod> lods;
+    std::string names;
+
+    void read(uint64_t offset, void* destination, uint64_t size);
+};
@@ -0,0 +1,381 @@
+#include "MeshOptimizer.h"
+
+#include <cmath>
+
+const uint32_t OVERDRAW_MIN_CLUSTER = 64;       // Triangles - smaller clusters are merged with following ones, so sorting doesn't break up cache locality
+
+MeshOptimizationStats MeshOptimizer::optimize(MeshData* mesh, uint32_t maxLods, bool reorderForOverdraw)
+{
+    MeshOptimizationStats stats;
+    uint32_t fullIndexCount = mesh->lods.empty() ? static_cast<uint32_t>(mesh->indices.size()) : mesh->lods[0].indexCount;
+    stats.before = analyzeVertexCache(std::vector<uint32_t>(mesh->indices.begin(), mesh->indices.begin() + fullIndexCount),
+        static_cast<uint32_t>(mesh->vertices.size()));
+
+    // Welding first - simplification needs connected triangles
+    stats.weldedVertices = weldVertices(mesh);
+    if (mesh->lods.empty())
+    {
+        MeshSimplifier::generateLods(mesh, maxLods);
+    }
+
+    // Every level is reordered on its own, in place
+    for (const auto& lod : mesh->lods)
+    {
+        std::vector<uint32_t> indices(mesh->indices.begin() + lod.firstIndex, mesh->indices.begin() + lod.firstIndex + lod.indexCount);
+
+        std::vector<uint32_t> clusters;
+        optimizeVertexCache(&indices, static_cast<uint32_t>(mesh->vertices.size()), &clusters);
+        if (reorderForOverdraw)
+        {
+            optimizeOverdraw(&indices, mesh->vertices, clusters);
+        }
+
+        std::copy(indices.begin(), indices.end(), mesh->indices.begin() + lod.firstIndex);
+    }
+
+    // Full detail comes first in index data - vertices end up in its order, coarser levels use a subset of them
+    optimizeVertexFetch(mesh);
+
+    stats.after = analyzeVertexCache(std::vector<uint32_t>(mesh->indices.begin(), mesh->indices.begin() + mesh->lods[0].indexCount),
+        static_cast<uint32_t>(mesh->vertices.size()));
+    stats.lodCount = static_cast<uint32_t>(mesh->lods.size());
+    return stats;
+}
+
+uint32_t MeshOptimizer::weldVertices(MeshData* mesh)
+{
+    // Hash of raw bytes, equality on raw bytes too - only exact duplicates are merged
+    struct VertexHash {
+        size_t operator()(const Vertex& vertex) const
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < sizeof(Vertex); i++)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+    struct VertexEqual {
+        bool operator()(const Vertex& a, const Vertex& b) const
+        {
+            return memcmp(&a, &b, sizeof(Vertex)) == 0;
+        }
+    };
+
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> uniqueVertices;
+    std::vector<uint32_t> remap(mesh->vertices.size());
+    std::vector<Vertex> welded;
+
+    for (size_t i = 0; i < mesh->vertices.size(); i++)
+    {
+        auto inserted = uniqueVertices.insert({ mesh->vertices[i], static_cast<uint32_t>(welded.size()) });
+        if (inserted.second)
+        {
+            welded.push_back(mesh->vertices[i]);
+        }
+        remap[i] = inserted.first->second;
+    }
+
+    for (auto& index : mesh->indices)
+    {
+        index = remap[index];
+    }
+
+    uint32_t removed = static_cast<uint32_t>(mesh->vertices.size() - welded.size());
+    mesh->vertices = std::move(welded);
+    return removed;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>* indices, uint32_t vertexCount, std::vector<uint32_t>* clusters)
+{
+    const std::vector<uint32_t>& input = *indices;
+    uint32_t triangleCount = static_cast<uint32_t>(input.size() / 3);
+
+    // Triangles using each vertex (compressed adjacency lists)
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : input)
+    {
+        liveTriangles[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(input.size());
+    std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            adjacency[adjacencyFill[input[t * 3 + c]]++] = t;
+        }
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(input.size());
+
+    if (clusters)
+    {
+        clusters->clear();
+    }
+
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    uint32_t cursor = 0;                        // Scan position for vertices with live triangles once dead end stack is empty
+    int64_t fanning = vertexCount > 0 ? 0 : -1;
+    bool jumped = true;
+
+    while (fanning >= 0)
+    {
+        uint32_t vertex = static_cast<uint32_t>(fanning);
+        candidates.clear();
+
+        if (jumped && clusters && adjacencyOffsets[vertex] != adjacencyOffsets[vertex + 1])
+        {
+            clusters->push_back(static_cast<uint32_t>(output.size() / 3));
+        }
+
+        // Emit every remaining triangle around fanning vertex
+        for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+        {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                uint32_t corner = input[triangle * 3 + c];
+                output.push_back(corner);
+                deadEnds.push_back(corner);
+                candidates.push_back(corner);
+                liveTriangles[corner]--;
+
+                // Not in cache - gets transformed and enters it
+                if (time - cacheTime[corner] > VERTEX_CACHE_SIZE)
+                {
+                    cacheTime[corner] = time;
+                    time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // Next fanning vertex - candidate that will still be in cache after its triangles are emitted, oldest first
+        fanning = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t candidate : candidates)
+        {
+            if (liveTriangles[candidate] == 0)
+            {
+                continue;
+            }
+
+            int64_t priority = 0;
+            if (time - cacheTime[candidate] + 2 * liveTriangles[candidate] <= VERTEX_CACHE_SIZE)
+            {
+                priority = time - cacheTime[candidate];
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanning = candidate;
+            }
+        }
+
+        jumped = fanning < 0;
+        if (fanning < 0)
+        {
+            // Dead end - most recently referenced vertex with live triangles, then any vertex with live triangles
+            while (!deadEnds.empty() && fanning < 0)
+            {
+                uint32_t deadEnd = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[deadEnd] > 0)
+                {
+                    fanning = deadEnd;
+                }
+            }
+            while (fanning < 0 && cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0)
+                {
+                    fanning = cursor;
+                }
+                cursor++;
+            }
+        }
+    }
+
+    *indices = std::move(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>* indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters)
+{
+    uint32_t triangleCount = static_cast<uint32_t>(indices->size() / 3);
+    if (triangleCount == 0 || clusters.empty())
+    {
+        return;
+    }
+
+    // Merge small clusters into following ones
+    std::vector<uint32_t> starts;
+    for (uint32_t cluster : clusters)
+    {
+        if (starts.empty() || cluster - starts.back() >= OVERDRAW_MIN_CLUSTER)
+        {
+            starts.push_back(cluster);
+        }
+    }
+    starts[0] = 0;
+
+    struct Cluster {
+        uint32_t begin;
+        uint32_t end;
+        float sortKey;
+    };
+
+    // Mesh centroid - average of triangle centroids weighted by area
+    const std::vector<uint32_t>& input = *indices;
+    float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    std::vector<float> triangleData(triangleCount * 7);     // Centroid (3), area weighted normal (3), area
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        const glm::vec3& a = vertices[input[t * 3]].pos;
+        const glm::vec3& b = vertices[input[t * 3 + 1]].pos;
+        const glm::vec3& c = vertices[input[t * 3 + 2]].pos;
+
+        float ab[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+        float ac[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+        float* data = &triangleData[t * 7];
+        data[0] = (a.x + b.x + c.x) / 3.0f;
+        data[1] = (a.y + b.y + c.y) / 3.0f;
+        data[2] = (a.z + b.z + c.z) / 3.0f;
+        data[3] = ab[1] * ac[2] - ab[2] * ac[1];
+        data[4] = ab[2] * ac[0] - ab[0] * ac[2];
+        data[5] = ab[0] * ac[1] - ab[1] * ac[0];
+        data[6] = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]) * 0.5f;
+
+        for (int i = 0; i < 3; i++)
+        {
+            meshCenter[i] += data[i] * data[6];
+        }
+        meshArea += data[6];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        meshCenter[i] = meshArea > 0.0f ? meshCenter[i] / meshArea : 0.0f;
+    }
+
+    // Sort key - how far cluster faces out of mesh: dot(cluster center - mesh center, cluster normal)
+    std::vector<Cluster> sortedClusters;
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        Cluster cluster;
+        cluster.begin = starts[i];
+        cluster.end = i + 1 < starts.size() ? starts[i + 1] : triangleCount;
+
+        float center[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (uint32_t t = cluster.begin; t < cluster.end; t++)
+        {
+            const float* data = &triangleData[t * 7];
+            for (int j = 0; j < 3; j++)
+            {
+                center[j] += data[j] * data[6];
+                normal[j] += data[3 + j];
+            }
+            area += data[6];
+        }
+
+        float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        cluster.sortKey = 0.0f;
+        if (area > 0.0f && normalLength > 0.0f)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                cluster.sortKey += (center[j] / area - meshCenter[j]) * normal[j] / normalLength;
+            }
+        }
+
+        sortedClusters.push_back(cluster);
+    }
+
+    // Outward facing clusters first - they tend to occlude the rest
+    std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices->size());
+    for (const auto& cluster : sortedClusters)
+    {
+        output.insert(output.end(), input.begin() + cluster.begin * 3, input.begin() + cluster.end * 3);
+    }
+
+    *indices = std::move(output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData* mesh)
+{
+    const uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> remap(mesh->vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(mesh->vertices.size());
+
+    for (auto& index : mesh->indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<uint32_t>(ordered.size());
+            ordered.push_back(mesh->vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    mesh->vertices = std::move(ordered);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty())
+    {
+        return stats;
+    }
+
+    // FIFO - a hit doesn't refresh entry, like post-transform caches of most hardware
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    uint32_t uniqueVertices = 0;
+
+    for (uint32_t index : indices)
+    {
+        if (time - cacheTime[index] > cacheSize)
+        {
+            cacheTime[index] = time;
+            time++;
+            misses++;
+        }
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / uniqueVertices;
+    return stats;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "MeshData.h"
+#include "MeshSimplifier.h"
+
+const uint32_t VERTEX_CACHE_SIZE = 16;          // Post-transform cache entries assumed by reordering and simulation
+
+// Result of simulating a FIFO post-transform vertex cache over index buffer
+struct VertexCacheStats {
+    float acmr = 0.0f;                          // Average cache miss ratio - transformed vertices per triangle (0.5 at best, 3 at worst)
+    float atvr = 0.0f;                          // Average transform to vertex ratio - 1 means every vertex is transformed once
+};
+
+struct MeshOptimizationStats {
+    uint32_t weldedVertices = 0;                // Duplicates removed
+    VertexCacheStats before;                    // Of full detail level
+    VertexCacheStats after;
+    uint32_t lodCount = 1;
+};
+
+// Mesh processing run at import / cook time - nothing here touches the GPU.
+// Order of passes matters: weld, LOD generation, triangle order for vertex cache, cluster order for overdraw, vertex order for fetch.
+class MeshOptimizer
+{
+public:
+    // All passes, returns cache stats before and after - LODs are generated unless mesh has them already (maxLods 1 - none)
+    static MeshOptimizationStats optimize(MeshData* mesh, uint32_t maxLods = MAX_MESH_LODS, bool reorderForOverdraw = true);
+
+    // Merge bitwise identical vertices, returns number removed
+    static uint32_t weldVertices(MeshData* mesh);
+
+    // Tipsify (Sander, Nehab, Barczak 2007) - triangles reordered to fan around vertices still in cache
+    // Triangle indices where reordering had to jump to a vertex out of cache are written to clusters (first is 0)
+    static void optimizeVertexCache(std::vector<uint32_t>* indices, uint32_t vertexCount, std::vector<uint32_t>* clusters = nullptr);
+
+    // Clusters (from optimizeVertexCache) sorted so outward facing parts of mesh come first - view independent overdraw reduction
+    // that keeps triangle order inside clusters, so vertex cache efficiency is almost unchanged
+    static void optimizeOverdraw(std::vector<uint32_t>* indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters);
+
+    // Vertices reordered by first use in index buffer (unused ones dropped) - vertex fetch reads memory mostly sequentially
+    static void optimizeVertexFetch(MeshData* mesh);
+
+    // CPU side FIFO cache simulation - measures reordering without a GPU
+    static VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+};
@@ -0,0 +1,337 @@
+#include "MeshSimplifier.h"
+
+// Symmetric 4x4 matrix of plane equations - vTQv is sum of squared distances of v to planes
+struct Quadric {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    double planes;                              // Number of planes summed
+
+    void add(const Quadric& other)
+    {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        planes += other.planes;
+    }
+
+    // Mean squared distance to planes - comparable between vertices with different numbers of triangles, root is a distance
+    double evaluate(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double sum = x * x * a2 + 2.0 * x * y * ab + 2.0 * x * z * ac + 2.0 * x * ad
+            + y * y * b2 + 2.0 * y * z * bc + 2.0 * y * bd
+            + z * z * c2 + 2.0 * z * cd
+            + d2;
+        return planes > 0.0 ? std::max(sum, 0.0) / planes : 0.0;
+    }
+};
+
+struct Collapse {
+    uint32_t from;                              // Vertex index removed
+    uint32_t to;                                // Vertex index it is replaced with
+    double cost;
+};
+
+static void triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, double* normal)
+{
+    double ab[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+    double ac[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+    normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+    normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+    normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+    float maxError, float* resultError)
+{
+    std::vector<uint32_t> result = indices;
+    double maxCost = static_cast<double>(maxError) * maxError;
+    double largestCost = 0.0;
+
+    // Vertices at same position share one position id - topology and quadrics are per position, not per vertex
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const
+        {
+            uint32_t bits[3];
+            memcpy(bits, &p.x, sizeof(float));
+            memcpy(bits + 1, &p.y, sizeof(float));
+            memcpy(bits + 2, &p.z, sizeof(float));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+    struct PositionEqual {
+        bool operator()(const glm::vec3& a, const glm::vec3& b) const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+
+    std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> positionIds;
+    std::vector<uint32_t> positionOf(vertices.size());
+    std::vector<uint32_t> verticesAtPosition;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        auto inserted = positionIds.insert({ vertices[i].pos, static_cast<uint32_t>(verticesAtPosition.size()) });
+        if (inserted.second)
+        {
+            verticesAtPosition.push_back(0);
+        }
+        positionOf[i] = inserted.first->second;
+    }
+
+    // Seam positions (more than one vertex in use there) are locked
+    uint32_t positionCount = static_cast<uint32_t>(verticesAtPosition.size());
+    std::vector<bool> locked(positionCount, false);
+    {
+        std::vector<uint32_t> usedVertex(positionCount, UINT32_MAX);
+        for (uint32_t index : indices)
+        {
+            uint32_t position = positionOf[index];
+            if (usedVertex[position] == UINT32_MAX)
+            {
+                usedVertex[position] = index;
+            }
+            else if (usedVertex[position] != index)
+            {
+                locked[position] = true;
+            }
+        }
+    }
+
+    // Border positions - edge used by a single triangle - are locked too
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                uint64_t a = positionOf[indices[t + e]];
+                uint64_t b = positionOf[indices[t + (e + 1) % 3]];
+                edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+            }
+        }
+        for (const auto& edge : edgeUses)
+        {
+            if (edge.second == 1)
+            {
+                locked[static_cast<uint32_t>(edge.first >> 32)] = true;
+                locked[static_cast<uint32_t>(edge.first & 0xFFFFFFFF)] = true;
+            }
+        }
+    }
+
+    // Plane of every triangle added to quadrics of its corners
+    std::vector<Quadric> quadrics(positionCount, Quadric{});
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const glm::vec3& a = vertices[indices[t]].pos;
+        double normal[3];
+        triangleNormal(a, vertices[indices[t + 1]].pos, vertices[indices[t + 2]].pos, normal);
+        double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length == 0.0)
+        {
+            continue;
+        }
+
+        double n[3] = { normal[0] / length, normal[1] / length, normal[2] / length };
+        double d = -(n[0] * a.x + n[1] * a.y + n[2] * a.z);
+        Quadric plane = { n[0] * n[0], n[0] * n[1], n[0] * n[2], n[0] * d, n[1] * n[1], n[1] * n[2], n[1] * d, n[2] * n[2], n[2] * d, d * d, 1.0 };
+        for (int c = 0; c < 3; c++)
+        {
+            quadrics[positionOf[indices[t + c]]].add(plane);
+        }
+    }
+
+    // Passes of independent collapses - cheapest first, each position changed at most once per pass
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<bool> touched(positionCount);
+    std::vector<uint32_t> adjacencyOffsets(positionCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    while (result.size() > targetIndexCount)
+    {
+        size_t triangleCount = result.size() / 3;
+
+        // Triangles around every position
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result)
+        {
+            adjacencyOffsets[positionOf[index] + 1]++;
+        }
+        for (uint32_t p = 0; p < positionCount; p++)
+        {
+            adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+        }
+        adjacency.resize(result.size());
+        std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                adjacency[adjacencyFill[positionOf[result[t * 3 + c]]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        // Cheaper direction of every edge that can collapse
+        collapses.clear();
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                uint32_t a = result[t * 3 + e];
+                uint32_t b = result[t * 3 + (e + 1) % 3];
+                uint32_t positionA = positionOf[a];
+                uint32_t positionB = positionOf[b];
+
+                Quadric quadric = quadrics[positionA];
+                quadric.add(quadrics[positionB]);
+
+                Collapse collapse = { a, b, DBL_MAX };
+                if (!locked[positionA])
+                {
+                    collapse.cost = quadric.evaluate(vertices[b].pos);
+                }
+                if (!locked[positionB])
+                {
+                    double cost = quadric.evaluate(vertices[a].pos);
+                    if (cost < collapse.cost)
+                    {
+                        collapse = { b, a, cost };
+                    }
+                }
+
+                if (collapse.cost <= maxCost)
+                {
+                    collapses.push_back(collapse);
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        for (size_t i = 0; i < remap.size(); i++)
+        {
+            remap[i] = static_cast<uint32_t>(i);
+        }
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t remainingTriangles = triangleCount;
+        size_t targetTriangles = targetIndexCount / 3;
+        uint32_t collapseCount = 0;
+
+        for (const auto& collapse : collapses)
+        {
+            if (remainingTriangles <= targetTriangles)
+            {
+                break;
+            }
+
+            uint32_t from = positionOf[collapse.from];
+            uint32_t to = positionOf[collapse.to];
+            if (touched[from] || touched[to])
+            {
+                continue;
+            }
+
+            // Triangles that stay must not flip over
+            const glm::vec3& target = vertices[collapse.to].pos;
+            bool flips = false;
+            uint32_t removed = 0;
+            for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flips; a++)
+            {
+                const uint32_t* triangle = &result[adjacency[a] * 3];
+                uint32_t positions[3] = { positionOf[triangle[0]], positionOf[triangle[1]], positionOf[triangle[2]] };
+                if (positions[0] == to || positions[1] == to || positions[2] == to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                glm::vec3 corners[3] = { vertices[triangle[0]].pos, vertices[triangle[1]].pos, vertices[triangle[2]].pos };
+                double before[3], after[3];
+                triangleNormal(corners[0], corners[1], corners[2], before);
+                for (int c = 0; c < 3; c++)
+                {
+                    if (positions[c] == from)
+                    {
+                        corners[c] = target;
+                    }
+                }
+                triangleNormal(corners[0], corners[1], corners[2], after);
+                flips = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0;
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            // Whole neighbourhood is frozen for rest of pass - adjacency of its positions is stale now
+            for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    touched[positionOf[result[adjacency[a] * 3 + c]]] = true;
+                }
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[to].add(quadrics[from]);
+            largestCost = std::max(largestCost, collapse.cost);
+            remainingTriangles -= removed;
+            collapseCount++;
+        }
+
+        if (collapseCount == 0)
+        {
+            break;
+        }
+
+        // Collapsed triangles have two corners at one position now
+        size_t written = 0;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            uint32_t a = remap[result[t * 3]];
+            uint32_t b = remap[result[t * 3 + 1]];
+            uint32_t c = remap[result[t * 3 + 2]];
+            if (positionOf[a] != positionOf[b] && positionOf[b] != positionOf[c] && positionOf[c] != positionOf[a])
+            {
+                result[written++] = a;
+                result[written++] = b;
+                result[written++] = c;
+            }
+        }
+        result.resize(written);
+    }
+
+    if (resultError)
+    {
+        *resultError = static_cast<float>(std::sqrt(largestCost));
+    }
+
+    return result;
+}
+
+void MeshSimplifier::generateLods(MeshData* mesh, uint32_t maxLods)
+{
+    mesh->lods.clear();
+    mesh->lods.push_back({ 0, static_cast<uint32_t>(mesh->indices.size()), 0.0f });
+
+    // Each level is simplified from previous one - errors along chain add up
+    std::vector<uint32_t> previous = mesh->indices;
+    float chainError = 0.0f;
+    while (mesh->lods.size() < maxLods && previous.size() / 3 / 2 >= MIN_LOD_TRIANGLES)
+    {
+        float error;
+        std::vector<uint32_t> simplified = simplify(mesh->vertices, previous, previous.size() / 3 / 2 * 3, FLT_MAX, &error);
+        if (simplified.size() > previous.size() * MIN_LOD_REDUCTION)
+        {
+            break;
+        }
+
+        chainError += error;
+        mesh->lods.push_back({ static_cast<uint32_t>(mesh->indices.size()), static_cast<uint32_t>(simplified.size()), chainError });
+        mesh->indices.insert(mesh->indices.end(), simplified.begin(), simplified.end());
+        previous = std::move(simplified);
+    }
+}
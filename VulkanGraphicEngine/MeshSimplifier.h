@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "MeshData.h"
+
+const uint32_t MIN_LOD_TRIANGLES = 64;          // LOD chain stops before levels get smaller than this
+const float MIN_LOD_REDUCTION = 0.8f;           // Level is dropped when simplification couldn't get it below this fraction of previous one
+
+// Quadric error metric simplification (Garland, Heckbert 1997).
+// Edges collapse onto one of their own vertices, so every LOD indexes the same vertex buffer as full mesh.
+// Vertices on open borders and on seams (same position split by importer for different UVs / colours) never move - LODs stay crack free.
+class MeshSimplifier
+{
+public:
+    // Indices of mesh with at most targetIndexCount indices, or as close to it as collapses with error up to maxError get
+    // Error (mesh space distance) of simplified mesh is written to resultError
+    static std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+        float maxError = FLT_MAX, float* resultError = nullptr);
+
+    // Fills mesh.lods - LOD 0 is mesh as it is, each further level has about half of triangles of previous one and its indices are appended
+    static void generateLods(MeshData* mesh, uint32_t maxLods = MAX_MESH_LODS);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <array>
+
+#include "Utilities.h"
+#include "StagingRing.h"
+
+// Generates full mip chain of an image from its first level.
+// Uses vkCmdBlitImage chain when format supports linear blits, otherwise a compute shader averaging 2x2 texels.
+// Commands have to be recorded on a graphics capable queue.
+class MipGenerator
+{
+public:
+    MipGenerator();
+    MipGenerator(VkPhysicalDevice physicalDevice, VkDevice device, const AssetArchive* archive = nullptr);
+
+    bool supportsBlit(VkFormat format);
+
+    // Usage image has to be created with for generation to work on given format
+    VkImageUsageFlags getRequiredUsage(VkFormat format);
+
+    // All levels have to be in TRANSFER_DST_OPTIMAL with level 0 written, all of them end up SHADER_READ_ONLY_OPTIMAL
+    void record(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+    // Compute resources recorded since last call are used by upload with given token - freed once it completes
+    void endBatch(UploadToken token, StagingRing* stagingRing);
+
+    void destroy();
+
+    ~MipGenerator();
+
+private:
+    // Image views and descriptor pools of compute path, alive until their upload finishes
+    struct ComputeResources {
+        UploadToken token;
+        std::vector<VkImageView> views;
+        std::vector<VkDescriptorPool> descriptorPools;  // One per image, sized for its levels - its sets go with it
+    };
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+    const AssetArchive* archive = nullptr;         // Compute shader source, disk when nullptr
+
+    // Compute fallback - created on first use
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    ComputeResources recording;                     // Resources of commands not submitted yet
+    std::vector<ComputeResources> inFlight;
+
+    void recordBlit(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels);
+    void recordCompute(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+    void createComputePipeline();
+    VkDescriptorPool createDescriptorPool(uint32_t setCount);
+    void freeResources(ComputeResources& resources);
+};
@@ -0,0 +1,446 @@
+#include "ModelImporter.h"
+
+#include <fstream>
+#include <unordered_map>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <atomic>
+
+const int32_t OBJ_NO_INDEX = INT32_MIN;        // Face corner without texture coordinate
+const size_t OBJ_CHUNKS_PER_THREAD = 4;         // Lines differ a lot in cost - threads taking more, smaller chunks finish closer together
+
+// Index as written by chunk parser: absolute ones are 0 based, relative ones are offsets from first attribute of chunk
+// (negative when they reach into earlier chunks) - turned into absolute ones once counts of earlier chunks are known
+struct ObjCorner {
+    int32_t position;
+    int32_t texCoord;
+    bool positionRelative;
+    bool texCoordRelative;
+};
+
+// Corners from firstCorner until next group use material
+struct ObjGroup {
+    size_t firstCorner;
+    std::string material;
+};
+
+// Result of parsing one range of lines
+struct ObjChunk {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colours;
+    std::vector<glm::vec2> texCoords;
+    std::vector<ObjCorner> corners;             // Triangles, three corners each
+    std::vector<ObjGroup> groups;               // Corners before first group continue material of previous chunk
+    std::vector<std::string> materialLibraries;
+};
+
+static std::vector<char> readTextFile(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open the file: " + filename);
+    }
+
+    // Terminated, so number parsing can never run past end of data
+    std::vector<char> data(static_cast<size_t>(file.tellg()) + 1, '\0');
+    file.seekg(0);
+    file.read(data.data(), data.size() - 1);
+
+    return data;
+}
+
+static const char* skipSpaces(const char* text)
+{
+    while (*text == ' ' || *text == '\t')
+    {
+        text++;
+    }
+    return text;
+}
+
+// Rest of line without trailing whitespace
+static std::string readName(const char* text, const char* lineEnd)
+{
+    text = skipSpaces(text);
+    while (lineEnd > text && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t' || lineEnd[-1] == '\r'))
+    {
+        lineEnd--;
+    }
+    return std::string(text, lineEnd);
+}
+
+// Directory part of path including separator, empty if there is none
+static std::string getDirectory(const std::string& path)
+{
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+}
+
+// Parses "p", "p/t", "p//n" or "p/t/n" - relative indices are turned into offsets from start of chunk
+static const char* parseCorner(const char* text, const ObjChunk& chunk, ObjCorner* corner)
+{
+    char* end;
+    long position = strtol(text, &end, 10);
+    if (end == text || position == 0)
+    {
+        return nullptr;
+    }
+    text = end;
+
+    long texCoord = 0;
+    if (*text == '/')
+    {
+        text++;
+        texCoord = strtol(text, &end, 10);
+        text = end;
+
+        // Normal isn't part of vertex format - skipped
+        if (*text == '/')
+        {
+            text++;
+            strtol(text, &end, 10);
+            text = end;
+        }
+    }
+
+    corner->positionRelative = position < 0;
+    corner->position = position > 0 ? static_cast<int32_t>(position - 1) : static_cast<int32_t>(chunk.positions.size() + position);
+    corner->texCoordRelative = texCoord < 0;
+    if (texCoord == 0)
+    {
+        corner->texCoord = OBJ_NO_INDEX;
+    }
+    else
+    {
+        corner->texCoord = texCoord > 0 ? static_cast<int32_t>(texCoord - 1) : static_cast<int32_t>(chunk.texCoords.size() + texCoord);
+    }
+
+    return text;
+}
+
+static void parseChunk(const char* begin, const char* end, ObjChunk* chunk)
+{
+    std::vector<ObjCorner> polygon;
+
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+        {
+            lineEnd = end;
+        }
+
+        const char* text = skipSpaces(line);
+        char* next;
+
+        if (text[0] == 'v' && (text[1] == ' ' || text[1] == '\t'))
+        {
+            glm::vec3 position;
+            position.x = strtof(text + 2, &next);
+            position.y = strtof(next, &next);
+            position.z = strtof(next, &next);
+
+            // Optional vertex colour after position (a single value is w coordinate, ignored)
+            glm::vec3 colour(1.0f);
+            float values[3];
+            int valueCount = 0;
+            const char* valueText = next;
+            while (valueCount < 3)
+            {
+                values[valueCount] = strtof(valueText, &next);
+                if (next == valueText || next > lineEnd)
+                {
+                    break;
+                }
+                valueText = next;
+                valueCount++;
+            }
+            if (valueCount == 3)
+            {
+                colour = glm::vec3(values[0], values[1], values[2]);
+            }
+
+            chunk->positions.push_back(position);
+            chunk->colours.push_back(colour);
+        }
+        else if (text[0] == 'v' && text[1] == 't')
+        {
+            glm::vec2 texCoord;
+            texCoord.x = strtof(text + 2, &next);
+            texCoord.y = strtof(next, &next);
+
+            // OBJ has origin of texture coordinates at bottom left, Vulkan images at top left
+            texCoord.y = 1.0f - texCoord.y;
+            chunk->texCoords.push_back(texCoord);
+        }
+        else if (text[0] == 'f' && (text[1] == ' ' || text[1] == '\t'))
+        {
+            polygon.clear();
+
+            const char* cornerText = skipSpaces(text + 2);
+            while (cornerText < lineEnd && *cornerText != '\r' && *cornerText != '\n' && *cornerText != '#')
+            {
+                ObjCorner corner;
+                cornerText = parseCorner(cornerText, *chunk, &corner);
+                if (!cornerText)
+                {
+                    throw std::runtime_error("Invalid OBJ face: " + readName(text, lineEnd));
+                }
+                polygon.push_back(corner);
+                cornerText = skipSpaces(cornerText);
+            }
+
+            // Fan triangulation - fine for convex polygons OBJ exporters write
+            for (size_t i = 2; i < polygon.size(); i++)
+            {
+                chunk->corners.push_back(polygon[0]);
+                chunk->corners.push_back(polygon[i - 1]);
+                chunk->corners.push_back(polygon[i]);
+            }
+        }
+        else if (strncmp(text, "usemtl", 6) == 0)
+        {
+            chunk->groups.push_back({ chunk->corners.size(), readName(text + 6, lineEnd) });
+        }
+        else if (strncmp(text, "mtllib", 6) == 0)
+        {
+            chunk->materialLibraries.push_back(readName(text + 6, lineEnd));
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+ModelImporter::ModelImporter()
+{
+
+}
+
+ModelImporter::~ModelImporter()
+{
+
+}
+
+ModelImporter::ModelImporter(ThreadPool* threadPool)
+{
+    this->threadPool = threadPool;
+}
+
+std::vector<MeshData> ModelImporter::importObj(const std::string& filename)
+{
+    std::vector<char> text = readTextFile(filename);
+    const char* data = text.data();
+    size_t size = text.size() - 1;
+
+    // Chunks end on line boundaries
+    size_t chunkCount = std::max<size_t>(1, std::min(threadPool->getThreadCount() * OBJ_CHUNKS_PER_THREAD, size / 4096));
+    std::vector<size_t> boundaries(chunkCount + 1, size);
+    boundaries[0] = 0;
+    for (size_t i = 1; i < chunkCount; i++)
+    {
+        size_t boundary = std::max(size * i / chunkCount, boundaries[i - 1]);
+        const char* lineEnd = static_cast<const char*>(memchr(data + boundary, '\n', size - boundary));
+        boundaries[i] = lineEnd ? static_cast<size_t>(lineEnd - data) + 1 : size;
+    }
+
+    // parallelFor would hand every thread a fixed run of chunks - instead each thread takes next chunk nobody parses yet
+    std::vector<ObjChunk> chunks(chunkCount);
+    std::atomic<size_t> nextChunk(0);
+    threadPool->parallelFor(std::min(chunkCount, threadPool->getThreadCount()), [&](size_t, size_t)
+    {
+        for (size_t i = nextChunk++; i < chunkCount; i = nextChunk++)
+        {
+            parseChunk(data + boundaries[i], data + boundaries[i + 1], &chunks[i]);
+        }
+    });
+
+    // Everything parsed is in chunks now
+    text.clear();
+    text.shrink_to_fit();
+
+    // Merge - attributes keep chunk order, relative indices become absolute
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colours;
+    std::vector<glm::vec2> texCoords;
+    std::vector<std::string> materialLibraries;
+
+    // Corner ranges of every material, in file order
+    struct CornerRange {
+        size_t chunk;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<std::string> materialOrder;
+    std::map<std::string, std::vector<CornerRange>> materialRanges;
+    std::string currentMaterial;
+
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+        ObjChunk& chunk = chunks[c];
+
+        int32_t positionBase = static_cast<int32_t>(positions.size());
+        int32_t texCoordBase = static_cast<int32_t>(texCoords.size());
+        for (auto& corner : chunk.corners)
+        {
+            // Index reaching before first attribute of file stays negative - rejected as out of range below
+            if (corner.positionRelative)
+            {
+                corner.position += positionBase;
+            }
+            if (corner.texCoordRelative)
+            {
+                corner.texCoord += texCoordBase;
+            }
+        }
+
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        colours.insert(colours.end(), chunk.colours.begin(), chunk.colours.end());
+        texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+        materialLibraries.insert(materialLibraries.end(), chunk.materialLibraries.begin(), chunk.materialLibraries.end());
+
+        size_t rangeBegin = 0;
+        for (size_t g = 0; g <= chunk.groups.size(); g++)
+        {
+            size_t rangeEnd = g < chunk.groups.size() ? chunk.groups[g].firstCorner : chunk.corners.size();
+            if (rangeEnd > rangeBegin)
+            {
+                if (materialRanges.find(currentMaterial) == materialRanges.end())
+                {
+                    materialOrder.push_back(currentMaterial);
+                }
+                materialRanges[currentMaterial].push_back({ c, rangeBegin, rangeEnd });
+            }
+
+            if (g < chunk.groups.size())
+            {
+                currentMaterial = chunk.groups[g].material;
+                rangeBegin = rangeEnd;
+            }
+        }
+    }
+
+    std::map<std::string, ObjMaterial> materials;
+    for (const auto& library : materialLibraries)
+    {
+        std::map<std::string, ObjMaterial> libraryMaterials = loadMaterials(getDirectory(filename) + library);
+        materials.insert(libraryMaterials.begin(), libraryMaterials.end());
+    }
+
+    // Build vertices of every material in parallel - corners sharing position and texture coordinate share vertex
+    std::vector<MeshData> meshes(materialOrder.size());
+    threadPool->parallelFor(materialOrder.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t m = begin; m < end; m++)
+        {
+            ObjMaterial material;
+            auto found = materials.find(materialOrder[m]);
+            if (found != materials.end())
+            {
+                material = found->second;
+            }
+
+            MeshData& mesh = meshes[m];
+            mesh.texture = material.texture;
+
+            std::unordered_map<uint64_t, uint32_t> vertexIndices;
+            for (const auto& range : materialRanges.at(materialOrder[m]))
+            {
+                for (size_t i = range.begin; i < range.end; i++)
+                {
+                    const ObjCorner& corner = chunks[range.chunk].corners[i];
+                    if (corner.position < 0 || corner.position >= static_cast<int32_t>(positions.size()) ||
+                        (corner.texCoord != OBJ_NO_INDEX && (corner.texCoord < 0 || corner.texCoord >= static_cast<int32_t>(texCoords.size()))))
+                    {
+                        throw std::runtime_error("OBJ face index is out of range (" + filename + ")!");
+                    }
+
+                    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(corner.position)) << 32) | static_cast<uint32_t>(corner.texCoord);
+                    auto inserted = vertexIndices.insert({ key, static_cast<uint32_t>(mesh.vertices.size()) });
+                    if (inserted.second)
+                    {
+                        Vertex vertex;
+                        vertex.pos = positions[corner.position];
+                        vertex.col = colours[corner.position] * material.colour;
+                        vertex.tex = corner.texCoord != OBJ_NO_INDEX ? texCoords[corner.texCoord] : glm::vec2(0.0f);
+                        mesh.vertices.push_back(vertex);
+                    }
+
+                    mesh.indices.push_back(inserted.first->second);
+                }
+            }
+        }
+    });
+
+    return meshes;
+}
+
+std::vector<std::string> ModelImporter::getMaterialLibraries(const std::string& filename, const std::vector<char>& text)
+{
+    std::vector<std::string> libraries;
+    const char* line = text.data();
+    const char* end = text.data() + text.size();
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+        {
+            lineEnd = end;
+        }
+
+        const char* lineText = skipSpaces(line);
+        if (lineEnd - lineText >= 6 && strncmp(lineText, "mtllib", 6) == 0)
+        {
+            libraries.push_back(getDirectory(filename) + readName(lineText + 6, lineEnd));
+        }
+
+        line = lineEnd + 1;
+    }
+
+    return libraries;
+}
+
+std::map<std::string, ModelImporter::ObjMaterial> ModelImporter::loadMaterials(const std::string& filename)
+{
+    std::map<std::string, ObjMaterial> materials;
+
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        // Model still loads, only without textures
+        printf("WARNING: Material library not found: %s\n", filename.c_str());
+        return materials;
+    }
+
+    ObjMaterial* material = nullptr;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const char* text = skipSpaces(line.c_str());
+        const char* lineEnd = line.c_str() + line.size();
+
+        if (strncmp(text, "newmtl", 6) == 0)
+        {
+            material = &materials[readName(text + 6, lineEnd)];
+        }
+        else if (material && strncmp(text, "Kd", 2) == 0)
+        {
+            char* next;
+            material->colour.x = strtof(text + 2, &next);
+            material->colour.y = strtof(next, &next);
+            material->colour.z = strtof(next, &next);
+        }
+        else if (material && strncmp(text, "map_Kd", 6) == 0)
+        {
+            // Options before path aren't supported - path is last word, textures are looked up by name in Textures/
+            std::string path = readName(text + 6, lineEnd);
+            size_t nameStart = path.find_last_of("/\\ ");
+            material->texture = nameStart == std::string::npos ? path : path.substr(nameStart + 1);
+        }
+    }
+
+    return materials;
+}
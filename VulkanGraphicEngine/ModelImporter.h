@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "MeshData.h"
+#include "ThreadPool.h"
+
+const char* const MODEL_IMPORTER_VERSION = "obj-2";     // Part of cooked model hash - bump when imported geometry changes
+
+// Imports Wavefront OBJ models - one MeshData per material, textures come from map_Kd of MTL files.
+// Text is split into chunks parsed in parallel, per material geometry is then built in parallel too.
+// Supports v (with optional vertex colour), vt, f with any polygon size (fan triangulated) and negative indices, usemtl, mtllib.
+class ModelImporter
+{
+public:
+    ModelImporter();
+    ModelImporter(ThreadPool* threadPool);
+
+    std::vector<MeshData> importObj(const std::string& filename);
+
+    // Paths of MTL files importObj reads for OBJ file with given text - missing ones included
+    static std::vector<std::string> getMaterialLibraries(const std::string& filename, const std::vector<char>& text);
+
+    ~ModelImporter();
+
+private:
+    struct ObjMaterial {
+        std::string texture;
+        glm::vec3 colour = glm::vec3(1.0f);     // Kd, multiplies vertex colour
+    };
+
+    ThreadPool* threadPool;
+
+    std::map<std::string, ObjMaterial> loadMaterials(const std::string& filename);
+};
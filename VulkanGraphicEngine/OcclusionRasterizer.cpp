@@ -0,0 +1,491 @@
+#include "OcclusionRasterizer.h"
+
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OCCLUSION_RASTERIZER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+// Edges closer to horizontal than this are left to row range of triangle - their slope would overflow
+const float MIN_EDGE_HEIGHT = 1.0f / 65536.0f;
+const float OUTSIDE_EDGE = 1.0e30f;
+
+// Mask of count lowest bits, count 0 to 32
+static uint32_t lowBits(uint32_t count)
+{
+    return count >= 32 ? ~0u : (1u << count) - 1;
+}
+
+OcclusionRasterizer::OcclusionRasterizer()
+{
+
+}
+
+OcclusionRasterizer::OcclusionRasterizer(ThreadPool* threadPool, uint32_t width, uint32_t height)
+{
+    this->threadPool = threadPool;
+
+    tilesX = (width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH;
+    tilesY = (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+    this->width = tilesX * OCCLUSION_TILE_WIDTH;
+    this->height = tilesY * OCCLUSION_TILE_HEIGHT;
+
+    setKernel(CullKernel::Avx2);
+    clear();
+}
+
+OcclusionRasterizer::~OcclusionRasterizer()
+{
+
+}
+
+void OcclusionRasterizer::setKernel(CullKernel kernel)
+{
+    while (!FrustumCuller::isKernelSupported(kernel))
+    {
+        kernel = static_cast<CullKernel>(static_cast<uint32_t>(kernel) - 1);
+    }
+    this->kernel = kernel;
+}
+
+CullKernel OcclusionRasterizer::getKernel()
+{
+    return kernel;
+}
+
+void OcclusionRasterizer::clear()
+{
+    OcclusionTile emptyTile = {};
+    emptyTile.farthest = 1.0f;
+    emptyTile.workingFarthest = 0.0f;
+    tiles.assign(tilesX * tilesY, emptyTile);
+
+    clipVertices.clear();
+}
+
+void OcclusionRasterizer::addOccluder(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const glm::mat4& modelViewProjection)
+{
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        for (size_t j = 0; j < 3; j++)
+        {
+            if (indices[i + j] >= positions.size())
+            {
+                throw std::runtime_error("Occluder index is out of range!");
+            }
+            clipVertices.push_back(modelViewProjection * glm::vec4(positions[indices[i + j]], 1.0f));
+        }
+    }
+}
+
+void OcclusionRasterizer::rasterize()
+{
+    size_t triangleCount = clipVertices.size() / 3;
+    triangles.resize(triangleCount);
+    triangleValid.resize(triangleCount);
+
+    auto setup = [this](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            triangleValid[i] = setupTriangle(&clipVertices[i * 3], &triangles[i]) ? 1 : 0;
+        }
+    };
+
+    // Every tile row is owned by one thread and takes triangles in order - no locks, same result for any thread count
+    auto rasterizeRows = [this](size_t begin, size_t end)
+    {
+        for (size_t tileY = begin; tileY < end; tileY++)
+        {
+            rasterizeTileRow(static_cast<uint32_t>(tileY));
+        }
+    };
+
+    if (threadPool)
+    {
+        threadPool->parallelFor(triangleCount, setup);
+        threadPool->parallelFor(tilesY, rasterizeRows);
+    }
+    else
+    {
+        setup(0, triangleCount);
+        rasterizeRows(0, tilesY);
+    }
+}
+
+bool OcclusionRasterizer::isBoxVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelViewProjection) const
+{
+    // Screen rectangle and nearest depth of box corners - box crossing near plane is always visible
+    float minX = FLT_MAX;
+    float minY = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float maxY = -FLT_MAX;
+    float nearest = FLT_MAX;
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner((i & 1) != 0 ? boundsMax.x : boundsMin.x, (i & 2) != 0 ? boundsMax.y : boundsMin.y, (i & 4) != 0 ? boundsMax.z : boundsMin.z);
+        glm::vec4 clip = modelViewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w <= 0.0f || clip.z < 0.0f)
+        {
+            return true;
+        }
+
+        float x = (clip.x / clip.w * 0.5f + 0.5f) * width;
+        float y = (clip.y / clip.w * 0.5f + 0.5f) * height;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clip.z / clip.w);
+    }
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+    {
+        return false;
+    }
+
+    // Every pixel rectangle touches
+    uint32_t firstX = static_cast<uint32_t>(std::max(minX, 0.0f));
+    uint32_t firstY = static_cast<uint32_t>(std::max(minY, 0.0f));
+    uint32_t lastX = static_cast<uint32_t>(std::min(maxX, static_cast<float>(width - 1)));
+    uint32_t lastY = static_cast<uint32_t>(std::min(maxY, static_cast<float>(height - 1)));
+
+    for (uint32_t tileY = firstY / OCCLUSION_TILE_HEIGHT; tileY <= lastY / OCCLUSION_TILE_HEIGHT; tileY++)
+    {
+        uint32_t tileTop = tileY * OCCLUSION_TILE_HEIGHT;
+        uint32_t firstRow = std::max(firstY, tileTop) - tileTop;
+        uint32_t lastRow = std::min(lastY, tileTop + OCCLUSION_TILE_HEIGHT - 1) - tileTop;
+
+        for (uint32_t tileX = firstX / OCCLUSION_TILE_WIDTH; tileX <= lastX / OCCLUSION_TILE_WIDTH; tileX++)
+        {
+            const OcclusionTile& tile = tiles[tileY * tilesX + tileX];
+            if (nearest >= tile.farthest)
+            {
+                continue;
+            }
+
+            // In front of tile's farthest depth - still hidden if it only touches working layer pixels, which are nearer
+            if (nearest < tile.workingFarthest)
+            {
+                return true;
+            }
+
+            uint32_t tileLeft = tileX * OCCLUSION_TILE_WIDTH;
+            uint32_t firstColumn = std::max(firstX, tileLeft) - tileLeft;
+            uint32_t lastColumn = std::min(lastX, tileLeft + OCCLUSION_TILE_WIDTH - 1) - tileLeft;
+            uint32_t columns = lowBits(lastColumn + 1) & ~lowBits(firstColumn);
+            for (uint32_t row = firstRow; row <= lastRow; row++)
+            {
+                if ((columns & ~tile.mask[row]) != 0)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+uint32_t OcclusionRasterizer::getWidth()
+{
+    return width;
+}
+
+uint32_t OcclusionRasterizer::getHeight()
+{
+    return height;
+}
+
+uint32_t OcclusionRasterizer::getTriangleCount()
+{
+    return static_cast<uint32_t>(std::count(triangleValid.begin(), triangleValid.end(), 1));
+}
+
+const std::vector<OcclusionTile>& OcclusionRasterizer::getTiles()
+{
+    return tiles;
+}
+
+bool OcclusionRasterizer::setupTriangle(const glm::vec4* clip, Triangle* triangle) const
+{
+    glm::vec3 screen[3];
+    for (int i = 0; i < 3; i++)
+    {
+        if (clip[i].w <= 0.0f || clip[i].z < 0.0f)
+        {
+            return false;
+        }
+        screen[i] = glm::vec3((clip[i].x / clip[i].w * 0.5f + 0.5f) * width, (clip[i].y / clip[i].w * 0.5f + 0.5f) * height, clip[i].z / clip[i].w);
+    }
+
+    // Both windings are occluders - flipped to one where inside of every edge a -> b has (b - a) x (p - a) >= 0
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+    if (area == 0.0f)
+    {
+        return false;
+    }
+    if (area < 0.0f)
+    {
+        std::swap(screen[1], screen[2]);
+        area = -area;
+    }
+
+    float minX = std::min(screen[0].x, std::min(screen[1].x, screen[2].x));
+    float maxX = std::max(screen[0].x, std::max(screen[1].x, screen[2].x));
+    triangle->minY = std::min(screen[0].y, std::min(screen[1].y, screen[2].y));
+    triangle->maxY = std::max(screen[0].y, std::max(screen[1].y, screen[2].y));
+    if (maxX < 0.0f || triangle->maxY < 0.0f || minX >= width || triangle->minY >= height)
+    {
+        return false;
+    }
+
+    // Edge going down the screen bounds rows from right, going up from left
+    uint32_t leftCount = 0;
+    uint32_t rightCount = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        triangle->leftX[i] = -OUTSIDE_EDGE;
+        triangle->rightX[i] = OUTSIDE_EDGE;
+        triangle->leftY[i] = triangle->rightY[i] = 0.0f;
+        triangle->leftSlope[i] = triangle->rightSlope[i] = 0.0f;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        const glm::vec3& a = screen[i];
+        const glm::vec3& b = screen[(i + 1) % 3];
+        float edgeHeight = b.y - a.y;
+        if (std::abs(edgeHeight) < MIN_EDGE_HEIGHT)
+        {
+            continue;
+        }
+
+        float slope = (b.x - a.x) / edgeHeight;
+        if (edgeHeight > 0.0f)
+        {
+            triangle->rightX[rightCount] = a.x;
+            triangle->rightY[rightCount] = a.y;
+            triangle->rightSlope[rightCount++] = slope;
+        }
+        else
+        {
+            triangle->leftX[leftCount] = a.x;
+            triangle->leftY[leftCount] = a.y;
+            triangle->leftSlope[leftCount++] = slope;
+        }
+    }
+
+    // Sliver thinner than MIN_EDGE_HEIGHT - nothing would bound its rows
+    if (leftCount == 0 || rightCount == 0)
+    {
+        return false;
+    }
+
+    glm::vec3 edge1 = screen[1] - screen[0];
+    glm::vec3 edge2 = screen[2] - screen[0];
+    triangle->depthOrigin = screen[0];
+    triangle->depthX = (edge1.z * edge2.y - edge2.z * edge1.y) / area;
+    triangle->depthY = (edge1.x * edge2.z - edge2.x * edge1.z) / area;
+    triangle->maxDepth = std::max(screen[0].z, std::max(screen[1].z, screen[2].z));
+
+    triangle->firstTileX = static_cast<uint32_t>(std::max(minX, 0.0f)) / OCCLUSION_TILE_WIDTH;
+    triangle->lastTileX = static_cast<uint32_t>(std::min(maxX, static_cast<float>(width - 1))) / OCCLUSION_TILE_WIDTH;
+    triangle->firstTileY = static_cast<uint32_t>(std::max(triangle->minY, 0.0f)) / OCCLUSION_TILE_HEIGHT;
+    triangle->lastTileY = static_cast<uint32_t>(std::min(triangle->maxY, static_cast<float>(height - 1))) / OCCLUSION_TILE_HEIGHT;
+
+    return true;
+}
+
+void OcclusionRasterizer::rasterizeTileRow(uint32_t tileY)
+{
+    void (*cover)(const Triangle&, float, float, uint32_t*) = coverScalar;
+    if (kernel == CullKernel::Avx2)
+    {
+        cover = coverAvx2;
+    }
+    else if (kernel == CullKernel::Sse)
+    {
+        cover = coverSse;
+    }
+
+    float tileTop = static_cast<float>(tileY * OCCLUSION_TILE_HEIGHT);
+    float tileBottom = tileTop + OCCLUSION_TILE_HEIGHT;
+    uint32_t mask[OCCLUSION_TILE_HEIGHT];
+
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        const Triangle& triangle = triangles[i];
+        if (!triangleValid[i] || tileY < triangle.firstTileY || tileY > triangle.lastTileY)
+        {
+            continue;
+        }
+
+        for (uint32_t tileX = triangle.firstTileX; tileX <= triangle.lastTileX; tileX++)
+        {
+            OcclusionTile* tile = &tiles[tileY * tilesX + tileX];
+            float tileLeft = static_cast<float>(tileX * OCCLUSION_TILE_WIDTH);
+            float tileRight = tileLeft + OCCLUSION_TILE_WIDTH;
+
+            // Farthest depth of triangle inside tile - plane at tile corner it grows towards
+            float cornerX = triangle.depthX > 0.0f ? tileRight : tileLeft;
+            float cornerY = triangle.depthY > 0.0f ? tileBottom : tileTop;
+            float depth = triangle.depthOrigin.z + triangle.depthX * (cornerX - triangle.depthOrigin.x) + triangle.depthY * (cornerY - triangle.depthOrigin.y);
+            depth = std::min(depth, triangle.maxDepth);
+
+            // Nothing in tile is farther than triangle - it can't hide more
+            if (depth >= tile->farthest)
+            {
+                continue;
+            }
+
+            cover(triangle, tileLeft, tileTop, mask);
+            updateTile(tile, mask, depth);
+        }
+    }
+}
+
+void OcclusionRasterizer::updateTile(OcclusionTile* tile, const uint32_t mask[OCCLUSION_TILE_HEIGHT], float depth) const
+{
+    uint32_t covered = 0;
+    for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; row++)
+    {
+        covered |= mask[row];
+    }
+    if (covered == 0)
+    {
+        return;
+    }
+
+    // Working layer much farther than triangle - it is started again from triangle instead of pushing triangle back to it
+    if (tile->workingFarthest - depth > tile->farthest - tile->workingFarthest)
+    {
+        std::fill(tile->mask, tile->mask + OCCLUSION_TILE_HEIGHT, 0u);
+        tile->workingFarthest = 0.0f;
+    }
+
+    tile->workingFarthest = std::max(tile->workingFarthest, depth);
+    uint32_t full = ~0u;
+    for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; row++)
+    {
+        tile->mask[row] |= mask[row];
+        full &= tile->mask[row];
+    }
+
+    // Working layer covers whole tile - its depth is now farthest of tile, and it starts empty again
+    if (full == ~0u)
+    {
+        tile->farthest = tile->workingFarthest;
+        tile->workingFarthest = 0.0f;
+        std::fill(tile->mask, tile->mask + OCCLUSION_TILE_HEIGHT, 0u);
+    }
+}
+
+void OcclusionRasterizer::coverScalar(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT])
+{
+    float firstCenter = tileLeft + 0.5f;
+    for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; row++)
+    {
+        float y = tileTop + (static_cast<float>(row) + 0.5f);
+
+        // Row span relative to center of tile's first pixel
+        float start = std::max(triangle.leftX[0] + (y - triangle.leftY[0]) * triangle.leftSlope[0],
+            triangle.leftX[1] + (y - triangle.leftY[1]) * triangle.leftSlope[1]) - firstCenter;
+        float end = std::min(triangle.rightX[0] + (y - triangle.rightY[0]) * triangle.rightSlope[0],
+            triangle.rightX[1] + (y - triangle.rightY[1]) * triangle.rightSlope[1]) - firstCenter;
+
+        // First covered pixel ceil(start) = 32 - floor(32 - start), one past last floor(end) + 1 - clamped before
+        // truncation, so it rounds down like floor and both stay within [0, 32]
+        int32_t first = 32 - static_cast<int32_t>(std::min(std::max(32.0f - start, 0.0f), 32.0f));
+        int32_t last = static_cast<int32_t>(std::min(std::max(end, -1.0f), 31.0f) + 1.0f);
+
+        bool inside = y >= triangle.minY && y <= triangle.maxY;
+        mask[row] = inside ? lowBits(last) & ~lowBits(first) : 0;
+    }
+}
+
+#ifdef OCCLUSION_RASTERIZER_X86
+
+// Same operations as coverScalar, 4 rows at once. SSE2 has no per-lane shifts - 1 << n comes from float 2^n instead
+// (2^31 and 2^32 convert to 0x80000000, 32 is then patched to all bits).
+void OcclusionRasterizer::coverSse(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT])
+{
+    const __m128 firstCenter = _mm_set1_ps(tileLeft + 0.5f);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i thirtyTwo = _mm_set1_epi32(32);
+    const __m128i floatExponentBias = _mm_set1_epi32(127);
+
+    for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; row += 4)
+    {
+        __m128 y = _mm_add_ps(_mm_set1_ps(tileTop), _mm_set_ps(row + 3.5f, row + 2.5f, row + 1.5f, row + 0.5f));
+
+        __m128 left0 = _mm_add_ps(_mm_set1_ps(triangle.leftX[0]), _mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(triangle.leftY[0])), _mm_set1_ps(triangle.leftSlope[0])));
+        __m128 left1 = _mm_add_ps(_mm_set1_ps(triangle.leftX[1]), _mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(triangle.leftY[1])), _mm_set1_ps(triangle.leftSlope[1])));
+        __m128 right0 = _mm_add_ps(_mm_set1_ps(triangle.rightX[0]), _mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(triangle.rightY[0])), _mm_set1_ps(triangle.rightSlope[0])));
+        __m128 right1 = _mm_add_ps(_mm_set1_ps(triangle.rightX[1]), _mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(triangle.rightY[1])), _mm_set1_ps(triangle.rightSlope[1])));
+        __m128 start = _mm_sub_ps(_mm_max_ps(left0, left1), firstCenter);
+        __m128 end = _mm_sub_ps(_mm_min_ps(right0, right1), firstCenter);
+
+        __m128i first = _mm_sub_epi32(thirtyTwo, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(32.0f), start), _mm_setzero_ps()), _mm_set1_ps(32.0f))));
+        __m128i last = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(end, _mm_set1_ps(-1.0f)), _mm_set1_ps(31.0f)), _mm_set1_ps(1.0f)));
+
+        __m128i firstPower = _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(first, floatExponentBias), 23)));
+        __m128i lastPower = _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(last, floatExponentBias), 23)));
+        __m128i firstBits = _mm_or_si128(_mm_sub_epi32(firstPower, one), _mm_cmpeq_epi32(first, thirtyTwo));
+        __m128i lastBits = _mm_or_si128(_mm_sub_epi32(lastPower, one), _mm_cmpeq_epi32(last, thirtyTwo));
+
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(y, _mm_set1_ps(triangle.minY)), _mm_cmple_ps(y, _mm_set1_ps(triangle.maxY)));
+        __m128i rowMask = _mm_and_si128(_mm_andnot_si128(firstBits, lastBits), _mm_castps_si128(inside));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + row), rowMask);
+    }
+}
+
+// One lane per row - whole tile at once. Variable shift gives 0 for 1 << 32, so all bits for count 32 as well.
+AVX2_FUNCTION void OcclusionRasterizer::coverAvx2(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT])
+{
+    const __m256 firstCenter = _mm256_set1_ps(tileLeft + 0.5f);
+    const __m256i one = _mm256_set1_epi32(1);
+
+    __m256 y = _mm256_add_ps(_mm256_set1_ps(tileTop), _mm256_set_ps(7.5f, 6.5f, 5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f));
+
+    // No fused multiply-add - it would round differently from scalar kernel
+    __m256 left0 = _mm256_add_ps(_mm256_set1_ps(triangle.leftX[0]), _mm256_mul_ps(_mm256_sub_ps(y, _mm256_set1_ps(triangle.leftY[0])), _mm256_set1_ps(triangle.leftSlope[0])));
+    __m256 left1 = _mm256_add_ps(_mm256_set1_ps(triangle.leftX[1]), _mm256_mul_ps(_mm256_sub_ps(y, _mm256_set1_ps(triangle.leftY[1])), _mm256_set1_ps(triangle.leftSlope[1])));
+    __m256 right0 = _mm256_add_ps(_mm256_set1_ps(triangle.rightX[0]), _mm256_mul_ps(_mm256_sub_ps(y, _mm256_set1_ps(triangle.rightY[0])), _mm256_set1_ps(triangle.rightSlope[0])));
+    __m256 right1 = _mm256_add_ps(_mm256_set1_ps(triangle.rightX[1]), _mm256_mul_ps(_mm256_sub_ps(y, _mm256_set1_ps(triangle.rightY[1])), _mm256_set1_ps(triangle.rightSlope[1])));
+    __m256 start = _mm256_sub_ps(_mm256_max_ps(left0, left1), firstCenter);
+    __m256 end = _mm256_sub_ps(_mm256_min_ps(right0, right1), firstCenter);
+
+    __m256i first = _mm256_sub_epi32(_mm256_set1_epi32(32),
+        _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(32.0f), start), _mm256_setzero_ps()), _mm256_set1_ps(32.0f))));
+    __m256i last = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_min_ps(_mm256_max_ps(end, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(31.0f)), _mm256_set1_ps(1.0f)));
+
+    __m256i firstBits = _mm256_sub_epi32(_mm256_sllv_epi32(one, first), one);
+    __m256i lastBits = _mm256_sub_epi32(_mm256_sllv_epi32(one, last), one);
+
+    __m256 inside = _mm256_and_ps(_mm256_cmp_ps(y, _mm256_set1_ps(triangle.minY), _CMP_GE_OQ), _mm256_cmp_ps(y, _mm256_set1_ps(triangle.maxY), _CMP_LE_OQ));
+    __m256i rowMask = _mm256_and_si256(_mm256_andnot_si256(firstBits, lastBits), _mm256_castps_si256(inside));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(mask), rowMask);
+}
+
+#else
+
+void OcclusionRasterizer::coverSse(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT])
+{
+    coverScalar(triangle, tileLeft, tileTop, mask);
+}
+
+void OcclusionRasterizer::coverAvx2(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT])
+{
+    coverScalar(triangle, tileLeft, tileTop, mask);
+}
+
+#endif
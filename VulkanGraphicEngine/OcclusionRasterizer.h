@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "FrustumCuller.h"
+#include "ThreadPool.h"
+
+const uint32_t OCCLUSION_TILE_WIDTH = 32;       // Pixels of a tile row - one bit each in a 32 bit coverage mask
+const uint32_t OCCLUSION_TILE_HEIGHT = 8;       // Rows of a tile - one SIMD lane each (AVX2 covers a tile at once)
+
+// Tile of masked depth buffer - instead of a depth per pixel it keeps two conservative layers. Every pixel is at most
+// as far as farthest, pixels with their bit set in mask are also at most as far as workingFarthest (depth 0 near, 1 far).
+struct OcclusionTile {
+    uint32_t mask[OCCLUSION_TILE_HEIGHT];
+    float farthest;
+    float workingFarthest;
+};
+
+// Masked software occlusion culling on CPU - occluder triangles are rasterized into coverage masks of 32x8 pixel tiles,
+// each tile keeping the farthest depth of what covers it. Bounding boxes of other objects are visible when their nearest
+// depth is in front of the tiles they overlap. Coverage of tile rows is computed by kernels of the same instruction sets
+// as FrustumCuller, all with the same operations in the same order, and tile rows are rasterized independently (every
+// one by a single thread, triangles in order they were added) - result is the same for every kernel and thread count.
+class OcclusionRasterizer
+{
+public:
+    OcclusionRasterizer();
+    // threadPool - tile rows are rasterized on it (nullptr - on calling thread), size is rounded up to whole tiles
+    OcclusionRasterizer(ThreadPool* threadPool, uint32_t width, uint32_t height);
+
+    void setKernel(CullKernel kernel);
+    CullKernel getKernel();
+
+    // Empties depth buffer and drops occluders
+    void clear();
+
+    // Triangles of occluder - positions in its model space, modelViewProjection takes them to Vulkan clip space.
+    // Triangles crossing near plane are left out (occluders only ever hide less than they would).
+    void addOccluder(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const glm::mat4& modelViewProjection);
+
+    // Rasterizes occluders added since clear
+    void rasterize();
+
+    // Box in model space of object - false only when it is certainly behind occluders (or off screen)
+    bool isBoxVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelViewProjection) const;
+
+    uint32_t getWidth();
+    uint32_t getHeight();
+    uint32_t getTriangleCount();                // Occluder triangles set up for rasterization (in front of near plane, on screen)
+    const std::vector<OcclusionTile>& getTiles();
+
+    ~OcclusionRasterizer();
+
+private:
+    // Triangle in screen pixels (y down). Every edge that isn't horizontal bounds rows from left or right - its x at row
+    // center y is edgeX + (y - edgeY) * slope. Unused bounds are far outside with slope 0.
+    struct Triangle {
+        float leftX[2];
+        float leftY[2];
+        float leftSlope[2];
+        float rightX[2];
+        float rightY[2];
+        float rightSlope[2];
+        float minY;
+        float maxY;
+
+        // Depth plane through depthOrigin (screen x, y, depth) - never farther than maxDepth
+        glm::vec3 depthOrigin;
+        float depthX;
+        float depthY;
+        float maxDepth;
+
+        uint32_t firstTileX;
+        uint32_t lastTileX;
+        uint32_t firstTileY;
+        uint32_t lastTileY;
+    };
+
+    ThreadPool* threadPool = nullptr;
+    CullKernel kernel = CullKernel::Scalar;
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tilesX = 0;
+    uint32_t tilesY = 0;
+    std::vector<OcclusionTile> tiles;
+
+    std::vector<glm::vec4> clipVertices;        // Three per occluder triangle
+    std::vector<Triangle> triangles;            // Set up by rasterize, in order of clipVertices
+    std::vector<uint8_t> triangleValid;         // Triangle is in front of near plane, not degenerate and on screen
+
+    bool setupTriangle(const glm::vec4* clip, Triangle* triangle) const;
+    void rasterizeTileRow(uint32_t tileY);
+    void updateTile(OcclusionTile* tile, const uint32_t mask[OCCLUSION_TILE_HEIGHT], float depth) const;
+
+    // Kernels write coverage masks of all rows of tile whose top left pixel corner is (tileLeft, tileTop)
+    static void coverScalar(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT]);
+    static void coverSse(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT]);
+    static void coverAvx2(const Triangle& triangle, float tileLeft, float tileTop, uint32_t mask[OCCLUSION_TILE_HEIGHT]);
+};
@@ -0,0 +1,140 @@
+#include "RenderQueue.h"
+
+const uint32_t KEY_PASS_SHIFT = 62;
+const uint32_t KEY_PIPELINE_SHIFT = 58;
+const uint32_t KEY_INDEX_TYPE_SHIFT = 57;
+const uint32_t KEY_TEXTURE_SHIFT = 41;
+const uint32_t KEY_DEPTH_SHIFT = 17;
+const uint32_t KEY_FIRST_DIGIT_SHIFT = 16;      // Lowest radix digit holding key bits
+const uint32_t RADIX_DIGITS = 256;
+
+RenderQueue::RenderQueue()
+{
+
+}
+
+RenderQueue::RenderQueue(ThreadPool* threadPool)
+{
+    this->threadPool = threadPool;
+}
+
+RenderQueue::~RenderQueue()
+{
+
+}
+
+uint64_t RenderQueue::makeKey(DrawPass pass, uint32_t pipeline, uint32_t indexType, uint32_t texture, float depth)
+{
+    // Bits of a non-negative float grow with its value - top 24 of them order depth without knowing its range
+    uint32_t depthBits;
+    depth = std::max(depth, 0.0f);
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    return (static_cast<uint64_t>(static_cast<uint32_t>(pass) & 0x3) << KEY_PASS_SHIFT) |
+        (static_cast<uint64_t>(pipeline & 0xF) << KEY_PIPELINE_SHIFT) |
+        (static_cast<uint64_t>(indexType & 0x1) << KEY_INDEX_TYPE_SHIFT) |
+        (static_cast<uint64_t>(texture & 0xFFFF) << KEY_TEXTURE_SHIFT) |
+        (static_cast<uint64_t>(depthBits >> 8) << KEY_DEPTH_SHIFT);
+}
+
+void RenderQueue::clear()
+{
+    draws.clear();
+    entries.clear();
+}
+
+void RenderQueue::add(uint64_t key, const QueuedDraw& draw)
+{
+    Entry entry = {};
+    entry.key = key;
+    entry.draw = static_cast<uint32_t>(draws.size());
+    entries.push_back(entry);
+    draws.push_back(draw);
+}
+
+void RenderQueue::sort()
+{
+    size_t count = entries.size();
+    size_t chunkCount = threadPool && count >= RENDER_QUEUE_PARALLEL_DRAWS ? threadPool->getThreadCount() : 1;
+    sortedEntries.resize(count);
+    digitCounts.resize(chunkCount * RADIX_DIGITS);
+
+    // One chunk per pool thread - parallelFor gives every range of a single chunk to its own task
+    auto forEachChunk = [&](const std::function<void(size_t, size_t, uint32_t*)>& body)
+    {
+        auto chunks = [&](size_t firstChunk, size_t endChunk)
+        {
+            for (size_t chunk = firstChunk; chunk < endChunk; chunk++)
+            {
+                body(count * chunk / chunkCount, count * (chunk + 1) / chunkCount, &digitCounts[chunk * RADIX_DIGITS]);
+            }
+        };
+
+        if (chunkCount > 1)
+        {
+            threadPool->parallelFor(chunkCount, chunks);
+        }
+        else
+        {
+            chunks(0, chunkCount);
+        }
+    };
+
+    for (uint32_t shift = KEY_FIRST_DIGIT_SHIFT; shift < 64; shift += 8)
+    {
+        forEachChunk([&](size_t begin, size_t end, uint32_t* counts)
+        {
+            std::fill(counts, counts + RADIX_DIGITS, 0u);
+            for (size_t i = begin; i < end; i++)
+            {
+                counts[(entries[i].key >> shift) & 0xFF]++;
+            }
+        });
+
+        // Digit's places are taken by chunks in order, and within chunk in order of entries - pass is stable
+        bool singleDigit = false;
+        uint32_t place = 0;
+        for (uint32_t digit = 0; digit < RADIX_DIGITS; digit++)
+        {
+            uint32_t digitTotal = 0;
+            for (size_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                uint32_t digitCount = digitCounts[chunk * RADIX_DIGITS + digit];
+                digitCounts[chunk * RADIX_DIGITS + digit] = place;
+                place += digitCount;
+                digitTotal += digitCount;
+            }
+            singleDigit |= digitTotal == count;
+        }
+
+        // Every key has same digit (usually pass and pipeline bits) - nothing would move
+        if (singleDigit)
+        {
+            continue;
+        }
+
+        forEachChunk([&](size_t begin, size_t end, uint32_t* places)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                sortedEntries[places[(entries[i].key >> shift) & 0xFF]++] = entries[i];
+            }
+        });
+        entries.swap(sortedEntries);
+    }
+}
+
+size_t RenderQueue::size()
+{
+    return entries.size();
+}
+
+const QueuedDraw& RenderQueue::getDraw(size_t i)
+{
+    return draws[entries[i].draw];
+}
+
+uint64_t RenderQueue::getKey(size_t i)
+{
+    return entries[i].key;
+}
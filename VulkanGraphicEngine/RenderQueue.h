@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+const size_t RENDER_QUEUE_PARALLEL_DRAWS = 8192;   // Fewer draws are sorted on calling thread - pool round trip would cost more
+
+// Passes draws are grouped into, in order they are recorded - only opaque geometry is drawn so far
+enum class DrawPass : uint32_t {
+    Opaque = 0
+};
+
+// Draw waiting in render queue - mesh's detail level for objects [firstInstance, firstInstance + instanceCount) of object ring
+struct QueuedDraw {
+    uint32_t meshId;
+    uint32_t lod;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+// Draws of a frame sorted by 64 bit keys before they are recorded, so draws sharing state follow each other.
+// Key bits, high to low: pass (2), pipeline (4), index type (1), texture (16), depth (24, near first) - lowest 17 are 0.
+// Sort is a least significant digit radix sort, 8 bits per pass - it is stable (equal keys keep order they were added in),
+// and chunks of draws are counted and scattered on thread pool, which gives the same order for any thread count.
+class RenderQueue
+{
+public:
+    RenderQueue();
+    RenderQueue(ThreadPool* threadPool);        // nullptr - sorted on calling thread
+
+    // depth - distance from camera, 0 or more
+    static uint64_t makeKey(DrawPass pass, uint32_t pipeline, uint32_t indexType, uint32_t texture, float depth);
+
+    void clear();
+    void add(uint64_t key, const QueuedDraw& draw);
+    void sort();
+
+    size_t size();
+    const QueuedDraw& getDraw(size_t i);        // i-th draw in key order once sorted
+    uint64_t getKey(size_t i);
+
+    ~RenderQueue();
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t draw;                          // Index in draws
+    };
+
+    ThreadPool* threadPool = nullptr;
+    std::vector<QueuedDraw> draws;              // In order they were added
+    std::vector<Entry> entries;
+    std::vector<Entry> sortedEntries;           // Scatter target of every pass, swapped with entries afterwards
+    std::vector<uint32_t> digitCounts;          // 256 per chunk - counts, then first place of digit in chunk
+};
@@ -1,3 +1,40 @@
-D:/VulkanSDK/1.2.176.1/Bin32/glslangValidator.exe -V shader.vert
-D:/VulkanSDK/1.2.176.1/Bin32/glslangValidator.exe -V shader.frag
-pause
\ No newline at end of file
+@echo off
+rem Compiles every shader to SPIR-V with glslangValidator of Vulkan SDK and validates it with spirv-val when SDK has it.
+rem Run by pre-build step of VulkanGraphicEngine (with nopause) - any missing tool or failed shader fails the build.
+cd /d "%~dp0"
+
+if "%VULKAN_SDK%"=="" (
+    echo compiler_shaders.bat: error: VULKAN_SDK is not set - install Vulkan SDK or set VULKAN_SDK to its directory
+    exit /b 1
+)
+set GLSLANG_VALIDATOR="%VULKAN_SDK%\Bin\glslangValidator.exe"
+set SPIRV_VAL="%VULKAN_SDK%\Bin\spirv-val.exe"
+if not exist %GLSLANG_VALIDATOR% (
+    echo compiler_shaders.bat: error: %GLSLANG_VALIDATOR% not found - VULKAN_SDK doesn't point to a Vulkan SDK
+    exit /b 1
+)
+
+call :compile shader.vert vert.spv || exit /b 1
+call :compile shader.frag frag.spv || exit /b 1
+call :compile mipmap.comp mipmap.spv || exit /b 1
+call :compile cull.comp cull.spv || exit /b 1
+call :compile depthreduce.comp depthreduce.spv || exit /b 1
+
+if not "%1"=="nopause" pause
+exit /b 0
+
+rem compile source output
+:compile
+%GLSLANG_VALIDATOR% -V %1 -o %2
+if errorlevel 1 (
+    echo compiler_shaders.bat: error: %1 failed to compile
+    exit /b 1
+)
+if exist %SPIRV_VAL% (
+    %SPIRV_VAL% --target-env vulkan1.0 %2
+    if errorlevel 1 (
+        echo compiler_shaders.bat: error: %2 failed validation
+        exit /b 1
+    )
+)
+exit /b 0
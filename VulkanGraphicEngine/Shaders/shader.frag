@@ -1,13 +1,16 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragCol;
 layout(location = 1) in vec2 fragTex;
+layout(location = 2) in vec4 fragColour;
+layout(location = 3) flat in uint fragTextureIndex;
 
-layout(set = 1, binding = 0) uniform sampler2D textureSampler;
+layout(set = 1, binding = 0) uniform sampler2D textureSamplers[64];	// MAX_TEXTURES, only elements of created textures are written
 
 layout(location = 0) out vec4 outColour; // Final output colour
 
 void main() {
-	outColour = texture(textureSampler, fragTex);
+	// Instances of one draw may use different textures - index isn't uniform
+	outColour = texture(textureSamplers[nonuniformEXT(fragTextureIndex)], fragTex) * fragColour;
 }
-
@@ -9,20 +9,29 @@ layout(set = 0, binding = 0) uniform UboViewProjection {		// single descriptor
 	mat4 view;
 } uboViewProjection;
 
-// NOT IN USE
-layout(set = 0, binding = 1) uniform UboModel {					// single descriptor
-	mat4 model;
-} uboModel;
+// Per-object data of every object drawn this frame (ObjectData in Mesh.h)
+struct ObjectData {
+	mat4 model;													// dequantization of mesh already applied
+	vec4 colour;
+	uint textureIndex;
+};
 
-layout(push_constant) uniform PushModel {
-	mat4 model;
-} pushModel;
+layout(std430, set = 0, binding = 1) readonly buffer Objects {
+	ObjectData objects[];
+};
 
 layout(location = 0) out vec3 fragCol;
 layout(location = 1) out vec2 fragTex;
+layout(location = 2) out vec4 fragColour;
+layout(location = 3) flat out uint fragTextureIndex;
 
 void main() {
-	gl_Position = uboViewProjection.projection * uboViewProjection.view * pushModel.model * vec4(pos, 1.0);
+	// gl_InstanceIndex includes firstInstance of draw - index of object in buffer
+	ObjectData object = objects[gl_InstanceIndex];
+
+	gl_Position = uboViewProjection.projection * uboViewProjection.view * object.model * vec4(pos, 1.0);
 	fragCol = col;
 	fragTex = tex;
-}
\ No newline at end of file
+	fragColour = object.colour;
+	fragTextureIndex = object.textureIndex;
+}
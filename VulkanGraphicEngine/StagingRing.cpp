@@ -0,0 +1,294 @@
+#include "StagingRing.h"
+
+StagingRing::StagingRing()
+{
+
+}
+
+StagingRing::~StagingRing()
+{
+
+}
+
+StagingRing::StagingRing(MemoryAllocator* allocator, VkDevice device, VkQueue queue, VkCommandPool commandPool,
+    VkQueue graphicsQueue, VkCommandPool graphicsCommandPool, std::mutex* queueMutex, VkDeviceSize size)
+{
+    this->allocator = allocator;
+    this->device = device;
+    this->queue = queue;
+    this->commandPool = commandPool;
+    this->graphicsQueue = graphicsQueue;
+    this->graphicsCommandPool = graphicsCommandPool;
+    this->queueMutex = queueMutex;
+    this->size = size;
+    head = 0;
+    openBegin = 0;
+    nextToken = 1;
+
+    // Created once and stays mapped - uploads only memcpy into it
+    createBuffer(allocator, device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &bufferMemory);
+}
+
+StagingRegion StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    StagingRegion region;
+    if (!tryAllocate(size, alignment, &region))
+    {
+        throw std::runtime_error("Staging Ring is full of unsubmitted uploads!");
+    }
+
+    return region;
+}
+
+bool StagingRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, StagingRegion* region)
+{
+    if (size > this->size)
+    {
+        throw std::runtime_error("Staging allocation is bigger than Staging Ring!");
+    }
+
+    VkDeviceSize offset;
+    while (!findSpace(size, alignment, &offset))
+    {
+        // Only space waiting for submit is left - nothing to wait for
+        if (pending.empty())
+        {
+            return false;
+        }
+
+        // Wait for oldest upload to free its part of ring
+        vkWaitForFences(device, 1, &pending.front().fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        reclaim();
+    }
+
+    head = offset + size;
+
+    region->buffer = buffer;
+    region->offset = offset;
+    region->size = size;
+    region->data = static_cast<char*>(bufferMemory.mappedData) + offset;
+
+    return true;
+}
+
+bool StagingRing::findSpace(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+{
+    // Whole ring is free - start again from the beginning to avoid wrapping
+    if (pending.empty() && openBegin == head)
+    {
+        head = 0;
+        openBegin = 0;
+    }
+
+    // Oldest byte still in use
+    VkDeviceSize tail = pending.empty() ? openBegin : pending.front().begin;
+    VkDeviceSize alignedHead = (head + alignment - 1) / alignment * alignment;
+
+    // Used space is [tail, head) - try after it, then wrap to the beginning
+    // Wrapped head has to stay strictly below tail, otherwise full ring would look empty
+    if (head >= tail)
+    {
+        if (alignedHead + size <= this->size)
+        {
+            *offset = alignedHead;
+            return true;
+        }
+        if (size < tail)
+        {
+            *offset = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // Used space wraps around - only gap is [head, tail)
+    if (alignedHead + size < tail)
+    {
+        *offset = alignedHead;
+        return true;
+    }
+    return false;
+}
+
+VkCommandBuffer StagingRing::beginCommands()
+{
+    return beginCommandBuffer(device, commandPool);
+}
+
+VkCommandBuffer StagingRing::beginAcquireCommands()
+{
+    return beginCommandBuffer(device, graphicsCommandPool);
+}
+
+UploadToken StagingRing::submit(VkCommandBuffer commandBuffer, VkCommandBuffer acquireCommandBuffer, VkPipelineStageFlags acquireStages)
+{
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFence fence;
+    if (!freeFences.empty())
+    {
+        fence = freeFences.back();
+        freeFences.pop_back();
+    }
+    else
+    {
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if (vkCreateFence(device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create a Staging Fence!");
+        }
+    }
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    if (acquireCommandBuffer != VK_NULL_HANDLE)
+    {
+        vkEndCommandBuffer(acquireCommandBuffer);
+
+        if (!freeSemaphores.empty())
+        {
+            semaphore = freeSemaphores.back();
+            freeSemaphores.pop_back();
+        }
+        else
+        {
+            VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create a Staging Semaphore!");
+            }
+        }
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = semaphore != VK_NULL_HANDLE ? 1 : 0;
+    submitInfo.pSignalSemaphores = &semaphore;
+
+    std::lock_guard<std::mutex> lock(*queueMutex);
+
+    // No waiting for queue to go idle - fence tells when space can be reused
+    VkResult result = vkQueueSubmit(queue, 1, &submitInfo, semaphore != VK_NULL_HANDLE ? VK_NULL_HANDLE : fence);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit Staging Commands!");
+    }
+
+    // Graphics queue takes ownership of uploaded resources once copies are done
+    if (semaphore != VK_NULL_HANDLE)
+    {
+        VkSubmitInfo acquireSubmitInfo = {};
+        acquireSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireSubmitInfo.waitSemaphoreCount = 1;
+        acquireSubmitInfo.pWaitSemaphores = &semaphore;
+        acquireSubmitInfo.pWaitDstStageMask = &acquireStages;
+        acquireSubmitInfo.commandBufferCount = 1;
+        acquireSubmitInfo.pCommandBuffers = &acquireCommandBuffer;
+
+        result = vkQueueSubmit(graphicsQueue, 1, &acquireSubmitInfo, fence);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit Acquire Commands!");
+        }
+    }
+
+    PendingUpload upload = {};
+    upload.fence = fence;
+    upload.commandBuffer = commandBuffer;
+    upload.acquireCommandBuffer = acquireCommandBuffer;
+    upload.semaphore = semaphore;
+    upload.token = nextToken++;
+    upload.begin = openBegin;
+    upload.end = head;
+    pending.push_back(upload);
+
+    openBegin = head;
+
+    return upload.token;
+}
+
+void StagingRing::discard(VkCommandBuffer commandBuffer)
+{
+    if (commandBuffer != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    }
+
+    head = openBegin;
+}
+
+bool StagingRing::isComplete(UploadToken token)
+{
+    reclaim();
+    return pending.empty() || pending.front().token > token;
+}
+
+void StagingRing::wait(UploadToken token)
+{
+    for (size_t i = 0; i < pending.size() && pending[i].token <= token; i++)
+    {
+        vkWaitForFences(device, 1, &pending[i].fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    reclaim();
+}
+
+void StagingRing::reclaim()
+{
+    // Uploads finish in submission order - stop at first one still running
+    while (!pending.empty() && vkGetFenceStatus(device, pending.front().fence) == VK_SUCCESS)
+    {
+        PendingUpload& upload = pending.front();
+
+        vkFreeCommandBuffers(device, commandPool, 1, &upload.commandBuffer);
+        vkResetFences(device, 1, &upload.fence);
+        freeFences.push_back(upload.fence);
+
+        if (upload.semaphore != VK_NULL_HANDLE)
+        {
+            vkFreeCommandBuffers(device, graphicsCommandPool, 1, &upload.acquireCommandBuffer);
+            freeSemaphores.push_back(upload.semaphore);
+        }
+
+        pending.pop_front();
+    }
+}
+
+void StagingRing::flush()
+{
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        vkWaitForFences(device, 1, &pending[i].fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    reclaim();
+}
+
+VkDeviceSize StagingRing::getSize()
+{
+    return size;
+}
+
+void StagingRing::destroy()
+{
+    flush();
+
+    for (size_t i = 0; i < freeFences.size(); i++)
+    {
+        vkDestroyFence(device, freeFences[i], nullptr);
+    }
+    freeFences.clear();
+
+    for (size_t i = 0; i < freeSemaphores.size(); i++)
+    {
+        vkDestroySemaphore(device, freeSemaphores[i], nullptr);
+    }
+    freeSemaphores.clear();
+
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator->free(&bufferMemory);
+}
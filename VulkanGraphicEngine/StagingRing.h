@@ -0,0 +1,101 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "Utilities.h"
+
+const VkDeviceSize STAGING_RING_SIZE = 16 * 1024 * 1024;    // Default size of staging ring
+
+// Serial number of a staging submit, 0 is never used so it can stand for "nothing submitted"
+typedef uint64_t UploadToken;
+
+// Part of staging ring given to a single upload
+struct StagingRegion {
+    VkBuffer buffer;            // Staging buffer (the ring itself) - source of copy commands
+    VkDeviceSize offset;        // Offset of region in staging buffer
+    VkDeviceSize size;          // Size of region
+    void* data;                 // Mapped pointer to start of region
+};
+
+// Long-lived, persistently mapped staging buffer shared by all uploads.
+// Space is handed out in submission order and given back once fence of submit that read from it signals.
+// Copies run on upload queue, optional acquire commands (queue family ownership transfer) run on graphics queue after them.
+// Ring itself is used by one thread only - each streaming thread owns its own ring and command pools.
+class StagingRing
+{
+public:
+    StagingRing();
+    StagingRing(MemoryAllocator* allocator, VkDevice device, VkQueue queue, VkCommandPool commandPool,
+        VkQueue graphicsQueue, VkCommandPool graphicsCommandPool, std::mutex* queueMutex, VkDeviceSize size = STAGING_RING_SIZE);
+
+    // Reserve space for size bytes, waits for oldest uploads to finish if ring is full
+    StagingRegion allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+    // Same as allocate, but returns false instead of throwing when only space allocated since last submit is in the way
+    bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, StagingRegion* region);
+
+    // Command buffer for copies out of the ring, submit() hands it back together with space allocated since previous submit
+    VkCommandBuffer beginCommands();
+    VkCommandBuffer beginAcquireCommands();
+
+    // Acquire command buffer (if given) is submitted to graphics queue and waits on semaphore signalled by copies at acquireStages
+    UploadToken submit(VkCommandBuffer commandBuffer, VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE, VkPipelineStageFlags acquireStages = 0);
+
+    // Drop command buffer instead of submitting it (VK_NULL_HANDLE if none was begun) - space allocated since last submit is free again
+    void discard(VkCommandBuffer commandBuffer);
+
+    bool isComplete(UploadToken token);     // Whether submit with given token (and every one before it) finished
+    void wait(UploadToken token);           // Wait for submit with given token and every one before it
+
+    void reclaim();             // Give back space of uploads that already finished (doesn't wait)
+    void flush();               // Wait for all submitted uploads to finish
+
+    VkDeviceSize getSize();
+
+    void destroy();
+
+    ~StagingRing();
+
+private:
+    // Submit that reads from [begin, end) of ring (end < begin when it wrapped around)
+    // With acquire commands fence belongs to acquire submit - it can only signal after copies finished
+    struct PendingUpload {
+        VkFence fence;
+        VkCommandBuffer commandBuffer;
+        VkCommandBuffer acquireCommandBuffer;
+        VkSemaphore semaphore;
+        UploadToken token;
+        VkDeviceSize begin;
+        VkDeviceSize end;
+    };
+
+    VkDevice device;
+    MemoryAllocator* allocator;
+    VkQueue queue;
+    VkCommandPool commandPool;
+    VkQueue graphicsQueue;
+    VkCommandPool graphicsCommandPool;
+    std::mutex* queueMutex;                 // Queues are shared with other threads - every submit locks it
+
+    VkBuffer buffer;
+    MemoryAllocation bufferMemory;
+    VkDeviceSize size;
+
+    VkDeviceSize head;                      // Next free byte of ring
+    VkDeviceSize openBegin;                 // Start of space allocated since last submit
+    UploadToken nextToken;
+    std::deque<PendingUpload> pending;      // Submits still in flight, oldest first
+    std::vector<VkFence> freeFences;        // Signalled fences ready to be reused
+    std::vector<VkSemaphore> freeSemaphores; // Unsignalled semaphores ready to be reused
+
+    bool findSpace(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset);
+};
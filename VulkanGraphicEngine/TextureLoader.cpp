@@ -0,0 +1,342 @@
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+// KTX2 file layout (khronos.org/ktx) - header, index and level index, all little endian
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+struct Ktx2Header {
+    unsigned char identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct Ktx2Level {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+TextureLoader::TextureLoader()
+{
+
+}
+
+TextureLoader::~TextureLoader()
+{
+
+}
+
+TextureLoader::TextureLoader(VkPhysicalDevice physicalDevice, const AssetArchive* archive)
+{
+    this->physicalDevice = physicalDevice;
+    this->archive = archive;
+}
+
+TextureData TextureLoader::load(const std::string& filename)
+{
+    size_t extension = filename.find_last_of('.');
+    if (extension != std::string::npos && filename.substr(extension) == ".ktx2")
+    {
+        return loadKtx2(filename);
+    }
+
+    // Cooked variant in best format device supports
+    std::string baseName = filename.substr(0, extension);
+    for (VkFormat format : getCompressedFormats())
+    {
+        std::string variant = baseName + "." + getFormatSuffix(format) + ".ktx2";
+        if (fileExists(variant))
+        {
+            return loadKtx2(variant);
+        }
+    }
+
+    return loadImage(filename);
+}
+
+const AssetArchive* TextureLoader::getArchive()
+{
+    return archive;
+}
+
+bool TextureLoader::findInArchive(const std::string& filename, const char** data, size_t* size)
+{
+    return archive && archive->isOpen() && archive->find("Textures/" + filename, data, size);
+}
+
+bool TextureLoader::fileExists(const std::string& filename)
+{
+    const char* data;
+    size_t size;
+    return findInArchive(filename, &data, &size) || std::ifstream("Textures/" + filename).good();
+}
+
+TextureData TextureLoader::loadImage(const std::string& filename)
+{
+    // Load pixel data, always expanded to 4 channels
+    int width, height, channels;
+    stbi_uc* image;
+
+    const char* archived;
+    size_t archivedSize;
+    if (findInArchive(filename, &archived, &archivedSize))
+    {
+        image = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(archived), static_cast<int>(archivedSize), &width, &height, &channels, STBI_rgb_alpha);
+    }
+    else
+    {
+        std::string fileLoc = "Textures/" + filename;
+        image = stbi_load(fileLoc.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    }
+
+    if (!image)
+    {
+        throw std::runtime_error("Failed to load a Texture file (" + filename + ")");
+    }
+
+    TextureData texture;
+    texture.filename = filename;
+    texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+    texture.width = static_cast<uint32_t>(width);
+    texture.height = static_cast<uint32_t>(height);
+    texture.mipLevels = getMipLevels(texture.width, texture.height);
+    texture.generateMipmaps = true;
+
+    VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+    texture.data.assign(image, image + imageSize);
+    texture.levels.push_back({ 0, imageSize, texture.width, texture.height });
+
+    stbi_image_free(image);
+
+    return texture;
+}
+
+TextureData TextureLoader::loadKtx2(const std::string& filename)
+{
+    TextureData texture;
+    texture.filename = filename;
+
+    // Archived file stays mapped - levels are copied from it straight into staging memory
+    const char* archived;
+    size_t archivedSize;
+    if (findInArchive(filename, &archived, &archivedSize))
+    {
+        parseKtx2(filename, archived, archivedSize, &texture);
+        texture.mappedData = reinterpret_cast<const unsigned char*>(archived);
+
+        return texture;
+    }
+
+    std::vector<char> file = readFile("Textures/" + filename);
+    parseKtx2(filename, file.data(), file.size(), &texture);
+
+    // Level data is copied together, tightly packed one after another
+    for (TextureLevel& level : texture.levels)
+    {
+        VkDeviceSize fileOffset = level.offset;
+        level.offset = texture.data.size();
+        texture.data.insert(texture.data.end(), file.begin() + fileOffset, file.begin() + fileOffset + level.size);
+    }
+
+    return texture;
+}
+
+void TextureLoader::parseKtx2(const std::string& filename, const char* file, size_t fileSize, TextureData* texture)
+{
+    Ktx2Header header;
+    if (fileSize < sizeof(Ktx2Header))
+    {
+        throw std::runtime_error("KTX2 file is too small (" + filename + ")!");
+    }
+    memcpy(&header, file, sizeof(Ktx2Header));
+
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+    {
+        throw std::runtime_error("File is not a KTX2 texture (" + filename + ")!");
+    }
+
+    // Only plain 2D textures with data in a Vulkan format - no Basis transcoding, arrays or cubemaps
+    if (header.vkFormat == 0 || header.supercompressionScheme != 0)
+    {
+        throw std::runtime_error("Supercompressed KTX2 textures are not supported (" + filename + ")!");
+    }
+    if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0)
+    {
+        throw std::runtime_error("Only 2D KTX2 textures are supported (" + filename + ")!");
+    }
+
+    texture->format = static_cast<VkFormat>(header.vkFormat);
+    texture->width = header.pixelWidth;
+    texture->height = header.pixelHeight;
+
+    uint32_t blockExtent, blockSize;
+    if (!getFormatBlock(texture->format, &blockExtent, &blockSize))
+    {
+        throw std::runtime_error("Unknown KTX2 texture format (" + filename + ")!");
+    }
+    if (!isFormatSupported(texture->format))
+    {
+        throw std::runtime_error("Texture format is not supported by device (" + filename + ")!");
+    }
+
+    // levelCount 0 - only base level stored, rest has to be generated (possible for uncompressed formats only)
+    uint32_t storedLevels = std::max(header.levelCount, 1u);
+    if (header.levelCount == 0)
+    {
+        if (blockExtent != 1)
+        {
+            throw std::runtime_error("Compressed KTX2 texture has no mip levels stored (" + filename + ")!");
+        }
+        texture->mipLevels = getMipLevels(texture->width, texture->height);
+        texture->generateMipmaps = true;
+    }
+    else if (header.levelCount > getMipLevels(texture->width, texture->height))
+    {
+        throw std::runtime_error("KTX2 texture has more mip levels than its size allows (" + filename + ")!");
+    }
+    else
+    {
+        texture->mipLevels = storedLevels;
+    }
+
+    if (fileSize < sizeof(Ktx2Header) + storedLevels * sizeof(Ktx2Level))
+    {
+        throw std::runtime_error("KTX2 level index is truncated (" + filename + ")!");
+    }
+
+    for (uint32_t i = 0; i < storedLevels; i++)
+    {
+        Ktx2Level level;
+        memcpy(&level, file + sizeof(Ktx2Header) + i * sizeof(Ktx2Level), sizeof(Ktx2Level));
+
+        uint32_t levelWidth = std::max(texture->width >> i, 1u);
+        uint32_t levelHeight = std::max(texture->height >> i, 1u);
+        VkDeviceSize levelSize = static_cast<VkDeviceSize>((levelWidth + blockExtent - 1) / blockExtent) * ((levelHeight + blockExtent - 1) / blockExtent) * blockSize;
+
+        // Compared so that offsets near 2^64 can't wrap around
+        if (level.byteLength < levelSize || level.byteOffset > fileSize || levelSize > fileSize - level.byteOffset)
+        {
+            throw std::runtime_error("KTX2 level data is truncated (" + filename + ")!");
+        }
+
+        texture->levels.push_back({ level.byteOffset, levelSize, levelWidth, levelHeight });
+    }
+}
+
+bool TextureLoader::isFormatSupported(VkFormat format)
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProperties.optimalTilingFeatures & required) == required;
+}
+
+std::vector<VkFormat> TextureLoader::getCompressedFormats()
+{
+    // Best quality per byte first - BC7 and ASTC 4x4 are 8 bpp, BC3 8 bpp with worse quality, BC1 4 bpp without alpha gradients
+    const VkFormat preferredFormats[] = {
+        VK_FORMAT_BC7_UNORM_BLOCK,
+        VK_FORMAT_ASTC_4x4_UNORM_BLOCK,
+        VK_FORMAT_BC3_UNORM_BLOCK,
+        VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+    };
+
+    std::vector<VkFormat> formats;
+    for (VkFormat format : preferredFormats)
+    {
+        if (isFormatSupported(format))
+        {
+            formats.push_back(format);
+        }
+    }
+
+    return formats;
+}
+
+bool TextureLoader::getFormatBlock(VkFormat format, uint32_t* blockExtent, uint32_t* blockSize)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        *blockExtent = 1;
+        *blockSize = 4;
+        return true;
+
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        *blockExtent = 4;
+        *blockSize = 8;
+        return true;
+
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        *blockExtent = 4;
+        *blockSize = 16;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+const char* TextureLoader::getFormatSuffix(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:     return "bc1";
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:          return "bc3";
+    case VK_FORMAT_BC4_UNORM_BLOCK:         return "bc4";
+    case VK_FORMAT_BC5_UNORM_BLOCK:         return "bc5";
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:          return "bc7";
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:     return "astc";
+    default:                                return "rgba8";
+    }
+}
+
+TextureInfo TextureLoader::getInfo(const TextureData& texture, const MemoryAllocation& memory)
+{
+    TextureInfo info;
+    info.filename = texture.filename;
+    info.format = texture.format;
+    info.width = texture.width;
+    info.height = texture.height;
+    info.mipLevels = texture.mipLevels;
+    info.memorySize = memory.size;
+
+    for (uint32_t i = 0; i < texture.mipLevels; i++)
+    {
+        info.uncompressedSize += static_cast<VkDeviceSize>(std::max(texture.width >> i, 1u)) * std::max(texture.height >> i, 1u) * 4;
+    }
+
+    return info;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include "Utilities.h"
+
+// Single mip level inside TextureData::data
+struct TextureLevel {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Texture ready for upload - either decoded pixels (level 0 only, rest generated on GPU) or a precompressed mip chain
+struct TextureData {
+    std::string filename;                       // File data was loaded from (cooked variant if one was picked)
+    VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;                     // Levels of created image
+    bool generateMipmaps = false;               // Only first level is in data, others are generated from it
+    std::vector<TextureLevel> levels;
+    std::vector<unsigned char> data;
+    const unsigned char* mappedData = nullptr;  // Levels are read in place from mapped asset archive instead of data
+
+    const unsigned char* getData() const { return mappedData ? mappedData : data.data(); }
+};
+
+// Footprint of a created texture - memorySize against uncompressedSize shows savings of block compression
+struct TextureInfo {
+    std::string filename;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 0;
+    VkDeviceSize memorySize = 0;                // Device memory taken by image
+    VkDeviceSize uncompressedSize = 0;          // Same mip chain as RGBA8
+};
+
+// Loads textures from Textures/ - KTX2 files with precompressed mip chains, anything else is decoded with stb_image.
+// For "name.tga" a cooked "name.<format>.ktx2" is preferred when device can sample its format.
+// Files in asset archive are used before loose files, KTX2 levels from it are not copied at all.
+// Safe to use from multiple threads.
+class TextureLoader
+{
+public:
+    TextureLoader();
+    TextureLoader(VkPhysicalDevice physicalDevice, const AssetArchive* archive = nullptr);
+
+    TextureData load(const std::string& filename);
+
+    // Format can be sampled with linear filtering from optimal tiled image
+    bool isFormatSupported(VkFormat format);
+
+    // Supported block compressed colour formats, most preferred first
+    std::vector<VkFormat> getCompressedFormats();
+
+    // Texel block of format (1x1 for uncompressed), false if loader doesn't know format
+    static bool getFormatBlock(VkFormat format, uint32_t* blockExtent, uint32_t* blockSize);
+
+    // File name suffix of cooked variant in given format ("bc7" for name.bc7.ktx2)
+    static const char* getFormatSuffix(VkFormat format);
+
+    static TextureInfo getInfo(const TextureData& texture, const MemoryAllocation& memory);
+
+    const AssetArchive* getArchive();
+
+    ~TextureLoader();
+
+private:
+    VkPhysicalDevice physicalDevice;
+    const AssetArchive* archive = nullptr;
+
+    bool findInArchive(const std::string& filename, const char** data, size_t* size);
+    bool fileExists(const std::string& filename);
+
+    TextureData loadKtx2(const std::string& filename);
+    TextureData loadImage(const std::string& filename);
+
+    // Fills texture with levels at offsets from start of file
+    void parseKtx2(const std::string& filename, const char* file, size_t fileSize, TextureData* texture);
+};
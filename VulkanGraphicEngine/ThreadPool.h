@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <exception>
+#include <memory>
+#include <algorithm>
+
+// Fixed set of worker threads running queued tasks in submission order.
+// Threads are joined when pool is destroyed (after all queued tasks ran).
+class ThreadPool
+{
+public:
+    // threadCount 0 : one thread per hardware thread
+    explicit ThreadPool(size_t threadCount = 0)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue task, future gives its result (or rethrows its exception)
+    template <typename F>
+    auto submit(F task) -> std::future<decltype(task())>
+    {
+        typedef decltype(task()) Result;
+
+        auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        std::future<Result> result = packagedTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push([packagedTask] { (*packagedTask)(); });
+        }
+        condition.notify_one();
+
+        return result;
+    }
+
+    // Call body(begin, end) for contiguous ranges covering [0, count) - one range per thread, returns once all finished
+    // (exception of first range that threw is rethrown then). Must not be called from one of pool's own threads
+    template <typename F>
+    void parallelFor(size_t count, F body)
+    {
+        size_t rangeCount = std::min(count, workers.size());
+        std::vector<std::future<void>> results;
+
+        for (size_t i = 0; i < rangeCount; i++)
+        {
+            size_t begin = count * i / rangeCount;
+            size_t end = count * (i + 1) / rangeCount;
+            results.push_back(submit([=] { body(begin, end); }));
+        }
+
+        // Other ranges may still use caller's locals - every one has to finish before an exception leaves
+        std::exception_ptr error;
+        for (auto& result : results)
+        {
+            try
+            {
+                result.get();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    size_t getThreadCount()
+    {
+        return workers.size();
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+                if (stopping && tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+
+            task();
+        }
+    }
+};
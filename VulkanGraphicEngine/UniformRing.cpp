@@ -0,0 +1,66 @@
+#include "UniformRing.h"
+
+UniformRing::UniformRing()
+{
+
+}
+
+UniformRing::~UniformRing()
+{
+
+}
+
+UniformRing::UniformRing(MemoryAllocator* allocator, VkDevice device, VkDeviceSize minUniformBufferOffset, VkDeviceSize frameSize, VkBufferUsageFlags usage)
+{
+    this->allocator = allocator;
+    this->device = device;
+    this->alignment = minUniformBufferOffset;
+
+    // Every frame region has to start on aligned offset too
+    this->frameSize = (frameSize + alignment - 1) / alignment * alignment;
+    frameStart = 0;
+    head = 0;
+
+    // One buffer for all frames in flight - stays mapped for its whole lifetime (no vkMapMemory / vkUnmapMemory per frame)
+    createBuffer(allocator, device, this->frameSize * MAX_FRAME_DRAWS, usage,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &bufferMemory);
+}
+
+void UniformRing::beginFrame(int frame)
+{
+    frameStart = frameSize * frame;
+    head = 0;
+}
+
+void* UniformRing::allocate(VkDeviceSize size, uint32_t* dynamicOffset)
+{
+    // Rounded up to multiple of alignment - not necessarily a power of two (e.g. size of an element of storage ring)
+    VkDeviceSize alignedSize = (size + alignment - 1) / alignment * alignment;
+
+    if (head + alignedSize > frameSize)
+    {
+        throw std::runtime_error("Uniform Ring is out of space for current frame!");
+    }
+
+    VkDeviceSize offset = frameStart + head;
+    head += alignedSize;
+
+    *dynamicOffset = static_cast<uint32_t>(offset);
+    return static_cast<char*>(bufferMemory.mappedData) + offset;
+}
+
+VkBuffer UniformRing::getBuffer()
+{
+    return buffer;
+}
+
+VkDeviceSize UniformRing::getUsedBytes()
+{
+    return head;
+}
+
+void UniformRing::destroy()
+{
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator->free(&bufferMemory);
+}
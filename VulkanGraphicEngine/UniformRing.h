@@ -0,0 +1,57 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <cstring>
+
+#include "Utilities.h"
+
+const VkDeviceSize UNIFORM_RING_FRAME_SIZE = 64 * 1024;     // Bytes of constant data each frame in flight can allocate
+
+// One persistently mapped, host coherent uniform buffer split into a region for every frame in flight.
+// Per-frame constant data is bump-allocated from current frame's region and bound with dynamic offsets.
+// Created with other usage (e.g. storage buffer) and element size as alignment, same ring carries per-frame arrays - offset / element size is then an index.
+class UniformRing
+{
+public:
+    UniformRing();
+    UniformRing(MemoryAllocator* allocator, VkDevice device, VkDeviceSize minUniformBufferOffset, VkDeviceSize frameSize = UNIFORM_RING_FRAME_SIZE,
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+    // Start allocating from region of given frame - GPU must be done with previous use of that frame (its fence waited on)
+    void beginFrame(int frame);
+
+    // Reserve aligned space for size bytes, returns pointer to write data to and offset to bind it with
+    void* allocate(VkDeviceSize size, uint32_t* dynamicOffset);
+
+    // Copy data into current frame's region, returns dynamic offset of the copy
+    template <typename T>
+    uint32_t push(const T& data)
+    {
+        uint32_t dynamicOffset;
+        void* destination = allocate(sizeof(T), &dynamicOffset);
+        memcpy(destination, &data, sizeof(T));
+        return dynamicOffset;
+    }
+
+    VkBuffer getBuffer();
+    VkDeviceSize getUsedBytes();
+
+    void destroy();
+
+    ~UniformRing();
+
+private:
+    VkDevice device;
+    MemoryAllocator* allocator;
+
+    VkBuffer buffer;
+    MemoryAllocation bufferMemory;
+
+    VkDeviceSize alignment;         // minUniformBufferOffsetAlignment - every dynamic offset has to be a multiple of it
+    VkDeviceSize frameSize;         // Size of region of a single frame
+    VkDeviceSize frameStart;        // Offset of current frame's region
+    VkDeviceSize head;              // Next free byte in current frame's region (relative to frameStart)
+};
@@ -0,0 +1,320 @@
+#include "UploadBatch.h"
+
+UploadBatch::UploadBatch()
+{
+
+}
+
+UploadBatch::~UploadBatch()
+{
+
+}
+
+UploadBatch::UploadBatch(StagingRing* stagingRing, MipGenerator* mipGenerator, uint32_t transferFamily, uint32_t graphicsFamily)
+{
+    this->stagingRing = stagingRing;
+    this->mipGenerator = mipGenerator;
+    this->transferFamily = transferFamily;
+    this->graphicsFamily = graphicsFamily;
+}
+
+void UploadBatch::copyToBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+    copyToBuffer([data](void* destination, VkDeviceSize offset, VkDeviceSize chunkSize)
+    {
+        memcpy(destination, static_cast<const char*>(data) + offset, static_cast<size_t>(chunkSize));
+    }, size, dstBuffer, dstOffset);
+}
+
+void UploadBatch::copyToBuffer(const UploadSource& source, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+    VkDeviceSize maxChunkSize = stagingRing->getSize() / UPLOAD_CHUNK_DIVISOR;
+    VkDeviceSize copied = 0;
+
+    while (copied < size)
+    {
+        VkDeviceSize chunkSize = std::min(size - copied, maxChunkSize);
+        StagingRegion region = stage(chunkSize, 4);
+        source(region.data, copied, chunkSize);
+
+        VkBufferCopy bufferCopyRegion = {};
+        bufferCopyRegion.srcOffset = region.offset;
+        bufferCopyRegion.dstOffset = dstOffset + copied;
+        bufferCopyRegion.size = chunkSize;
+        vkCmdCopyBuffer(getCommandBuffer(), region.buffer, dstBuffer, 1, &bufferCopyRegion);
+
+        copied += chunkSize;
+    }
+
+    releaseBuffer(dstBuffer, dstOffset, size);
+}
+
+void UploadBatch::copyToImage(const void* data, uint32_t width, uint32_t height, VkFormat format, uint32_t mipLevel, VkImage image)
+{
+    uint32_t blockExtent, blockSize;
+    if (!TextureLoader::getFormatBlock(format, &blockExtent, &blockSize))
+    {
+        throw std::runtime_error("Unknown texel block of image format!");
+    }
+
+    // Compressed formats are copied in whole rows of blocks (4 texel rows for 4x4 blocks)
+    uint32_t blockRows = (height + blockExtent - 1) / blockExtent;
+    VkDeviceSize rowSize = static_cast<VkDeviceSize>((width + blockExtent - 1) / blockExtent) * blockSize;
+    if (rowSize > stagingRing->getSize())
+    {
+        throw std::runtime_error("Image row is bigger than Staging Ring!");
+    }
+
+    // Whole rows per chunk, at least one
+    uint32_t rowsPerChunk = static_cast<uint32_t>(std::max<VkDeviceSize>(1, (stagingRing->getSize() / UPLOAD_CHUNK_DIVISOR) / rowSize));
+    uint32_t row = 0;
+
+    while (row < blockRows)
+    {
+        uint32_t rowCount = std::min(rowsPerChunk, blockRows - row);
+        VkDeviceSize chunkSize = rowSize * rowCount;
+
+        // Buffer offset of image copy has to be a multiple of texel block size and 4
+        StagingRegion region = stage(chunkSize, blockSize * 4);
+        memcpy(region.data, static_cast<const char*>(data) + rowSize * row, static_cast<size_t>(chunkSize));
+
+        // Last block row may reach past image edge - extent is clamped to image size
+        uint32_t firstTexelRow = row * blockExtent;
+        uint32_t texelRowCount = std::min(rowCount * blockExtent, height - firstTexelRow);
+
+        VkBufferImageCopy imageRegion = {};
+        imageRegion.bufferOffset = region.offset;                               // Offset into staging ring
+        imageRegion.bufferRowLength = 0;                                        // Rows are tightly packed
+        imageRegion.bufferImageHeight = 0;
+        imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageRegion.imageSubresource.mipLevel = mipLevel;
+        imageRegion.imageSubresource.baseArrayLayer = 0;
+        imageRegion.imageSubresource.layerCount = 1;
+        imageRegion.imageOffset = { 0, static_cast<int32_t>(firstTexelRow), 0 };  // Chunk starts at its first row
+        imageRegion.imageExtent = { width, texelRowCount, 1 };
+
+        vkCmdCopyBufferToImage(getCommandBuffer(), region.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageRegion);
+
+        row += rowCount;
+    }
+}
+
+void UploadBatch::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+{
+    VkBufferCopy bufferCopyRegion = {};
+    bufferCopyRegion.srcOffset = srcOffset;
+    bufferCopyRegion.dstOffset = dstOffset;
+    bufferCopyRegion.size = size;
+
+    vkCmdCopyBuffer(getCommandBuffer(), srcBuffer, dstBuffer, 1, &bufferCopyRegion);
+
+    releaseBuffer(dstBuffer, dstOffset, size);
+}
+
+void UploadBatch::transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    recordImageLayoutTransition(getCommandBuffer(), image, oldLayout, newLayout);
+}
+
+void UploadBatch::releaseImage(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    if (transferFamily == graphicsFamily)
+    {
+        transitionImageLayout(image, oldLayout, newLayout);
+        return;
+    }
+
+    // Release and acquire have to describe the same transition - it is executed once, between them
+    VkImageMemoryBarrier imageMemoryBarrier = {};
+    imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageMemoryBarrier.oldLayout = oldLayout;
+    imageMemoryBarrier.newLayout = newLayout;
+    imageMemoryBarrier.srcQueueFamilyIndex = transferFamily;
+    imageMemoryBarrier.dstQueueFamilyIndex = graphicsFamily;
+    imageMemoryBarrier.image = image;
+    imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
+    imageMemoryBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+    imageMemoryBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+    getCommandBuffer();
+    imageOwnershipBarriers.push_back(imageMemoryBarrier);
+}
+
+void UploadBatch::generateMipmaps(VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+{
+    if (transferFamily == graphicsFamily)
+    {
+        mipGenerator->record(getCommandBuffer(), image, format, width, height, mipLevels);
+        return;
+    }
+
+    // Hand image over still as transfer destination, levels are generated once graphics queue owns it
+    releaseImage(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    MipJob mipJob = { image, format, width, height, mipLevels };
+    mipJobs.push_back(mipJob);
+}
+
+void UploadBatch::uploadTexture(const TextureData& texture, VkImage image)
+{
+    transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    for (uint32_t i = 0; i < texture.levels.size(); i++)
+    {
+        const TextureLevel& level = texture.levels[i];
+        copyToImage(texture.getData() + level.offset, level.width, level.height, texture.format, i, image);
+    }
+
+    if (texture.generateMipmaps && texture.mipLevels > 1)
+    {
+        generateMipmaps(image, texture.format, texture.width, texture.height, texture.mipLevels);
+    }
+    else
+    {
+        releaseImage(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+}
+
+void UploadBatch::releaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (transferFamily == graphicsFamily)
+    {
+        return;
+    }
+
+    VkBufferMemoryBarrier bufferMemoryBarrier = {};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcQueueFamilyIndex = transferFamily;
+    bufferMemoryBarrier.dstQueueFamilyIndex = graphicsFamily;
+    bufferMemoryBarrier.buffer = buffer;
+    bufferMemoryBarrier.offset = offset;
+    bufferMemoryBarrier.size = size;
+
+    bufferOwnershipBarriers.push_back(bufferMemoryBarrier);
+}
+
+UploadToken UploadBatch::submit()
+{
+    // Nothing recorded - token 0 is always complete
+    if (commandBuffer == VK_NULL_HANDLE)
+    {
+        return 0;
+    }
+
+    // Same queue - buffer copies don't change layouts, so one barrier makes all of them visible to later draws
+    if (transferFamily == graphicsFamily)
+    {
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = UPLOAD_CONSUMER_ACCESS;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, UPLOAD_CONSUMER_STAGES, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        UploadToken token = stagingRing->submit(commandBuffer);
+        commandBuffer = VK_NULL_HANDLE;
+        earlyToken = 0;
+
+        mipGenerator->endBatch(token, stagingRing);
+
+        return token;
+    }
+
+    // Release - make copies available and give up ownership (destination access is ignored on releasing queue)
+    for (size_t i = 0; i < bufferOwnershipBarriers.size(); i++)
+    {
+        bufferOwnershipBarriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferOwnershipBarriers[i].dstAccessMask = 0;
+    }
+    for (size_t i = 0; i < imageOwnershipBarriers.size(); i++)
+    {
+        imageOwnershipBarriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageOwnershipBarriers[i].dstAccessMask = 0;
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+        static_cast<uint32_t>(bufferOwnershipBarriers.size()), bufferOwnershipBarriers.data(),
+        static_cast<uint32_t>(imageOwnershipBarriers.size()), imageOwnershipBarriers.data());
+
+    // Acquire - on graphics queue after semaphore, makes data visible to rendering (source access is ignored on acquiring queue)
+    for (size_t i = 0; i < bufferOwnershipBarriers.size(); i++)
+    {
+        bufferOwnershipBarriers[i].srcAccessMask = 0;
+        bufferOwnershipBarriers[i].dstAccessMask = UPLOAD_CONSUMER_ACCESS;
+    }
+    for (size_t i = 0; i < imageOwnershipBarriers.size(); i++)
+    {
+        imageOwnershipBarriers[i].srcAccessMask = 0;
+        imageOwnershipBarriers[i].dstAccessMask = UPLOAD_ACQUIRE_ACCESS;
+    }
+
+    VkCommandBuffer acquireCommandBuffer = stagingRing->beginAcquireCommands();
+    vkCmdPipelineBarrier(acquireCommandBuffer, UPLOAD_ACQUIRE_STAGES, UPLOAD_ACQUIRE_STAGES, 0, 0, nullptr,
+        static_cast<uint32_t>(bufferOwnershipBarriers.size()), bufferOwnershipBarriers.data(),
+        static_cast<uint32_t>(imageOwnershipBarriers.size()), imageOwnershipBarriers.data());
+
+    // Acquired images are owned by graphics queue now - generate their mip levels there
+    for (const auto& mipJob : mipJobs)
+    {
+        mipGenerator->record(acquireCommandBuffer, mipJob.image, mipJob.format, mipJob.width, mipJob.height, mipJob.mipLevels);
+    }
+
+    // Semaphore wait at consumer stages chains copies -> release -> acquire -> rendering
+    UploadToken token = stagingRing->submit(commandBuffer, acquireCommandBuffer, UPLOAD_ACQUIRE_STAGES);
+
+    commandBuffer = VK_NULL_HANDLE;
+    bufferOwnershipBarriers.clear();
+    imageOwnershipBarriers.clear();
+    mipJobs.clear();
+    earlyToken = 0;
+
+    mipGenerator->endBatch(token, stagingRing);
+
+    return token;
+}
+
+void UploadBatch::discard()
+{
+    stagingRing->discard(commandBuffer);
+    commandBuffer = VK_NULL_HANDLE;
+    bufferOwnershipBarriers.clear();
+    imageOwnershipBarriers.clear();
+    mipJobs.clear();
+
+    // Compute resources of dropped mip generation never reach GPU - token 0 is always complete
+    mipGenerator->endBatch(0, stagingRing);
+
+    stagingRing->wait(earlyToken);
+    earlyToken = 0;
+}
+
+bool UploadBatch::isEmpty()
+{
+    return commandBuffer == VK_NULL_HANDLE;
+}
+
+VkCommandBuffer UploadBatch::getCommandBuffer()
+{
+    if (commandBuffer == VK_NULL_HANDLE)
+    {
+        commandBuffer = stagingRing->beginCommands();
+    }
+
+    return commandBuffer;
+}
+
+StagingRegion UploadBatch::stage(VkDeviceSize size, VkDeviceSize alignment)
+{
+    StagingRegion region;
+    if (!stagingRing->tryAllocate(size, alignment, &region))
+    {
+        // Ring is full of this batch's own data - submit what is recorded so far to let ring recycle it
+        // Queue executes submits in order, so layout transitions recorded before still happen before later copies
+        earlyToken = submit();
+        region = stagingRing->allocate(size, alignment);
+    }
+
+    return region;
+}
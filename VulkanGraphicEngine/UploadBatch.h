@@ -0,0 +1,103 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <functional>
+
+#include "Utilities.h"
+#include "StagingRing.h"
+#include "MipGenerator.h"
+#include "TextureLoader.h"
+
+const VkDeviceSize UPLOAD_CHUNK_DIVISOR = 4;    // Staged copies are split into chunks of at most ring size / divisor
+
+// Stages where uploaded data is consumed by rendering
+const VkPipelineStageFlags UPLOAD_CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+const VkAccessFlags UPLOAD_CONSUMER_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+// Stages and access of acquiring queue - rendering, plus mip generation of acquired images (blits or compute)
+const VkPipelineStageFlags UPLOAD_ACQUIRE_STAGES = UPLOAD_CONSUMER_STAGES | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+const VkAccessFlags UPLOAD_ACQUIRE_ACCESS = UPLOAD_CONSUMER_ACCESS | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+// Writes size bytes of uploaded data starting at offset into destination (mapped staging memory)
+typedef std::function<void(void* destination, VkDeviceSize offset, VkDeviceSize size)> UploadSource;
+
+// Records any number of copies and layout transitions into one command buffer and submits them together.
+// Data is staged in shared staging ring - if the batch outgrows the ring, recorded part is submitted early and recording continues.
+// When uploads run on a separate transfer family, written resources are released to graphics family and acquired there on submit.
+class UploadBatch
+{
+public:
+    UploadBatch();
+    UploadBatch(StagingRing* stagingRing, MipGenerator* mipGenerator, uint32_t transferFamily, uint32_t graphicsFamily);
+
+    // Stage data and copy it into buffer at dstOffset
+    void copyToBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset);
+
+    // Same, but data is written into staging memory by source chunk by chunk - e.g. read from file without intermediate buffer
+    void copyToBuffer(const UploadSource& source, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset);
+
+    // Stage tightly packed texel blocks of format and copy them to mip level of image (image has to be in TRANSFER_DST_OPTIMAL layout)
+    void copyToImage(const void* data, uint32_t width, uint32_t height, VkFormat format, uint32_t mipLevel, VkImage image);
+
+    // Copy between two device buffers (source has to be usable on upload queue)
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+
+    // Layout transition on upload queue
+    void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+    // Last transition of uploaded image - hands it over to graphics family on the way when upload queue is in another family
+    void releaseImage(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+    // Fill remaining mip levels from first one and make image shader readable (all levels have to be in TRANSFER_DST_OPTIMAL)
+    // Generation needs graphics queue - with separate transfer family it is recorded after acquire on graphics queue
+    void generateMipmaps(VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+    // Whole texture upload - transition, copy of every level in data and mip generation of the rest (image has to have texture.mipLevels)
+    void uploadTexture(const TextureData& texture, VkImage image);
+
+    // Submit everything recorded so far, token can be waited on through staging ring
+    // Written buffers are made visible to vertex input and shader reads of later commands on the queue
+    UploadToken submit();
+
+    // Drop everything recorded since last submit, e.g. after a failed upload. Parts of batch submitted early (ring was full)
+    // are waited for, so resources the batch wrote to can be destroyed or reused right after.
+    void discard();
+
+    bool isEmpty();
+
+    ~UploadBatch();
+
+private:
+    // Mip generation waiting for acquire of its image on graphics queue
+    struct MipJob {
+        VkImage image;
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+    };
+
+    StagingRing* stagingRing;
+    MipGenerator* mipGenerator;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;     // VK_NULL_HANDLE until first command is recorded
+
+    uint32_t transferFamily;
+    uint32_t graphicsFamily;
+
+    // Ownership transfers recorded at submit - release on upload queue, matching acquire on graphics queue
+    std::vector<VkBufferMemoryBarrier> bufferOwnershipBarriers;
+    std::vector<VkImageMemoryBarrier> imageOwnershipBarriers;
+    std::vector<MipJob> mipJobs;
+    UploadToken earlyToken = 0;                         // Last early submit of batch, 0 - none since batch started
+
+    void releaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+    VkCommandBuffer getCommandBuffer();
+    StagingRegion stage(VkDeviceSize size, VkDeviceSize alignment);
+};
@@ -1,29 +1,33 @@
 #pragma once
 
 #include <fstream>
+#include <algorithm>
 
 #define GLFW_INCLUDE_VULKAN
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "MemoryAllocator.h"
+#include "AssetArchive.h"
+#include "MeshData.h"
+
 const int MAX_FRAME_DRAWS = 2;
 const int MAX_OBJECTS = 2;
+const int MAX_TEXTURES = 64;         // Texture descriptor sets available - startup and streamed textures together
+const float DEFAULT_ANISOTROPY = 16.0f;  // Texture sampler anisotropy, clamped to device limit
+const uint32_t MAX_INSTANCES = 131072;   // Objects drawn per frame (ObjectData elements) - every mesh drawn without instancing counts as one
+const uint32_t MAX_INDIRECT_DRAWS = MAX_INSTANCES;  // Indirect draw commands per frame - at most one per object
+const uint32_t OCCLUSION_BUFFER_WIDTH = 256;     // Pixels across depth buffer of CPU occlusion culling - height follows swapchain aspect
 
 const std::vector<const char* > deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
-// Vertex data representation
-struct Vertex {
-    glm::vec3 pos;  // Vertex position (x, y, z)
-    glm::vec3 col;  // Vertex colour (r, g, b)
-    glm::vec2 tex;  // Texture Coords (u, v)
-};
-
 struct QueueFamilyIndices {
     int graphicsFamily = -1;
     int presentationFamily = -1;
+    int transferFamily = -1;        // Transfer-only family if device has one, otherwise same as graphicsFamily
 
     bool isValid() {
         return graphicsFamily >= 0 && presentationFamily >= 0;
@@ -32,6 +36,10 @@ struct QueueFamilyIndices {
     bool sameFamily() {
         return graphicsFamily == presentationFamily;
     }
+
+    bool separateTransfer() {
+        return transferFamily >= 0 && transferFamily != graphicsFamily;
+    }
 };
 
 struct SwapChainDetails {
@@ -69,26 +77,44 @@ static std::vector<char> readFile(const std::string& filename)
     return fileBuffer;
 }
 
-static uint32_t findMemoryTypeIndex(VkPhysicalDevice physicalDevice, uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+// Code has to stay alive only for duration of the call - mapped archive memory can be passed directly
+static VkShaderModule createShaderModule(VkDevice device, const void* code, size_t codeSize)
+{
+    VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderModuleCreateInfo.codeSize = codeSize;
+    shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(code);
+
+    VkShaderModule shaderModule;
+    VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a shader module!");
+    }
+
+    return shaderModule;
+}
+
+static VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& shaders)
 {
-    VkPhysicalDeviceMemoryProperties memoryProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    return createShaderModule(device, shaders.data(), shaders.size());
+}
 
-    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+// Shader from packed archive if it has one (no copy), otherwise read from disk
+static VkShaderModule loadShaderModule(VkDevice device, const AssetArchive* archive, const std::string& filename)
+{
+    const char* code;
+    size_t codeSize;
+    if (archive && archive->isOpen() && archive->find(filename, &code, &codeSize))
     {
-        // 000000000100100011011    - shifting over all possible devices
-
-        if ((allowedTypes & (1 << i))                                                           // Index of memory type must match corresponding bit in allowedTypes
-            && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties     // Desired property bit flags are part of memory type's property flags
-            )
-        {
-            return i;       // This memory type is valid
-        }
+        return createShaderModule(device, code, codeSize);
     }
+
+    return createShaderModule(device, readFile(filename));
 }
 
-static void createBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage
-    , VkMemoryPropertyFlags bufferProperties, VkBuffer* buffer, VkDeviceMemory* bufferMemory)
+static void createBuffer(MemoryAllocator* allocator, VkDevice device, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage
+    , VkMemoryPropertyFlags bufferProperties, VkBuffer* buffer, MemoryAllocation* bufferMemory)
 {
     VkBufferCreateInfo bufferInfo = {};                         // Information to create a buffer (doesn't include assign memory)
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -102,24 +128,57 @@ static void createBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDev
         throw std::runtime_error("Failed to create a Vertex Buffer!");
     }
 
-    // GET BUFFER MEMORY REQUIREMENTS
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(device, *buffer, &memoryRequirements);
+    // ALLOCATE MEMORY TO BUFFER
+    // Allocator picks memory type with required bit flags, sub-allocates it from a shared block and binds it to buffer
+    *bufferMemory = allocator->allocateBufferMemory(*buffer, bufferProperties);
+}
 
-    // ALLOCATE MEMEORY TO BUFFER
-    VkMemoryAllocateInfo memoryAllocateInfo = {};
-    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex = findMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits, bufferProperties);    // Index of memory type on Physical Device that has required bit flags
+static VkImage createImage(MemoryAllocator* allocator, VkDevice device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
+    VkImageUsageFlags useFlags, VkMemoryPropertyFlags propertyFlags, MemoryAllocation* imageMemory, uint32_t mipLevels = 1)
+{
+    // Create Image
+
+    VkImageCreateInfo imageCreateInfo = {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;                   // 3D - Volumetric Data
+    imageCreateInfo.extent.width = width;                           // Width of image extent
+    imageCreateInfo.extent.height = height;                         // Height of image extent
+    imageCreateInfo.extent.depth = 1;                               // Depth of image (just 1, no 3D aspect)
+    imageCreateInfo.mipLevels = mipLevels;                          // Number of mipmap levels
+    imageCreateInfo.arrayLayers = 1;                                // Number of levels in image array
+    imageCreateInfo.format = format;
+    imageCreateInfo.tiling = tiling;                                // How image data should be "tiled" (aranged for optimal reading)
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;      // Layout of image data on creation
+    imageCreateInfo.usage = useFlags;                               // Bit flags defining what image will be used for
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;                // Number of samples for multisampling
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;        // Whether image can be shared between queues
 
-    result = vkAllocateMemory(device, &memoryAllocateInfo, nullptr, bufferMemory);
+    VkImage image;
+    VkResult result = vkCreateImage(device, &imageCreateInfo, nullptr, &image);
     if (result != VK_SUCCESS)
     {
-        throw std::runtime_error("Failed to allcate Vertex Buffer Memory!");
+        throw std::runtime_error("Failed to create Image!");
     }
 
-    vkBindBufferMemory(device, *buffer, *bufferMemory, 0);
+    // Create Memory for image
+    // Allocator sub-allocates memory based on image requirements (big images get dedicated memory) and connects it to image
+    *imageMemory = allocator->allocateImageMemory(image, propertyFlags);
 
+    return image;
+}
+
+// Number of mip levels down to 1x1
+static uint32_t getMipLevels(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    uint32_t size = std::max(width, height);
+    while (size > 1)
+    {
+        size /= 2;
+        levels++;
+    }
+
+    return levels;
 }
 
 static VkCommandBuffer beginCommandBuffer(VkDevice device, VkCommandPool commandPool)
@@ -146,67 +205,8 @@ static VkCommandBuffer beginCommandBuffer(VkDevice device, VkCommandPool command
     return commandBuffer;
 }
 
-static void endAndSubmitCommandBuffer(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkCommandBuffer commandBuffer)
+static void recordImageLayoutTransition(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
 {
-    vkEndCommandBuffer(commandBuffer);
-
-    // Queue Submission Information
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    // Submit transfer command to transfer queue and wait until it finishes
-    vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);
-
-    // Free temporary command buffer
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-}
-
-static void copyBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool,
-    VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize)
-{
-    // Create Buffer
-    VkCommandBuffer transferCommandBuffer = beginCommandBuffer(device, transferCommandPool);
-
-    // Origin of data to copy from and to
-    VkBufferCopy bufferCopyRegion = {};
-    bufferCopyRegion.srcOffset = 0;
-    bufferCopyRegion.dstOffset = 0;
-    bufferCopyRegion.size = bufferSize;
-
-    // Command to copy src buffer to dst buffer
-    vkCmdCopyBuffer(transferCommandBuffer, srcBuffer, dstBuffer, 1, &bufferCopyRegion);
-
-    endAndSubmitCommandBuffer(device, transferCommandPool, transferQueue, transferCommandBuffer);
-}
-
-static void copyImageBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool, VkBuffer srcBuffer, VkImage image, uint32_t width, uint32_t height)
-{
-    VkCommandBuffer transferCommandBuffer = beginCommandBuffer(device, transferCommandPool);
-
-    VkBufferImageCopy imageRegion = {};
-    imageRegion.bufferOffset = 0;                                           // Offset into data
-    imageRegion.bufferRowLength = 0;                                        // Row length of data to calculate data spacing
-    imageRegion.bufferImageHeight = 0;                                      // Image height to calculate data spacing
-    imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;    // What aspect of image to copy
-    imageRegion.imageSubresource.mipLevel = 0;                              // Mipmap level to copy
-    imageRegion.imageSubresource.baseArrayLayer = 0;                        // Starting array layer
-    imageRegion.imageSubresource.layerCount = 1;                            // Number of layers to copy starting at baseArrayLayer
-    imageRegion.imageOffset = { 0, 0, 0 };                                  // Offset into image (as opposed to raw data in bufferOffset)
-    imageRegion.imageExtent = { width, height, 1 };                         // Size of region to copy as (x, y, z) values
-
-    // Copy Buffer to given image
-    vkCmdCopyBufferToImage(transferCommandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageRegion);
-
-    endAndSubmitCommandBuffer(device, transferCommandPool, transferQueue, transferCommandBuffer);
-}
-
-static void transitionImageLayout(VkDevice device, VkQueue queue, VkCommandPool commandPool, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
-{
-    VkCommandBuffer commandBuffer = beginCommandBuffer(device, commandPool);
-
     VkImageMemoryBarrier imageMemoryBarrier = {};
     imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     imageMemoryBarrier.oldLayout = oldLayout;                                    // Layout to transition from
@@ -216,7 +216,7 @@ static void transitionImageLayout(VkDevice device, VkQueue queue, VkCommandPool
     imageMemoryBarrier.image = image;                                            // Image being accessed and modified as part of barrier
     imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;  // Aspect of image being altered
     imageMemoryBarrier.subresourceRange.baseMipLevel = 0;                        // First mip level to start alterations on
-    imageMemoryBarrier.subresourceRange.levelCount = 1;                          // Number of mip levels to alter starting from baseMipLevel
+    imageMemoryBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;    // Number of mip levels to alter starting from baseMipLevel
     imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;                      // First layer to start alterations on
     imageMemoryBarrier.subresourceRange.layerCount = 1;                          // Number of layers to alter starting from baseArrayLayer
 
@@ -250,6 +250,4 @@ static void transitionImageLayout(VkDevice device, VkQueue queue, VkCommandPool
         0, nullptr,                            // Buffer Memory Barrier + data
         1, &imageMemoryBarrier                 // Image Memory Barrier + data
     );
-
-    endAndSubmitCommandBuffer(device, commandPool, queue, commandBuffer);
-}
\ No newline at end of file
+}
@@ -0,0 +1,149 @@
+#include "VertexLayout.h"
+
+#include <cmath>
+
+uint32_t VertexPacker::getStride(VertexLayout layout)
+{
+    return layout == VertexLayout::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+VertexLayout VertexPacker::selectLayout(const std::vector<Vertex>& vertices)
+{
+    for (const auto& vertex : vertices)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (vertex.col[i] < 0.0f || vertex.col[i] > 1.0f)
+            {
+                return VertexLayout::Standard;
+            }
+        }
+        if (std::abs(vertex.tex.x) > COMPACT_MAX_TEX_COORD || std::abs(vertex.tex.y) > COMPACT_MAX_TEX_COORD)
+        {
+            return VertexLayout::Standard;
+        }
+    }
+
+    return VertexLayout::Compact;
+}
+
+std::vector<unsigned char> VertexPacker::pack(VertexLayout layout, const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    std::vector<unsigned char> packed(vertices.size() * getStride(layout));
+    if (layout == VertexLayout::Standard)
+    {
+        memcpy(packed.data(), vertices.data(), packed.size());
+        return packed;
+    }
+
+    // Bounds are mapped to [-1, 1] - flat dimension gets extent 1 so it doesn't divide by zero
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+    for (int i = 0; i < 3; i++)
+    {
+        if (extent[i] <= 0.0f)
+        {
+            extent[i] = 1.0f;
+        }
+    }
+
+    CompactVertex* compactVertices = reinterpret_cast<CompactVertex*>(packed.data());
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        const Vertex& vertex = vertices[v];
+        CompactVertex& compact = compactVertices[v];
+
+        for (int i = 0; i < 3; i++)
+        {
+            float normalized = std::min(std::max((vertex.pos[i] - center[i]) / extent[i], -1.0f), 1.0f);
+            compact.pos[i] = static_cast<int16_t>(std::lround(normalized * 32767.0f));
+            compact.col[i] = static_cast<uint8_t>(std::lround(std::min(std::max(vertex.col[i], 0.0f), 1.0f) * 255.0f));
+        }
+        compact.pos[3] = 0;
+        compact.col[3] = 255;
+        compact.tex[0] = floatToHalf(vertex.tex.x);
+        compact.tex[1] = floatToHalf(vertex.tex.y);
+    }
+
+    return packed;
+}
+
+glm::mat4 VertexPacker::getDequantization(VertexLayout layout, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::mat4 dequantization(1.0f);
+    if (layout == VertexLayout::Standard)
+    {
+        return dequantization;
+    }
+
+    // position = center + extent * stored (same flat dimension handling as pack)
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+    for (int i = 0; i < 3; i++)
+    {
+        dequantization[i][i] = extent[i] > 0.0f ? extent[i] : 1.0f;
+        dequantization[3][i] = center[i];
+    }
+
+    return dequantization;
+}
+
+void VertexPacker::getBounds(const std::vector<Vertex>& vertices, glm::vec3* boundsMin, glm::vec3* boundsMax)
+{
+    *boundsMin = glm::vec3(0.0f);
+    *boundsMax = glm::vec3(0.0f);
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    *boundsMin = *boundsMax = vertices[0].pos;
+    for (const auto& vertex : vertices)
+    {
+        *boundsMin = glm::min(*boundsMin, vertex.pos);
+        *boundsMax = glm::max(*boundsMax, vertex.pos);
+    }
+}
+
+uint16_t VertexPacker::floatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 31)
+    {
+        // Overflow (and NaN / infinity) - largest half keeps geometry usable
+        return static_cast<uint16_t>(sign | 0x7BFF);
+    }
+    if (exponent <= 0)
+    {
+        // Denormal or zero
+        if (exponent < -10)
+        {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+        {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Round to nearest even - carry into exponent is still a correct encoding
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        half = std::min(half + 1, 0x7BFFu);
+    }
+    return static_cast<uint16_t>(sign | half);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "MeshData.h"
+
+// How vertices of a mesh are stored in its vertex buffer - every layout feeds the same shader inputs,
+// only pipeline vertex input formats differ (fetch converts to float)
+enum class VertexLayout : uint32_t {
+    Standard = 0,       // Vertex - 32 bytes of float
+    Compact = 1         // CompactVertex - 16 bytes, positions relative to mesh bounds (dequantization is folded into model matrix)
+};
+
+const uint32_t VERTEX_LAYOUT_COUNT = 2;
+
+const float COMPACT_MAX_TEX_COORD = 2.0f;       // Half float keeps ~1 texel of 1024 texture precision up to here
+
+struct CompactVertex {
+    int16_t pos[4];     // SNORM16 x, y, z in mesh bounds (w unused)
+    uint8_t col[4];     // UNORM8 r, g, b (a unused)
+    uint16_t tex[2];    // Half float u, v
+};
+
+// Converts Vertex data into other layouts
+class VertexPacker
+{
+public:
+    static uint32_t getStride(VertexLayout layout);
+
+    // Compact unless data doesn't fit it (colours out of [0, 1] or texture coordinates tiled too far for half precision)
+    static VertexLayout selectLayout(const std::vector<Vertex>& vertices);
+
+    // Bounds are used by Compact layout - positions are stored relative to them
+    static std::vector<unsigned char> pack(VertexLayout layout, const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Maps stored position back to mesh space (identity for Standard)
+    static glm::mat4 getDequantization(VertexLayout layout, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    static void getBounds(const std::vector<Vertex>& vertices, glm::vec3* boundsMin, glm::vec3* boundsMax);
+
+    static uint16_t floatToHalf(float value);
+};
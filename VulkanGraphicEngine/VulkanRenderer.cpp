@@ -12,6 +12,9 @@ int VulkanRenderer::init(GLFWwindow* window)
 
     try
     {
+        // Packed assets are optional - everything falls back to loose files
+        assetArchive.open(ASSET_ARCHIVE_FILE);
+
         createInstance();
         createSurface();
         getPhysicalDevice();
@@ -19,11 +22,13 @@ int VulkanRenderer::init(GLFWwindow* window)
         createSwapchain();
         createRenderPass();
         createDescriptorSetLayout();
-        createPushConstantRange();
         createGraphicsPipeline();
         createDepthBufferImage();
         createFramebuffers();
         createCommandPool();
+        createGeometryArena();
+        createStagingRing();
+        createAssetStreamer();
         createCommandBuffers();
         createTextureSampler();
         //allocateDynamicBufferTransferSpace();
@@ -32,6 +37,10 @@ int VulkanRenderer::init(GLFWwindow* window)
         createDescriptorSets();
         createSynchronisation();
 
+        occlusionRasterizer = OcclusionRasterizer(&frameThreadPool, OCCLUSION_BUFFER_WIDTH,
+            OCCLUSION_BUFFER_WIDTH * swapChainExtent.height / swapChainExtent.width);
+        renderQueue = RenderQueue(&frameThreadPool);
+
         // First  : Angle of the camera
         // Second : Aspect Ratio
         // Third  : How close could be seen
@@ -68,14 +77,22 @@ int VulkanRenderer::init(GLFWwindow* window)
             2, 3, 0
         };
 
-        int firstTexture = createTexture("wall_brick_plain.tga");
-        int secondTexture = createTexture("wall_brick_plain.tga");
+        // Decoded in parallel and uploaded in one submit
+        std::vector<int> textures = createTextures({ "wall_brick_plain.tga", "wall_brick_plain.tga" });
+        int firstTexture = textures[0];
+        int secondTexture = textures[1];
 
-        meshes.push_back(Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, graphicsQueue,
-            graphicsCommandPool, &meshVertices, &meshIndices, firstTexture));
+        meshes.push_back(Mesh(&geometryArena, &uploadBatch,
+            &meshVertices, &meshIndices, firstTexture));
+        sceneMeshes.push_back(static_cast<int>(meshes.size()) - 1);
 
-        meshes.push_back(Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, graphicsQueue,
-            graphicsCommandPool, &anotherMeshVertices, &meshIndices, secondTexture));
+        meshes.push_back(Mesh(&geometryArena, &uploadBatch,
+            &anotherMeshVertices, &meshIndices, secondTexture));
+        sceneMeshes.push_back(static_cast<int>(meshes.size()) - 1);
+
+        // Every texture and mesh upload goes to GPU in one submit
+        // Graphics queue executes it before first draw, no need to wait for it here
+        uploadBatch.submit();
     }
     catch (const std::runtime_error &e)
     {
@@ -94,6 +111,207 @@ void VulkanRenderer::updateModel(int modelId, glm::mat4 model)
     meshes[modelId].setModel(model);
 }
 
+void VulkanRenderer::updateColour(int modelId, glm::vec4 colour)
+{
+    if (modelId >= meshes.size())
+        return;
+
+    meshes[modelId].setColour(colour);
+}
+
+void VulkanRenderer::setInstances(int meshId, std::vector<glm::mat4> models, std::vector<int> textureIndices)
+{
+    if (!textureIndices.empty() && textureIndices.size() != models.size())
+    {
+        throw std::runtime_error("Every instance needs a texture index!");
+    }
+    if (models.size() > MAX_INSTANCES)
+    {
+        throw std::runtime_error("Too many instances for instance ring!");
+    }
+
+    InstanceBatch& batch = instanceBatches[meshId];
+    batch.models = std::move(models);
+    batch.textureIndices = std::move(textureIndices);
+}
+
+void VulkanRenderer::clearInstances(int meshId)
+{
+    instanceBatches.erase(meshId);
+}
+
+void VulkanRenderer::setIndirectDrawing(bool indirect)
+{
+    indirectDrawing = indirect;
+}
+
+bool VulkanRenderer::isIndirectDrawingSupported()
+{
+    return indirectDrawingSupported;
+}
+
+DrawStats VulkanRenderer::getDrawStats()
+{
+    return drawStats;
+}
+
+void VulkanRenderer::setGpuCulling(bool culling)
+{
+    gpuCulling = culling;
+}
+
+void VulkanRenderer::setOcclusionCulling(bool culling)
+{
+    occlusionCulling = culling;
+}
+
+void VulkanRenderer::setCpuCulling(bool culling)
+{
+    cpuCulling = culling;
+}
+
+void VulkanRenderer::setCpuCullKernel(CullKernel kernel)
+{
+    frustumCuller.setKernel(kernel);
+    occlusionRasterizer.setKernel(kernel);
+}
+
+void VulkanRenderer::setOccluder(int meshId, std::vector<glm::vec3> positions, std::vector<uint32_t> indices)
+{
+    if (indices.size() % 3 != 0)
+    {
+        throw std::runtime_error("Occluder indices have to form triangles!");
+    }
+
+    OccluderGeometry& occluder = occluders[meshId];
+    occluder.positions = std::move(positions);
+    occluder.indices = std::move(indices);
+}
+
+void VulkanRenderer::clearOccluder(int meshId)
+{
+    occluders.erase(meshId);
+}
+
+void VulkanRenderer::setCpuOcclusionCulling(bool culling)
+{
+    cpuOcclusionCulling = culling;
+}
+
+CullStats VulkanRenderer::getCullStats()
+{
+    if (indirectDrawing && indirectDrawingSupported && gpuCulling)
+    {
+        return gpuCuller.getStats();
+    }
+
+    return cullStats;
+}
+
+AssetHandle VulkanRenderer::streamTexture(const std::string& filename, float priority)
+{
+    return assetStreamer.requestTexture(filename, priority);
+}
+
+AssetHandle VulkanRenderer::streamMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, AssetHandle texture, float priority,
+    VertexLayout vertexLayout)
+{
+    return assetStreamer.requestMesh(std::move(vertices), std::move(indices), texture, priority, vertexLayout);
+}
+
+std::vector<AssetHandle> VulkanRenderer::streamModel(const std::string& filename, float priority)
+{
+    size_t extension = filename.find_last_of('.');
+    std::string meshFilename = "Models/" + filename.substr(0, extension) + ".vmesh";
+
+    // Models are imported by AssetCooker - only table of submeshes is read here, geometry is read by streaming thread
+    MeshFile meshFile;
+    try
+    {
+        meshFile.open(meshFilename, &assetArchive);
+    }
+    catch (const std::runtime_error& e)
+    {
+        throw std::runtime_error("Model Models/" + filename + " has no up to date cooked mesh, run AssetCooker first (" + e.what() + ")");
+    }
+
+    std::vector<AssetHandle> meshHandles;
+    std::map<std::string, AssetHandle> textureHandles;
+    for (uint32_t i = 0; i < meshFile.getSubmeshCount(); i++)
+    {
+        std::string texture = meshFile.getTexture(i);
+
+        AssetHandle textureHandle = INVALID_ASSET;
+        if (!texture.empty())
+        {
+            auto requested = textureHandles.find(texture);
+            if (requested == textureHandles.end())
+            {
+                requested = textureHandles.insert({ texture, assetStreamer.requestTexture(texture, priority) }).first;
+            }
+            textureHandle = requested->second;
+        }
+
+        meshHandles.push_back(assetStreamer.requestMesh(meshFilename, i, textureHandle, priority));
+    }
+
+    return meshHandles;
+}
+
+void VulkanRenderer::setAssetPriority(AssetHandle asset, float priority)
+{
+    assetStreamer.setPriority(asset, priority);
+}
+
+bool VulkanRenderer::cancelAsset(AssetHandle asset)
+{
+    return assetStreamer.cancel(asset);
+}
+
+int VulkanRenderer::getAssetIndex(AssetHandle asset)
+{
+    auto resident = residentAssets.find(asset);
+    return resident != residentAssets.end() ? resident->second : -1;
+}
+
+void VulkanRenderer::setTextureFiltering(bool mipmaps, float anisotropy)
+{
+    // Sampler is baked into every texture descriptor - nothing may be using them while they are rewritten
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    vkDeviceWaitIdle(mainDevice.logicalDevice);
+
+    textureMipmaps = mipmaps;
+    textureAnisotropy = anisotropy;
+
+    vkDestroySampler(mainDevice.logicalDevice, textureSampler, nullptr);
+    createTextureSampler();
+
+    if (textureImageView.empty())
+    {
+        return;
+    }
+
+    // Array element i holds texture image view i - all rewritten by one write
+    std::vector<VkDescriptorImageInfo> imageInfos(textureImageView.size());
+    for (size_t i = 0; i < textureImageView.size(); i++)
+    {
+        imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfos[i].imageView = textureImageView[i];
+        imageInfos[i].sampler = textureSampler;
+    }
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = samplerDescriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = static_cast<uint32_t>(imageInfos.size());
+    descriptorWrite.pImageInfo = imageInfos.data();
+
+    vkUpdateDescriptorSets(mainDevice.logicalDevice, 1, &descriptorWrite, 0, nullptr);
+}
+
 void VulkanRenderer::draw()
 {
     // Wait for given fence to signal (open) from last draw before continuing
@@ -105,8 +323,22 @@ void VulkanRenderer::draw()
     uint32_t imageIndex;                // Index of the next image to be draw to
     vkAcquireNextImageKHR(mainDevice.logicalDevice, swapchain, std::numeric_limits<uint64_t>::max(), imageAvailable[currentFrame], VK_NULL_HANDLE, &imageIndex);
 
+    // Give back staging space (and command buffers) of uploads that finished since last frame
+    stagingRing.reclaim();
+
+    // Add streamed assets that became resident to scene
+    updateStreaming();
+
+    // Frame's fence was waited on, so its region of uniform ring is free to overwrite
+    uniformRing.beginFrame(currentFrame);
+    objectRing.beginFrame(currentFrame);
+    indirectRing.beginFrame(currentFrame);
+    if (indirectDrawingSupported)
+    {
+        gpuCuller.beginFrame(currentFrame);
+    }
+    updateUniformBuffers();
     recordCommands(imageIndex);
-    updateUniformBuffers(imageIndex);
 
     // 2. Submit a command buffer to queue for execution, make sure it waits for the image to be signalled as available before drawing and signals when it has finished rendering
     // Queue Submission Info
@@ -123,6 +355,8 @@ void VulkanRenderer::draw()
     submitInfo.signalSemaphoreCount = 1;                          // Number of semaphores to signal
     submitInfo.pSignalSemaphores = &renderFinished[currentFrame]; // Semaphores to signal when command buffer finishes
 
+    std::unique_lock<std::mutex> queueLock(queueMutex);
+
     VkResult result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, drawFences[currentFrame]);
     if (result != VK_SUCCESS)
     {
@@ -144,11 +378,16 @@ void VulkanRenderer::draw()
         throw std::runtime_error("Failed to present Image!");
     }
 
+    queueLock.unlock();
+
     currentFrame = (currentFrame + 1) % MAX_FRAME_DRAWS;
 }
 
 void VulkanRenderer::cleanup()
 {
+    // Stop streaming first - its thread submits to the same queues
+    assetStreamer.destroy();
+
     // Wait before no action being run on device before destroying
     vkDeviceWaitIdle(mainDevice.logicalDevice);
 
@@ -163,48 +402,145 @@ void VulkanRenderer::cleanup()
     {
         vkDestroyImageView(mainDevice.logicalDevice, textureImageView[i], nullptr);
         vkDestroyImage(mainDevice.logicalDevice, textureImages[i], nullptr);
-        vkFreeMemory(mainDevice.logicalDevice, textureImagesMemory[i], nullptr);
+        memoryAllocator.free(&textureImagesMemory[i]);
     }
 
+    if (indirectDrawingSupported)
+    {
+        depthPyramid.destroy();
+    }
     vkDestroyImageView(mainDevice.logicalDevice, depthBufferImageView, nullptr);
     vkDestroyImage(mainDevice.logicalDevice, depthBufferImage, nullptr);
-    vkFreeMemory(mainDevice.logicalDevice, depthBufferImageMemory, nullptr);
+    memoryAllocator.free(&depthBufferImageMemory);
 
     vkDestroyDescriptorPool(mainDevice.logicalDevice, descriptorPool, nullptr);
     vkDestroyDescriptorSetLayout(mainDevice.logicalDevice, descriptorSetLayout, nullptr);
-    for (size_t i = 0; i < swapChainImages.size(); i++)
+    if (indirectDrawingSupported)
     {
-        vkDestroyBuffer(mainDevice.logicalDevice, vpUniformBuffer[i], nullptr);
-        vkFreeMemory(mainDevice.logicalDevice, vpUniformBufferMemory[i], nullptr);
-        //vkDestroyBuffer(mainDevice.logicalDevice, modelUniformBuffer[i], nullptr);
-        //vkFreeMemory(mainDevice.logicalDevice, modelUniformBufferMemory[i], nullptr);
+        gpuCuller.destroy();
     }
+    uniformRing.destroy();
+    objectRing.destroy();
+    indirectRing.destroy();
+    mipGenerator.destroy();
+    stagingRing.destroy();
     for (size_t i = 0; i < meshes.size(); i++)
     {
-        meshes[i].destroyBuffers();
+        meshes[i].freeGeometry();
+    }
+    for (size_t i = 0; i < waitingMeshes.size(); i++)
+    {
+        waitingMeshes[i].mesh.freeGeometry();
     }
+    geometryArena.destroy();
     for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
     {
         vkDestroySemaphore(mainDevice.logicalDevice, renderFinished[i], nullptr);
         vkDestroySemaphore(mainDevice.logicalDevice, imageAvailable[i], nullptr);
         vkDestroyFence(mainDevice.logicalDevice, drawFences[i], nullptr);
     }
+    if (transferCommandPool != graphicsCommandPool)
+    {
+        vkDestroyCommandPool(mainDevice.logicalDevice, transferCommandPool, nullptr);
+    }
     vkDestroyCommandPool(mainDevice.logicalDevice, graphicsCommandPool, nullptr);
     for (auto framebuffer : swapChainFramebuffers)
     {
         vkDestroyFramebuffer(mainDevice.logicalDevice, framebuffer, nullptr);
     }
-    vkDestroyPipeline(mainDevice.logicalDevice, graphicsPipeline, nullptr);
+    for (auto pipeline : graphicsPipelines)
+    {
+        vkDestroyPipeline(mainDevice.logicalDevice, pipeline, nullptr);
+    }
     vkDestroyPipelineLayout(mainDevice.logicalDevice, pipelineLayout, nullptr);
     vkDestroyRenderPass(mainDevice.logicalDevice, renderPass, nullptr);
+    vkDestroyRenderPass(mainDevice.logicalDevice, loadRenderPass, nullptr);
     for (auto image : swapChainImages)
     {
         vkDestroyImageView(mainDevice.logicalDevice, image.imageView, nullptr);
     } 
     vkDestroySwapchainKHR(mainDevice.logicalDevice, swapchain, nullptr);
     vkDestroySurfaceKHR(instance, surface, nullptr);
+    memoryAllocator.destroy();
     vkDestroyDevice(mainDevice.logicalDevice, nullptr);
     vkDestroyInstance(instance, nullptr);
+    assetArchive.close();
+}
+
+GeometryArenaStats VulkanRenderer::getGeometryStats()
+{
+    return geometryArena.getStats();
+}
+
+VkDeviceSize VulkanRenderer::compactGeometry()
+{
+    // Draws in flight read geometry that is about to move
+    vkDeviceWaitIdle(mainDevice.logicalDevice);
+
+    // Meshes still uploading on streaming thread aren't given - they keep their place
+    std::vector<GeometryAllocation*> allocations;
+    for (auto& mesh : meshes)
+    {
+        allocations.push_back(mesh.getGeometry());
+    }
+    for (auto& waitingMesh : waitingMeshes)
+    {
+        allocations.push_back(waitingMesh.mesh.getGeometry());
+    }
+
+    return geometryArena.compact(allocations);
+}
+
+void VulkanRenderer::setLodBias(float lodBias)
+{
+    this->lodBias = lodBias;
+}
+
+LodStats VulkanRenderer::getLodStats()
+{
+    return lodStats;
+}
+
+IndexStats VulkanRenderer::getIndexStats()
+{
+    IndexStats stats;
+    for (auto& mesh : meshes)
+    {
+        stats.meshCount++;
+        if (mesh.getIndexType() == VK_INDEX_TYPE_UINT16)
+        {
+            stats.uint16MeshCount++;
+        }
+        stats.indexBytes += static_cast<VkDeviceSize>(mesh.getIndexCount()) * Mesh::getIndexSize(mesh.getIndexType());
+        stats.uint32IndexBytes += static_cast<VkDeviceSize>(mesh.getIndexCount()) * sizeof(uint32_t);
+    }
+
+    return stats;
+}
+
+std::vector<int> VulkanRenderer::getSceneMeshes()
+{
+    return sceneMeshes;
+}
+
+TextureBatchTiming VulkanRenderer::getTextureLoadTiming()
+{
+    return textureLoadTiming;
+}
+
+TextureInfo VulkanRenderer::getTextureInfo(int texture)
+{
+    return textureInfos[texture];
+}
+
+std::vector<VkFormat> VulkanRenderer::getCompressedTextureFormats()
+{
+    return textureLoader.getCompressedFormats();
+}
+
+MemoryStats VulkanRenderer::getMemoryStats()
+{
+    return memoryAllocator.getStats();
 }
 
 VulkanRenderer::~VulkanRenderer()
@@ -264,7 +600,7 @@ void VulkanRenderer::createLogicalDevice()
     QueueFamilyIndices indices = getQueueFamilies(mainDevice.physicalDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<int> queueFamilyIndices = { indices.graphicsFamily, indices.presentationFamily };
+    std::set<int> queueFamilyIndices = { indices.graphicsFamily, indices.presentationFamily, indices.transferFamily };
 
     for (int queueFamilyIndex : queueFamilyIndices)
     {
@@ -285,11 +621,38 @@ void VulkanRenderer::createLogicalDevice()
     deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(mainDevice.physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;                             // Enable Anisotropy
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;               // Block compressed textures (desktop)
+    deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;   // Block compressed textures (mobile)
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;                     // Many draws in one indirect call
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;     // Indirect draws pick their objects by firstInstance
 
     deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
+    // Descriptor indexing (core in 1.2) - one array of all textures, indexed per object, new textures written while frames are in flight
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+    vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+    // Draw count read from buffer - indirect drawing only when device has it all, otherwise draws stay on CPU
+    VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+    supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &supportedVulkan12Features;
+    vkGetPhysicalDeviceFeatures2(mainDevice.physicalDevice, &supportedFeatures2);
+
+    vulkan12Features.drawIndirectCount = supportedVulkan12Features.drawIndirectCount;
+    indirectDrawingSupported = supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance && supportedVulkan12Features.drawIndirectCount;
+
+    deviceCreateInfo.pNext = &vulkan12Features;
+
     VkResult result = vkCreateDevice(mainDevice.physicalDevice, &deviceCreateInfo, nullptr, &mainDevice.logicalDevice);
 
     if (result != VK_SUCCESS)
@@ -299,6 +662,10 @@ void VulkanRenderer::createLogicalDevice()
 
     vkGetDeviceQueue(mainDevice.logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
     vkGetDeviceQueue(mainDevice.logicalDevice, indices.presentationFamily, 0, &presentationQueue);
+    vkGetDeviceQueue(mainDevice.logicalDevice, indices.transferFamily, 0, &transferQueue);
+
+    // All buffers and images from now on take their memory from allocator
+    memoryAllocator = MemoryAllocator(mainDevice.physicalDevice, mainDevice.logicalDevice);
 }
 
 void VulkanRenderer::createSurface()
@@ -414,11 +781,11 @@ void VulkanRenderer::createRenderPass()
     depthAttachment.format = chooseSupportedFormat(
         { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
         VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
     );
     depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;                         // Depth pyramid is built from it
     depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -485,6 +852,27 @@ void VulkanRenderer::createRenderPass()
     {
         throw std::runtime_error("Failed to create a Render Pass!");
     }
+
+    // Same pass loading what an earlier one stored - colour is left in present layout, depth pyramid build returns depth to attachment layout
+    renderPassAttachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    renderPassAttachments[0].initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    renderPassAttachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    renderPassAttachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // Colour and depth written by earlier pass have to be visible before this one loads them and draws on top
+    std::array<VkSubpassDependency, 2> loadSubpassDependencies = subpassDependencies;
+    loadSubpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    loadSubpassDependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    loadSubpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    loadSubpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    renderPassCreateInfo.pDependencies = loadSubpassDependencies.data();
+
+    result = vkCreateRenderPass(mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &loadRenderPass);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a Render Pass!");
+    }
 }
 
 void VulkanRenderer::createDescriptorSetLayout()
@@ -493,22 +881,22 @@ void VulkanRenderer::createDescriptorSetLayout()
     // ViewProjection Binding Info
     VkDescriptorSetLayoutBinding vpLayoutBinding = {};
     vpLayoutBinding.binding = 0;                                           // Binding point in shader (designated in binding number in shader)
-    vpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;    // Type of Descriptor (uniform, dynamic uniform, image sampler, etc)
+    vpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;    // Type of Descriptor (uniform, dynamic uniform, image sampler, etc)
     vpLayoutBinding.descriptorCount = 1;                                   // Number of descriptors for binding - just one data (mvp)
     vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;               // Shader stage to bind to
     vpLayoutBinding.pImmutableSamplers = nullptr;                          // For texture : Can make sampler data unchangeable (immutable) by specifying in layout
 
-    // Model Binding Info
-    /*VkDescriptorSetLayoutBinding modelLayoutBinding = {};
-    modelLayoutBinding.binding = 1;
-    modelLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    modelLayoutBinding.descriptorCount = 1;
-    modelLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    modelLayoutBinding.pImmutableSamplers = nullptr;
-    */
+    // Object Binding Info
+    // Storage buffer with ObjectData of every object in every frame - draws pick theirs by firstInstance
+    VkDescriptorSetLayoutBinding objectLayoutBinding = {};
+    objectLayoutBinding.binding = 1;
+    objectLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    objectLayoutBinding.descriptorCount = 1;
+    objectLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    objectLayoutBinding.pImmutableSamplers = nullptr;
 
     std::vector<VkDescriptorSetLayoutBinding> layoutBindings = {
-        vpLayoutBinding, //modelLayoutBinding
+        vpLayoutBinding, objectLayoutBinding
     };
 
     // Create Descriptor Set Layout with given bindings
@@ -525,15 +913,24 @@ void VulkanRenderer::createDescriptorSetLayout()
 
     // CREATE TEXTURE SAMPLER DESCRIPTOR SET LAYOUT
 
+    // Single array of every texture - not yet written elements are allowed (partially bound), as long as no object indexes them
     VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
     samplerLayoutBinding.binding = 0;
     samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.descriptorCount = 1;
+    samplerLayoutBinding.descriptorCount = MAX_TEXTURES;
     samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
     samplerLayoutBinding.pImmutableSamplers = nullptr;
 
+    // Streamed textures are written into unused elements while frames using the set are still in flight
+    VkDescriptorBindingFlags samplerBindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {};
+    bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsCreateInfo.bindingCount = 1;
+    bindingFlagsCreateInfo.pBindingFlags = &samplerBindingFlags;
+
     VkDescriptorSetLayoutCreateInfo textureLayoutCreateInfo = {};
     textureLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    textureLayoutCreateInfo.pNext = &bindingFlagsCreateInfo;
     textureLayoutCreateInfo.bindingCount = 1;
     textureLayoutCreateInfo.pBindings = &samplerLayoutBinding;
 
@@ -544,22 +941,11 @@ void VulkanRenderer::createDescriptorSetLayout()
     }
 }
 
-void VulkanRenderer::createPushConstantRange()
-{
-    // Define push constant values
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;          // Shader stage push constant will go to
-    pushConstantRange.offset = 0;                                       // Offset into given data to pass to push constant
-    pushConstantRange.size = sizeof(Model);                             // Size of data being passed
-}
-
 void VulkanRenderer::createGraphicsPipeline()
 {
-    // Read in SPIR-V code of shaders
-    auto vertexShaderCode = readFile("Shaders/vert.spv");
-    auto fragmentShaderCode = readFile("Shaders/frag.spv");
-
-    VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode);
-    VkShaderModule fragmentShaderModule = createShaderModule(fragmentShaderCode);
+    // SPIR-V code of shaders - straight from mapped asset archive when there is one
+    VkShaderModule vertexShaderModule = loadShaderModule(mainDevice.logicalDevice, &assetArchive, "Shaders/vert.spv");
+    VkShaderModule fragmentShaderModule = loadShaderModule(mainDevice.logicalDevice, &assetArchive, "Shaders/frag.spv");
 
     // Vertex Stage Creation Information
     VkPipelineShaderStageCreateInfo vertexShaderCreateInfo = {};
@@ -578,42 +964,20 @@ void VulkanRenderer::createGraphicsPipeline()
     // Shader Create Infos for Pipeline
     VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderCreateInfo, fragmentShaderCreateInfo };
 
-    // How to data for a single vertex (including info such as position, colour, texture coords, normals etc.)
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;                             // Can bind multiple streams of data, this defines which one
-    bindingDescription.stride = sizeof(Vertex);                 // Size of a single Vertex object
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // How to move between data after each vertex
-                                                                // VK_VERTEX_INPUT_RATE_VERTEX   -  Move on to the next vertex
-                                                                // VK_VERTEX_INPUT_RATE_INSTANCE -  Move to a vertex for the next instance
-
-    // How the data for an attribute is defined within a vertex
-    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
-
-    // Position Attribute
-    attributeDescriptions[0].binding = 0;                               // Which binding the data is at (should be the same as above)
-    attributeDescriptions[0].location = 0;                              // Location in shader where data will be read from
-    attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;    // Format the data will take (also helps define size of data)
-    attributeDescriptions[0].offset = offsetof(Vertex, pos);            // Where this attribute is defined in the data for a single vertex
-
-    // Colour Attribute
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    attributeDescriptions[1].offset = offsetof(Vertex, col);
-
-    // Texture Attribute
-    attributeDescriptions[2].binding = 0;
-    attributeDescriptions[2].location = 2;
-    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[2].offset = offsetof(Vertex, tex);
-
-     // VERTEX INPUT
-    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
-    vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;                                         // Description About the actual data itself (e.g. data spacing/stride informations)
-    vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-    vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();                              // Vertex attribute descriptions (data format and where to bind to/from)
-    vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    // VERTEX INPUT - one state per vertex layout, pipelines differ only in it
+    std::array<VkVertexInputBindingDescription, VERTEX_LAYOUT_COUNT> bindingDescriptions = {};
+    std::array<std::vector<VkVertexInputAttributeDescription>, VERTEX_LAYOUT_COUNT> attributeDescriptions;
+    std::array<VkPipelineVertexInputStateCreateInfo, VERTEX_LAYOUT_COUNT> vertexInputCreateInfos = {};
+    for (uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+    {
+        Mesh::getVertexInputDescription(static_cast<VertexLayout>(i), &bindingDescriptions[i], &attributeDescriptions[i]);
+
+        vertexInputCreateInfos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputCreateInfos[i].pVertexBindingDescriptions = &bindingDescriptions[i];                                // Description About the actual data itself (e.g. data spacing/stride informations)
+        vertexInputCreateInfos[i].vertexBindingDescriptionCount = 1;
+        vertexInputCreateInfos[i].pVertexAttributeDescriptions = attributeDescriptions[i].data();                      // Vertex attribute descriptions (data format and where to bind to/from)
+        vertexInputCreateInfos[i].vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions[i].size());
+    }
 
     // INPUT ASSEMBLY
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo = {};
@@ -712,8 +1076,8 @@ void VulkanRenderer::createGraphicsPipeline()
     pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
     pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;           // Per-object data comes from object storage buffer
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
 
     // Create pipeline Layout
     VkResult result = vkCreatePipelineLayout(mainDevice.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
@@ -737,7 +1101,6 @@ void VulkanRenderer::createGraphicsPipeline()
     graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     graphicsPipelineCreateInfo.stageCount = 2;                                              // Number of shader stages
     graphicsPipelineCreateInfo.pStages = shaderStages;
-    graphicsPipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
     graphicsPipelineCreateInfo.pInputAssemblyState = &inputAssemblyCreateInfo;
     graphicsPipelineCreateInfo.pViewportState = &viewportCreateInfo;
     graphicsPipelineCreateInfo.pDynamicState = nullptr;
@@ -753,8 +1116,16 @@ void VulkanRenderer::createGraphicsPipeline()
     graphicsPipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;                         // Existing pipeline to derive from - referenced original when created - does not take so much memory - good when creating a lot of pipelines
     graphicsPipelineCreateInfo.basePipelineIndex = -1;                                      // Or index of pipeline being created to derive from - creating multiple pipelines at once - index of pipelines that others would be based on
 
+    // Same pipeline for every vertex layout, only vertex input differs
+    std::array<VkGraphicsPipelineCreateInfo, VERTEX_LAYOUT_COUNT> graphicsPipelineCreateInfos;
+    for (uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+    {
+        graphicsPipelineCreateInfos[i] = graphicsPipelineCreateInfo;
+        graphicsPipelineCreateInfos[i].pVertexInputState = &vertexInputCreateInfos[i];
+    }
+
     // VkPipelineCache - Create or re-create pipeline using cache - multiple pipelines - speed up creation
-    result = vkCreateGraphicsPipelines(mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &graphicsPipeline);
+    result = vkCreateGraphicsPipelines(mainDevice.logicalDevice, VK_NULL_HANDLE, VERTEX_LAYOUT_COUNT, graphicsPipelineCreateInfos.data(), nullptr, graphicsPipelines.data());
     if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create Graphics Pipeline!");
@@ -768,17 +1139,24 @@ void VulkanRenderer::createGraphicsPipeline()
 void VulkanRenderer::createDepthBufferImage()
 {
     // Get supported format for depth buffer
+    // Sampled as well - depth pyramid is built from it
     VkFormat depthFormat = chooseSupportedFormat(
         { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
         VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
     );
 
-    depthBufferImage = createImage(swapChainExtent.width, swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &depthBufferImageMemory);
+    depthBufferImage = createImage(&memoryAllocator, mainDevice.logicalDevice, swapChainExtent.width, swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &depthBufferImageMemory);
 
     // Create Depth Buffer Image View
     depthBufferImageView = createImageView(depthBufferImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    // Occlusion culling runs in culling shader, which needs indirect drawing
+    if (indirectDrawingSupported)
+    {
+        depthPyramid = DepthPyramid(&memoryAllocator, mainDevice.logicalDevice, &assetArchive, depthBufferImage, depthBufferImageView, depthFormat, swapChainExtent);
+    }
 }
 
 void VulkanRenderer::createFramebuffers()
@@ -824,6 +1202,46 @@ void VulkanRenderer::createCommandPool()
     {
         throw std::runtime_error("Failed to create a Command Pool!");
     }
+
+    // Without separate transfer family uploads simply use graphics pool
+    if (!queueFamilyIndices.separateTransfer())
+    {
+        transferCommandPool = graphicsCommandPool;
+        return;
+    }
+
+    // Upload command buffers are short lived - recorded once and freed after they finish
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndices.transferFamily;
+
+    result = vkCreateCommandPool(mainDevice.logicalDevice, &commandPoolCreateInfo, nullptr, &transferCommandPool);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a Transfer Command Pool!");
+    }
+}
+
+void VulkanRenderer::createStagingRing()
+{
+    QueueFamilyIndices queueFamilyIndices = getQueueFamilies(mainDevice.physicalDevice);
+
+    // Copies go through transfer queue, graphics queue acquires ownership of uploaded resources (same queue when there is no transfer family)
+    stagingRing = StagingRing(&memoryAllocator, mainDevice.logicalDevice, transferQueue, transferCommandPool, graphicsQueue, graphicsCommandPool, &queueMutex);
+    mipGenerator = MipGenerator(mainDevice.physicalDevice, mainDevice.logicalDevice, &assetArchive);
+    uploadBatch = UploadBatch(&stagingRing, &mipGenerator, queueFamilyIndices.transferFamily, queueFamilyIndices.graphicsFamily);
+}
+
+void VulkanRenderer::createGeometryArena()
+{
+    // Compaction copies run on graphics queue, shared with streaming thread
+    geometryArena = GeometryArena(&memoryAllocator, mainDevice.logicalDevice, graphicsQueue, graphicsCommandPool, &queueMutex);
+}
+
+void VulkanRenderer::createAssetStreamer()
+{
+    QueueFamilyIndices queueFamilyIndices = getQueueFamilies(mainDevice.physicalDevice);
+
+    assetStreamer.start(&memoryAllocator, &geometryArena, &textureLoader, mainDevice.physicalDevice, mainDevice.logicalDevice, queueFamilyIndices, transferQueue, graphicsQueue, &queueMutex);
 }
 
 void VulkanRenderer::createCommandBuffers()
@@ -884,9 +1302,9 @@ void VulkanRenderer::createTextureSampler()
     samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;           // Mipmap interpolation mode
     samplerCreateInfo.mipLodBias = 0.0f;                                    // Level of details bias for mip level
     samplerCreateInfo.minLod = 0.0f;                                        // Minimum level of Detail to pick mip level
-    samplerCreateInfo.maxLod = 0.0f;                                        // Maximum level of Detail to pick mip level
-    samplerCreateInfo.anisotropyEnable = VK_TRUE;                           // Enable Anisotropy
-    samplerCreateInfo.maxAnisotropy = 16;                                   // Anisotropy sample level
+    samplerCreateInfo.maxLod = textureMipmaps ? VK_LOD_CLAMP_NONE : 0.0f;   // Maximum level of Detail to pick mip level (no clamp - whole chain)
+    samplerCreateInfo.anisotropyEnable = textureAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;   // Enable Anisotropy
+    samplerCreateInfo.maxAnisotropy = std::min(textureAnisotropy, maxSamplerAnisotropy); // Anisotropy sample level
 
     VkResult result = vkCreateSampler(mainDevice.logicalDevice, &samplerCreateInfo, nullptr, &textureSampler);
     if (result != VK_SUCCESS)
@@ -897,29 +1315,23 @@ void VulkanRenderer::createTextureSampler()
 
 void VulkanRenderer::createUniformBuffers()
 {
-    // View Proejction Buffer Size
-    VkDeviceSize vpbufferSize = sizeof(UboViewProjection);
+    // Single persistently mapped buffer with a region for every frame in flight
+    // All per-frame constant data (view/projection, per-pass, per-material) is bump-allocated from it
+    uniformRing = UniformRing(&memoryAllocator, mainDevice.logicalDevice, minUniformBufferOffset);
 
-    // Model Buffer Size
-    //VkDeviceSize modelBufferSize = modelUniformAlignment * MAX_OBJECTS;
+    // ObjectData of every drawn object - aligned to whole elements, so every offset / sizeof(ObjectData) is a firstInstance
+    objectRing = UniformRing(&memoryAllocator, mainDevice.logicalDevice, sizeof(ObjectData), MAX_INSTANCES * sizeof(ObjectData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
-    // One uniform buffer for each image (and by extension, command buffer)
-    vpUniformBuffer.resize(swapChainImages.size());
-    vpUniformBufferMemory.resize(swapChainImages.size());
+    // Indirect commands and counts only need 4 byte aligned offsets - one count per indirect call after its commands
+    // Storage buffer as well - culling shader writes commands and counts into it, twice as many for late phase of occlusion culling
+    indirectRing = UniformRing(&memoryAllocator, mainDevice.logicalDevice, sizeof(uint32_t),
+        2 * (MAX_INDIRECT_DRAWS * sizeof(VkDrawIndexedIndirectCommand) + indirectDraws.size() * sizeof(uint32_t)),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
-    //modelUniformBuffer.resize(swapChainImages.size());
-    //modelUniformBufferMemory.resize(swapChainImages.size());
-
-    // Create Uniform Buffer
-    for (size_t i = 0; i < swapChainImages.size(); i++)
+    if (indirectDrawingSupported)
     {
-        createBuffer(mainDevice.physicalDevice, mainDevice.logicalDevice, vpbufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &vpUniformBuffer[i], &vpUniformBufferMemory[i]);
-
-        /*createBuffer(mainDevice.physicalDevice, mainDevice.logicalDevice, modelBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &modelUniformBuffer[i], &modelUniformBufferMemory[i]);*/
+        gpuCuller = GpuCuller(&memoryAllocator, mainDevice.logicalDevice, &assetArchive, &uniformRing, &objectRing, &indirectRing, &depthPyramid);
     }
-    
 }
 
 void VulkanRenderer::createDescriptorPool()
@@ -928,23 +1340,24 @@ void VulkanRenderer::createDescriptorPool()
     // Create Descriptor Pool Size
     // ViewProjection Pool
     // Type of descriptor + how many DESCRIPTORS, not Descriptor Sets (combined makes the pool size)
+    // Dynamic uniform buffer - one descriptor for whole uniform ring, offset given when binding
     VkDescriptorPoolSize vpDescriptorPoolSize = {};
-    vpDescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    vpDescriptorPoolSize.descriptorCount = static_cast<uint32_t>(vpUniformBuffer.size());
+    vpDescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    vpDescriptorPoolSize.descriptorCount = 1;
 
-    // Dynamic Pool
-    /*VkDescriptorPoolSize modelPoolSize = {};
-    modelPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    modelPoolSize.descriptorCount = static_cast<uint32_t>(modelUniformBuffer.size());*/
+    // Object storage buffer - whole ring, frames are told apart by firstInstance
+    VkDescriptorPoolSize objectDescriptorPoolSize = {};
+    objectDescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    objectDescriptorPoolSize.descriptorCount = 1;
 
     std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { 
-        vpDescriptorPoolSize, //modelPoolSize
+        vpDescriptorPoolSize, objectDescriptorPoolSize
     };
 
     // Create Descriptor Pool
     VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
     descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptorPoolCreateInfo.maxSets = static_cast<uint32_t>(swapChainImages.size());                    // Maximum number of descriptor sets that can be created from pool
+    descriptorPoolCreateInfo.maxSets = 1;                                                                // Maximum number of descriptor sets that can be created from pool
     descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();                                    // Pool sizes to create pool with
     descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());          // Amount of pool sizes being passed
 
@@ -958,11 +1371,11 @@ void VulkanRenderer::createDescriptorPool()
     // Texture Sampler Pool
     VkDescriptorPoolSize samplerPoolSize = {};
     samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerPoolSize.descriptorCount = MAX_OBJECTS;                                  // One Texture per Object
+    samplerPoolSize.descriptorCount = MAX_TEXTURES;                                 // One descriptor per texture (startup and streamed)
 
     VkDescriptorPoolCreateInfo samplerPoolCreateInfo = {};
     samplerPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    samplerPoolCreateInfo.maxSets = MAX_OBJECTS;                                    // One Set for each object - Texture atlas : One texture combined of multiple textures, smaller amount of sets, or array
+    samplerPoolCreateInfo.maxSets = 1;                                              // One Set with array of all textures
     samplerPoolCreateInfo.poolSizeCount = 1;
     samplerPoolCreateInfo.pPoolSizes = &samplerPoolSize;
 
@@ -975,96 +1388,128 @@ void VulkanRenderer::createDescriptorPool()
 
 void VulkanRenderer::createDescriptorSets()
 {
-    // Resize Descriptor Set list so one for every buffer
-    descriptorSets.resize(swapChainImages.size());
-
-    // Create list of copies of descriptionSetLayout
-    // Every Descriptor Set uses different layout - first descriptor Set - first Layout etc - one to one relationship
-    std::vector<VkDescriptorSetLayout> setLayouts(swapChainImages.size(), descriptorSetLayout);
-
     // Descriptor Set Allocation Info
+    // Only one set needed - every frame points at the same uniform ring, just with different dynamic offset
     VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
     descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     descriptorSetAllocateInfo.descriptorPool = descriptorPool;                                          // Pool to allocate descriptor sets from
-    descriptorSetAllocateInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImages.size());       // Number of sets to allocate
-    descriptorSetAllocateInfo.pSetLayouts = setLayouts.data();                                          // Layouts to use to allocate sets
+    descriptorSetAllocateInfo.descriptorSetCount = 1;                                                   // Number of sets to allocate
+    descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;                                       // Layouts to use to allocate sets
 
     // Allocate Descriptor Sets
-    VkResult result = vkAllocateDescriptorSets(mainDevice.logicalDevice, &descriptorSetAllocateInfo, descriptorSets.data());
+    VkResult result = vkAllocateDescriptorSets(mainDevice.logicalDevice, &descriptorSetAllocateInfo, &descriptorSet);
     if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to allocate Descriptor Sets!");
     }
 
-    // Update all of descriptor sets buffer bindings
-    for (size_t i = 0; i < swapChainImages.size(); i++)
-    {
-        // ViewProejction Descriptor
-        // Buffer Info and Data Offset Info
-        VkDescriptorBufferInfo vpBufferInfo = {};
-        vpBufferInfo.buffer = vpUniformBuffer[i];                           // Buffer to get data from
-        vpBufferInfo.offset = 0;                                            // Position of start of data
-        vpBufferInfo.range = sizeof(UboViewProjection);                     // Size of data
-
-        // Information about connection between binding and buffer
-        VkWriteDescriptorSet vpSetWrite = {};
-        vpSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        vpSetWrite.dstSet = descriptorSets[i];                              // Descriptor Set to update
-        vpSetWrite.dstBinding = 0;                                          // Binding to update (mateches with binding on layout/shader)
-        vpSetWrite.dstArrayElement = 0;                                     // Index in array to update
-        vpSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;      // Type of descriptor
-        vpSetWrite.descriptorCount = 1;                                     // Amount to update
-        vpSetWrite.pBufferInfo = &vpBufferInfo;                             // Information about buffer data to bind
-
-        // Model Descriptor
-        // Model Buffer Binding Info
-        /*VkDescriptorBufferInfo modelBufferInfo = {};
-        modelBufferInfo.buffer = modelUniformBuffer[i];
-        modelBufferInfo.offset = 0;
-        modelBufferInfo.range = modelUniformAlignment;
-
-        VkWriteDescriptorSet modelSetWrite = {};
-        modelSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        modelSetWrite.dstSet = descriptorSets[i];
-        modelSetWrite.dstBinding = 1;
-        modelSetWrite.dstArrayElement = 0;
-        modelSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        modelSetWrite.descriptorCount = 1;
-        modelSetWrite.pBufferInfo = &modelBufferInfo;*/
-
-        std::vector<VkWriteDescriptorSet> setWrites = { 
-            vpSetWrite, //modelSetWrite
-        };
+    // ViewProejction Descriptor
+    // Buffer Info and Data Offset Info
+    VkDescriptorBufferInfo vpBufferInfo = {};
+    vpBufferInfo.buffer = uniformRing.getBuffer();                      // Buffer to get data from
+    vpBufferInfo.offset = 0;                                            // Position of start of data (dynamic offset is added on top of it)
+    vpBufferInfo.range = sizeof(UboViewProjection);                     // Size of data
+
+    // Information about connection between binding and buffer
+    VkWriteDescriptorSet vpSetWrite = {};
+    vpSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    vpSetWrite.dstSet = descriptorSet;                                      // Descriptor Set to update
+    vpSetWrite.dstBinding = 0;                                              // Binding to update (mateches with binding on layout/shader)
+    vpSetWrite.dstArrayElement = 0;                                         // Index in array to update
+    vpSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;  // Type of descriptor
+    vpSetWrite.descriptorCount = 1;                                         // Amount to update
+    vpSetWrite.pBufferInfo = &vpBufferInfo;                                 // Information about buffer data to bind
+
+    // Object Descriptor
+    VkDescriptorBufferInfo objectBufferInfo = {};
+    objectBufferInfo.buffer = objectRing.getBuffer();
+    objectBufferInfo.offset = 0;
+    objectBufferInfo.range = VK_WHOLE_SIZE;                             // Regions of all frames
+
+    VkWriteDescriptorSet objectSetWrite = {};
+    objectSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    objectSetWrite.dstSet = descriptorSet;
+    objectSetWrite.dstBinding = 1;
+    objectSetWrite.dstArrayElement = 0;
+    objectSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    objectSetWrite.descriptorCount = 1;
+    objectSetWrite.pBufferInfo = &objectBufferInfo;
+
+    std::vector<VkWriteDescriptorSet> setWrites = { 
+        vpSetWrite, objectSetWrite
+    };
+
+    // Update Decriptor Sets with new buffer/binding info
+    vkUpdateDescriptorSets(mainDevice.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+
+    // Texture array - elements are written as textures are created
+    VkDescriptorSetAllocateInfo samplerSetAllocateInfo = {};
+    samplerSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    samplerSetAllocateInfo.descriptorPool = samplerDescriptorPool;
+    samplerSetAllocateInfo.descriptorSetCount = 1;
+    samplerSetAllocateInfo.pSetLayouts = &samplerSetLayout;
 
-        // Update Decriptor Sets with new buffer/binding info
-        vkUpdateDescriptorSets(mainDevice.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+    result = vkAllocateDescriptorSets(mainDevice.logicalDevice, &samplerSetAllocateInfo, &samplerDescriptorSet);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate Texture Descriptor Set!");
     }
 }
 
-void VulkanRenderer::updateUniformBuffers(uint32_t imageIndex)
+void VulkanRenderer::updateUniformBuffers()
 {
-    // Update all uniform buffer memory with current ModelViewProjection matrix data
-    void* data;
-    vkMapMemory(mainDevice.logicalDevice, vpUniformBufferMemory[imageIndex], 0, sizeof(UboViewProjection), 0, &data);
-    memcpy(data, &uboViewProjection, sizeof(UboViewProjection));
-    vkUnmapMemory(mainDevice.logicalDevice, vpUniformBufferMemory[imageIndex]);
+    // Copy current ViewProjection matrix data to current frame's region of uniform ring
+    vpUniformOffset = uniformRing.push(uboViewProjection);
+}
 
-    // Copy model data
-    /*
-    for (size_t i = 0; i < meshes.size(); i++)
+void VulkanRenderer::updateStreaming()
+{
+    std::vector<StreamedTexture> streamedTextures;
+    std::vector<StreamedMesh> streamedMeshes;
+    assetStreamer.update(&streamedTextures, &streamedMeshes);
+
+    // Textures are already shader readable - they only need view and descriptor set
+    for (auto& texture : streamedTextures)
     {
-        Model* model = (Model *) ( (uint64_t) modelTransferSpace + (i * modelUniformAlignment));
-        *model = meshes[i].getModel();
+        textureImages.push_back(texture.image);
+        textureImagesMemory.push_back(texture.memory);
+        textureInfos.push_back(texture.info);
+
+        VkImageView imageView = createImageView(texture.image, texture.info.format, VK_IMAGE_ASPECT_COLOR_BIT);
+        textureImageView.push_back(imageView);
+
+        residentAssets[texture.handle] = createTextureDescriptor(imageView);
     }
 
-    vkMapMemory(mainDevice.logicalDevice, modelUniformBufferMemory[imageIndex], 0, modelUniformAlignment * meshes.size(), 0, &data);
-    memcpy(data, modelTransferSpace, modelUniformAlignment * meshes.size());
-    vkUnmapMemory(mainDevice.logicalDevice, modelUniformBufferMemory[imageIndex]);
-    */
+    waitingMeshes.insert(waitingMeshes.end(), streamedMeshes.begin(), streamedMeshes.end());
+
+    // Mesh joins scene once its texture is resident - if texture never will be, first texture is used instead
+    for (size_t i = 0; i < waitingMeshes.size(); )
+    {
+        int textureIndex = getAssetIndex(waitingMeshes[i].texture);
+        if (textureIndex < 0)
+        {
+            AssetState textureState = assetStreamer.getState(waitingMeshes[i].texture);
+            if (textureState != AssetState::Failed && textureState != AssetState::Cancelled)
+            {
+                i++;
+                continue;
+            }
+            textureIndex = 0;
+        }
+
+        waitingMeshes[i].mesh.setTextureIndex(textureIndex);
+        meshes.push_back(waitingMeshes[i].mesh);
+        residentAssets[waitingMeshes[i].handle] = static_cast<int>(meshes.size()) - 1;
+
+        waitingMeshes.erase(waitingMeshes.begin() + i);
+    }
 }
 
 void VulkanRenderer::recordCommands(uint32_t currentImage)
 {
+    auto recordStart = std::chrono::high_resolution_clock::now();
+
     // Information about how to begin each command buffer
     VkCommandBufferBeginInfo bufferBeginInfo = {};
     bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1094,50 +1539,147 @@ void VulkanRenderer::recordCommands(uint32_t currentImage)
         throw std::runtime_error("Failed to start recording a Command Buffer!");
     }
 
-    // Begin Render Pass
-    // Cmd - commands to record
-    // renderPass.loadOp called
-    vkCmdBeginRenderPass(commandBuffers[currentImage], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // Pipeline is picked by vertex layout of mesh, index buffer is bound with index type of mesh - both only when they change
+    boundPipeline = VK_NULL_HANDLE;
+    boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+    // Geometry of every mesh is in arena buffers - vertex buffer is bound once
+    VkBuffer vertexBuffers[] = { geometryArena.getVertexBuffer() };                             // Buffers to bind
+    VkDeviceSize offsets[] = { 0 };                                                             // Offsets into buffers being bound
+    vkCmdBindVertexBuffers(commandBuffers[currentImage], 0, 1, vertexBuffers, offsets);         // Command to bind Vertex Buffer before drawing with them
+
+    // Bind Descriptor Sets once - per-object data and textures are indexed in shaders, pipelines share one layout
+    // Dynamic offset selects this frame's ViewProjection data inside uniform ring
+    std::array<VkDescriptorSet, 2> descriptorSetGroup = { descriptorSet, samplerDescriptorSet };
+    vkCmdBindDescriptorSets(commandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorSetGroup.size()), descriptorSetGroup.data(), 1, &vpUniformOffset);
+
+    // Detail level of each mesh comes from its error projected to screen
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(uboViewProjection.view)[3]);
+    float pixelsPerUnit = swapChainExtent.height * 0.5f * std::abs(uboViewProjection.projection[1][1]);
+    lodStats = LodStats();
+    drawStats = DrawStats();
+    drawStats.bindCalls = 2;                    // Vertex buffer and descriptor sets
+
+    // Indirect - draws are only collected here, pipelines and index buffer are bound once per indirect call afterwards
+    bool indirect = indirectDrawing && indirectDrawingSupported;
+    for (auto& draws : indirectDraws)
+    {
+        draws.clear();
+    }
 
-    // Bind Pipeline to be used in render pass (to draw to at the moment)
-    vkCmdBindPipeline(commandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    // Direct draws are recorded straight into render pass - indirect ones may need a culling dispatch first, which can't be inside of it
+    if (!indirect)
+    {
+        // Begin Render Pass
+        // Cmd - commands to record
+        // renderPass.loadOp called
+        vkCmdBeginRenderPass(commandBuffers[currentImage], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    // Draws not culled on GPU are culled here against frustum - instanced meshes per instance in queueInstances
+    bool cpuCulled = cpuCulling && !(indirect && gpuCulling);
+    glm::mat4 viewProjection = uboViewProjection.projection * uboViewProjection.view;
+    glm::vec4 frustumPlanes[6];
+    FrustumCuller::getFrustumPlanes(viewProjection, frustumPlanes);
+    cullStats = CullStats();
+
+    // Draws inside frustum are then tested against occluders, rasterized before any of them
+    bool cpuOccluded = cpuCulled && cpuOcclusionCulling && !occluders.empty();
+    if (cpuOccluded)
+    {
+        rasterizeOccluders(viewProjection);
+    }
 
-        for (size_t j = 0; j < meshes.size(); j++)
+    renderQueue.clear();
+    visibleMeshes.clear();
+    cullSpheres.clear();
+    cullSphereMeshes.clear();
+    for (uint32_t j = 0; j < meshes.size(); j++)
+    {
+        if (!cpuCulled || instanceBatches.count(static_cast<int>(j)) > 0)
         {
-            VkBuffer vertexBuffers[] = { meshes[j].getVertexBuffer() };                             // Buffers to bind
-            VkDeviceSize offsets[] = { 0 };                                                         // Offsets into buffers being bound
+            visibleMeshes.push_back(j);
+            continue;
+        }
 
-            vkCmdBindVertexBuffers(commandBuffers[currentImage], 0, 1, vertexBuffers, offsets);     // Command to bind Vertex Buffer before drawing with them
+        cullSpheres.add(meshes[j].getBoundingSphere(meshes[j].getModel().model));
+        cullSphereMeshes.push_back(j);
+    }
 
-            // Bind Mesh Index Buffer with 0 offset and using uint32 type
-            vkCmdBindIndexBuffer(commandBuffers[currentImage], meshes[j].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    if (cpuCulled)
+    {
+        frustumCuller.cull(cullSpheres, frustumPlanes, &visibleSpheres);
 
-            // Dynamic Offset Amount
-            // uint32_t dynamicOffset = static_cast<uint32_t>(modelUniformAlignment) * j;
+        // Occluders themselves are always drawn
+        uint32_t occluded = 0;
+        glm::vec3 boundsMin, boundsMax;
+        for (uint32_t sphere : visibleSpheres)
+        {
+            uint32_t j = cullSphereMeshes[sphere];
+            if (cpuOccluded && occluders.count(static_cast<int>(j)) == 0)
+            {
+                meshes[j].getBounds(&boundsMin, &boundsMax);
+                if (!occlusionRasterizer.isBoxVisible(boundsMin, boundsMax, viewProjection * meshes[j].getModel().model))
+                {
+                    occluded++;
+                    continue;
+                }
+            }
+            visibleMeshes.push_back(j);
+        }
+        cullStats.totalObjects += static_cast<uint32_t>(cullSpheres.size());
+        cullStats.visibleObjects += static_cast<uint32_t>(visibleSpheres.size()) - occluded;
+        cullStats.occludedObjects += occluded;
+    }
 
-            // "Push" constants to given shader stage directly (no buffer)
-            Model model = meshes[j].getModel();
-            vkCmdPushConstants(
-                commandBuffers[currentImage],
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT,                                         // Stage to push constants to
-                0,                                                                  // Offset of push constants to update
-                sizeof(Model),                                                      // Size of data being pushed
-                &model);                                                            // Actual data being pushed (can be array)
+    for (uint32_t j : visibleMeshes)
+    {
+        auto batch = instanceBatches.find(static_cast<int>(j));
+        if (batch != instanceBatches.end())
+        {
+            queueInstances(static_cast<int>(j), batch->second, cameraPosition, pixelsPerUnit, cpuCulled ? frustumPlanes : nullptr, cpuOccluded);
+            continue;
+        }
 
-            std::array<VkDescriptorSet, 2> descriptorSetGroup = { descriptorSets[currentImage], samplerDescriptorSets[meshes[j].getTextureIndex()] };
+        // Mesh without instances is a single object with its own model
+        uint32_t objectOffset;
+        ObjectData* object = static_cast<ObjectData*>(objectRing.allocate(sizeof(ObjectData), &objectOffset));
+        writeObject(object, meshes[j], meshes[j].getModel().model, meshes[j].getTextureIndex());
 
-            // Bind Descriptor Sets
-            // Graphics Pipeline
-            vkCmdBindDescriptorSets(commandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorSetGroup.size()), descriptorSetGroup.data(), 0, nullptr);
+        uint32_t lod = meshes[j].selectLod(cameraPosition, pixelsPerUnit, LOD_MAX_PIXEL_ERROR * lodBias);
+        float depth = glm::length(glm::vec3(meshes[j].getBoundingSphere(meshes[j].getModel().model)) - cameraPosition);
+        queueMeshDraw(static_cast<int>(j), lod, static_cast<uint32_t>(objectOffset / sizeof(ObjectData)), 1, depth);
+    }
 
-            // Execute Pipeline
-            // Vertex Count - Number of vertex to draw
-            // Instance Count - good for drawing object multiple times - calling shaders multiple times - offsets in shaders
-            //vkCmdDraw(commandBuffers[i], static_cast<uint32_t>(firstMesh.getVertexCount()), 1, 0, 0);
+    // Sorted by state, then front to back - direct draws are recorded now, indirect ones go to their lists / culling candidates
+    recordQueuedDraws(commandBuffers[currentImage]);
+
+    if (indirect && gpuCulling)
+    {
+        std::array<CullDrawList, CULL_DRAW_LISTS> drawLists = gpuCuller.record(commandBuffers[currentImage], uboViewProjection.projection * uboViewProjection.view,
+            occlusionCulling);
+
+        vkCmdBeginRenderPass(commandBuffers[currentImage], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        recordCulledDraws(commandBuffers[currentImage], drawLists);
 
-            vkCmdDrawIndexed(commandBuffers[currentImage], meshes[j].getIndexCount(), 1, 0, 0, 0);
+        // Depth of objects visible so far becomes pyramid that occluded ones are tested against again - those visible now are drawn on top
+        if (occlusionCulling)
+        {
+            vkCmdEndRenderPass(commandBuffers[currentImage]);
+            depthPyramid.build(commandBuffers[currentImage]);
+            drawLists = gpuCuller.recordLate(commandBuffers[currentImage]);
+
+            VkRenderPassBeginInfo loadRenderPassBeginInfo = renderPassBeginInfo;
+            loadRenderPassBeginInfo.renderPass = loadRenderPass;
+            vkCmdBeginRenderPass(commandBuffers[currentImage], &loadRenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            recordCulledDraws(commandBuffers[currentImage], drawLists);
         }
+    }
+    else if (indirect)
+    {
+        vkCmdBeginRenderPass(commandBuffers[currentImage], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        recordIndirectDraws(commandBuffers[currentImage]);
+    }
 
     // End Render Pass
     // renderPass.storeOp called
@@ -1149,6 +1691,316 @@ void VulkanRenderer::recordCommands(uint32_t currentImage)
     {
         throw std::runtime_error("Failed to end recording a Command Buffer");
     }
+
+    drawStats.recordMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+}
+
+void VulkanRenderer::queueInstances(int meshId, const InstanceBatch& batch, const glm::vec3& cameraPosition, float pixelsPerUnit,
+    const glm::vec4* frustumPlanes, bool occluded)
+{
+    Mesh& mesh = meshes[meshId];
+
+    // Only instances inside frustum go on - visibleInstances holds indices of batch instances
+    visibleInstances.resize(batch.models.size());
+    if (frustumPlanes)
+    {
+        cullSpheres.clear();
+        for (const glm::mat4& model : batch.models)
+        {
+            cullSpheres.add(mesh.getBoundingSphere(model));
+        }
+        frustumCuller.cull(cullSpheres, frustumPlanes, &visibleInstances);
+        cullStats.totalObjects += static_cast<uint32_t>(batch.models.size());
+
+        // Instances behind occluders are dropped too - every index is written, count only moves past visible ones
+        if (occluded && occluders.count(meshId) == 0)
+        {
+            glm::vec3 boundsMin, boundsMax;
+            mesh.getBounds(&boundsMin, &boundsMax);
+            glm::mat4 viewProjection = uboViewProjection.projection * uboViewProjection.view;
+
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < visibleInstances.size(); i++)
+            {
+                uint32_t instance = visibleInstances[i];
+                visibleInstances[count] = instance;
+                count += occlusionRasterizer.isBoxVisible(boundsMin, boundsMax, viewProjection * batch.models[instance]) ? 1 : 0;
+            }
+            cullStats.occludedObjects += static_cast<uint32_t>(visibleInstances.size()) - count;
+            visibleInstances.resize(count);
+        }
+        cullStats.visibleObjects += static_cast<uint32_t>(visibleInstances.size());
+    }
+    else
+    {
+        for (uint32_t i = 0; i < visibleInstances.size(); i++)
+        {
+            visibleInstances[i] = i;
+        }
+    }
+
+    uint32_t instanceCount = static_cast<uint32_t>(visibleInstances.size());
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    // Textures are indexed per object, so only detail level splits instances into draws
+    uint32_t lodCount = mesh.getLodCount();
+
+    instanceKeys.resize(instanceCount);
+    instanceGroupStarts.assign(lodCount + 1, 0);
+    instanceGroupDepths.assign(lodCount, FLT_MAX);
+    for (uint32_t i = 0; i < instanceCount; i++)
+    {
+        const glm::mat4& model = batch.models[visibleInstances[i]];
+        instanceKeys[i] = mesh.selectLod(model, cameraPosition, pixelsPerUnit, LOD_MAX_PIXEL_ERROR * lodBias);
+        instanceGroupStarts[instanceKeys[i] + 1]++;
+        instanceGroupDepths[instanceKeys[i]] = std::min(instanceGroupDepths[instanceKeys[i]], glm::length(glm::vec3(model[3]) - cameraPosition));
+    }
+
+    for (uint32_t lod = 0; lod < lodCount; lod++)
+    {
+        instanceGroupStarts[lod + 1] += instanceGroupStarts[lod];
+    }
+
+    // Objects are written grouped straight into this frame's object ring, so every group is one contiguous range
+    uint32_t objectOffset;
+    ObjectData* objects = static_cast<ObjectData*>(objectRing.allocate(instanceCount * sizeof(ObjectData), &objectOffset));
+    uint32_t firstInstance = static_cast<uint32_t>(objectOffset / sizeof(ObjectData));
+
+    instanceGroupHeads.assign(instanceGroupStarts.begin(), instanceGroupStarts.end() - 1);
+    for (uint32_t i = 0; i < instanceCount; i++)
+    {
+        uint32_t instance = visibleInstances[i];
+        int texture = batch.textureIndices.empty() ? mesh.getTextureIndex() : batch.textureIndices[instance];
+        writeObject(&objects[instanceGroupHeads[instanceKeys[i]]++], mesh, batch.models[instance], texture);
+    }
+
+    for (uint32_t lod = 0; lod < lodCount; lod++)
+    {
+        uint32_t groupSize = instanceGroupStarts[lod + 1] - instanceGroupStarts[lod];
+        if (groupSize > 0)
+        {
+            queueMeshDraw(meshId, lod, firstInstance + instanceGroupStarts[lod], groupSize, instanceGroupDepths[lod]);
+        }
+    }
+}
+
+void VulkanRenderer::rasterizeOccluders(const glm::mat4& viewProjection)
+{
+    occlusionRasterizer.clear();
+    for (auto& occluder : occluders)
+    {
+        // Mesh of occluder may still be streaming in
+        if (occluder.first >= static_cast<int>(meshes.size()))
+        {
+            continue;
+        }
+
+        auto batch = instanceBatches.find(occluder.first);
+        if (batch != instanceBatches.end())
+        {
+            for (const glm::mat4& model : batch->second.models)
+            {
+                occlusionRasterizer.addOccluder(occluder.second.positions, occluder.second.indices, viewProjection * model);
+            }
+        }
+        else
+        {
+            occlusionRasterizer.addOccluder(occluder.second.positions, occluder.second.indices, viewProjection * meshes[occluder.first].getModel().model);
+        }
+    }
+    occlusionRasterizer.rasterize();
+}
+
+void VulkanRenderer::queueMeshDraw(int meshId, uint32_t lod, uint32_t firstInstance, uint32_t instanceCount, float depth)
+{
+    Mesh& mesh = meshes[meshId];
+
+    // Textures are indexed in shader, so they need no bind - draws of one texture still follow each other for texture cache
+    uint32_t indexTypeSlot = mesh.getIndexType() == VK_INDEX_TYPE_UINT16 ? 0 : 1;
+    uint64_t key = RenderQueue::makeKey(DrawPass::Opaque, static_cast<uint32_t>(mesh.getVertexLayout()), indexTypeSlot,
+        static_cast<uint32_t>(mesh.getTextureIndex()), depth);
+
+    QueuedDraw draw = {};
+    draw.meshId = static_cast<uint32_t>(meshId);
+    draw.lod = lod;
+    draw.firstInstance = firstInstance;
+    draw.instanceCount = instanceCount;
+    renderQueue.add(key, draw);
+
+    const MeshLod& meshLod = mesh.getLod(lod);
+    lodStats.drawCount++;
+    lodStats.instanceCount += instanceCount;
+    lodStats.triangles += static_cast<uint64_t>(meshLod.indexCount / 3) * instanceCount;
+    lodStats.fullTriangles += static_cast<uint64_t>(mesh.getLod(0).indexCount / 3) * instanceCount;
+    lodStats.lodInstances[lod] += instanceCount;
+}
+
+void VulkanRenderer::recordQueuedDraws(VkCommandBuffer commandBuffer)
+{
+    renderQueue.sort();
+
+    bool indirect = indirectDrawing && indirectDrawingSupported;
+    for (size_t i = 0; i < renderQueue.size(); i++)
+    {
+        // Instance Count - mesh is drawn for every object in object ring from firstInstance on (gl_InstanceIndex includes firstInstance)
+        const QueuedDraw& queued = renderQueue.getDraw(i);
+        Mesh& mesh = meshes[queued.meshId];
+        const MeshLod& meshLod = mesh.getLod(queued.lod);
+
+        if (indirect)
+        {
+            // Same command, but in list of its pipeline / index type
+            VkDrawIndexedIndirectCommand draw = {};
+            draw.indexCount = meshLod.indexCount;
+            draw.instanceCount = queued.instanceCount;
+            draw.firstIndex = mesh.getFirstIndex() + meshLod.firstIndex;
+            draw.vertexOffset = mesh.getVertexOffset();
+            draw.firstInstance = queued.firstInstance;
+
+            uint32_t indexTypeSlot = mesh.getIndexType() == VK_INDEX_TYPE_UINT16 ? 0 : 1;
+            uint32_t list = static_cast<uint32_t>(mesh.getVertexLayout()) * 2 + indexTypeSlot;
+            if (gpuCulling)
+            {
+                // Culled per object - every instance becomes a candidate with its own command
+                CullObject object = {};
+                object.sphere = mesh.getStoredBoundingSphere();
+                object.indexCount = draw.indexCount;
+                object.firstIndex = draw.firstIndex;
+                object.vertexOffset = draw.vertexOffset;
+                for (uint32_t j = 0; j < queued.instanceCount; j++)
+                {
+                    object.objectIndex = queued.firstInstance + j;
+                    gpuCuller.add(list, object);
+                }
+            }
+            else
+            {
+                indirectDraws[list].push_back(draw);
+            }
+        }
+        else
+        {
+            // Execute Pipeline
+            bindDrawState(commandBuffer, mesh.getVertexLayout(), mesh.getIndexType());
+            vkCmdDrawIndexed(commandBuffer, meshLod.indexCount, queued.instanceCount, mesh.getFirstIndex() + meshLod.firstIndex, mesh.getVertexOffset(),
+                queued.firstInstance);
+            drawStats.drawCalls++;
+        }
+    }
+}
+
+void VulkanRenderer::bindDrawState(VkCommandBuffer commandBuffer, VertexLayout vertexLayout, VkIndexType indexType)
+{
+    // Bind Pipeline to be used in render pass (to draw to at the moment)
+    VkPipeline pipeline = graphicsPipelines[static_cast<uint32_t>(vertexLayout)];
+    if (pipeline != boundPipeline)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        boundPipeline = pipeline;
+        drawStats.bindCalls++;
+    }
+    else
+    {
+        drawStats.avoidedBinds++;
+    }
+
+    // Bind arena Index Buffer with 0 offset and index type of mesh (16 bit for small meshes)
+    if (indexType != boundIndexType)
+    {
+        vkCmdBindIndexBuffer(commandBuffer, geometryArena.getIndexBuffer(), 0, indexType);
+        boundIndexType = indexType;
+        drawStats.bindCalls++;
+    }
+    else
+    {
+        drawStats.avoidedBinds++;
+    }
+}
+
+void VulkanRenderer::recordIndirectDraws(VkCommandBuffer commandBuffer)
+{
+    for (uint32_t i = 0; i < indirectDraws.size(); i++)
+    {
+        const std::vector<VkDrawIndexedIndirectCommand>& draws = indirectDraws[i];
+        if (draws.empty())
+        {
+            continue;
+        }
+
+        if (drawStats.indirectDraws + draws.size() > MAX_INDIRECT_DRAWS)
+        {
+            throw std::runtime_error("Too many indirect draws for indirect ring!");
+        }
+
+        // Commands of whole list in one copy, count right after them
+        uint32_t drawsOffset;
+        void* drawsData = indirectRing.allocate(draws.size() * sizeof(VkDrawIndexedIndirectCommand), &drawsOffset);
+        memcpy(drawsData, draws.data(), draws.size() * sizeof(VkDrawIndexedIndirectCommand));
+
+        uint32_t drawCount = static_cast<uint32_t>(draws.size());
+        uint32_t countOffset = indirectRing.push(drawCount);
+
+        VertexLayout vertexLayout = static_cast<VertexLayout>(i / 2);
+        VkIndexType indexType = i % 2 == 0 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        bindDrawState(commandBuffer, vertexLayout, indexType);
+
+        // Count is read by device - later on written by device as well (e.g. culling), then maxDrawCount is what caps it
+        vkCmdDrawIndexedIndirectCount(commandBuffer, indirectRing.getBuffer(), drawsOffset, indirectRing.getBuffer(), countOffset,
+            drawCount, sizeof(VkDrawIndexedIndirectCommand));
+
+        drawStats.drawCalls++;
+        drawStats.indirectDraws += drawCount;
+    }
+}
+
+void VulkanRenderer::recordCulledDraws(VkCommandBuffer commandBuffer, const std::array<CullDrawList, CULL_DRAW_LISTS>& drawLists)
+{
+    for (uint32_t i = 0; i < drawLists.size(); i++)
+    {
+        if (drawLists[i].maxDrawCount == 0)
+        {
+            continue;
+        }
+
+        VertexLayout vertexLayout = static_cast<VertexLayout>(i / 2);
+        VkIndexType indexType = i % 2 == 0 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        bindDrawState(commandBuffer, vertexLayout, indexType);
+
+        // Count of visible objects is only known to device - every candidate may be drawn
+        vkCmdDrawIndexedIndirectCount(commandBuffer, indirectRing.getBuffer(), drawLists[i].commandOffset, indirectRing.getBuffer(), drawLists[i].countOffset,
+            drawLists[i].maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+
+        drawStats.drawCalls++;
+        drawStats.indirectDraws += drawLists[i].maxDrawCount;
+    }
+}
+
+void VulkanRenderer::writeObject(ObjectData* object, Mesh& mesh, const glm::mat4& model, int textureIndex)
+{
+    ObjectData data = {};
+
+    // Quantized positions are brought back to mesh space by the same matrix - float vertices need no multiply
+    data.model = mesh.getVertexLayout() == VertexLayout::Standard ? model : model * mesh.getDequantization();
+    data.colour = mesh.getColour();
+
+    // Texture that doesn't exist (yet) falls back to mesh's own
+    if (textureIndex < 0 || textureIndex >= static_cast<int>(textureImageView.size()))
+    {
+        textureIndex = mesh.getTextureIndex();
+    }
+
+    // Mesh's own is within descriptor array, but its texture may not have been created - first texture then
+    if (textureIndex >= static_cast<int>(textureImageView.size()))
+    {
+        textureIndex = 0;
+    }
+    data.textureIndex = static_cast<uint32_t>(textureIndex);
+
+    // Whole element in one copy - ring memory is host coherent, possibly write combined
+    *object = data;
 }
 
 void VulkanRenderer::getPhysicalDevice()
@@ -1178,7 +2030,10 @@ void VulkanRenderer::getPhysicalDevice()
     // Get properties of physical device
     VkPhysicalDeviceProperties deviceProperties;
     vkGetPhysicalDeviceProperties(mainDevice.physicalDevice, &deviceProperties);
-    //minUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;
+    minUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;
+    maxSamplerAnisotropy = deviceProperties.limits.maxSamplerAnisotropy;
+
+    textureLoader = TextureLoader(mainDevice.physicalDevice, &assetArchive);
 }
 
 void VulkanRenderer::allocateDynamicBufferTransferSpace()
@@ -1266,6 +2121,16 @@ bool VulkanRenderer::checkDeviceSuitable(VkPhysicalDevice device)
     VkPhysicalDeviceFeatures deviceFeatures;
     vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
 
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &vulkan12Features;
+    vkGetPhysicalDeviceFeatures2(device, &features2);
+
+    bool descriptorIndexing = vulkan12Features.shaderSampledImageArrayNonUniformIndexing && vulkan12Features.descriptorBindingPartiallyBound &&
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending;
+
     QueueFamilyIndices indices = getQueueFamilies(device);
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
@@ -1277,7 +2142,7 @@ bool VulkanRenderer::checkDeviceSuitable(VkPhysicalDevice device)
         swapChainValid = !swapChainDetails.presentationModes.empty() && swapChainDetails.surfaceFormats.empty();
     }
 
-    return indices.isValid() && extensionsSupported && swapChainValid && deviceFeatures.samplerAnisotropy;
+    return indices.isValid() && extensionsSupported && swapChainValid && deviceFeatures.samplerAnisotropy && descriptorIndexing;
 }
 
 QueueFamilyIndices VulkanRenderer::getQueueFamilies(VkPhysicalDevice physicalDevice)
@@ -1316,6 +2181,30 @@ QueueFamilyIndices VulkanRenderer::getQueueFamilies(VkPhysicalDevice physicalDev
         i++;
     }
 
+    // Look for family only able to transfer (DMA engine) - uploads on it run alongside rendering
+    // Next best is family with transfer but no graphics (async compute), otherwise uploads stay on graphics family
+    int transferOnlyFamily = -1;
+    int noGraphicsFamily = -1;
+    for (uint32_t j = 0; j < queueFamilyCount; j++)
+    {
+        VkQueueFlags flags = queueFamilyList[j].queueFlags;
+        if (queueFamilyList[j].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            continue;
+        }
+
+        if (!(flags & VK_QUEUE_COMPUTE_BIT) && transferOnlyFamily < 0)
+        {
+            transferOnlyFamily = j;
+        }
+        else if (noGraphicsFamily < 0)
+        {
+            noGraphicsFamily = j;
+        }
+    }
+
+    indices.transferFamily = transferOnlyFamily >= 0 ? transferOnlyFamily : (noGraphicsFamily >= 0 ? noGraphicsFamily : indices.graphicsFamily);
+
     return indices;
 }
 
@@ -1428,55 +2317,6 @@ VkFormat VulkanRenderer::chooseSupportedFormat(const std::vector<VkFormat>& form
     throw std::runtime_error("Failed to find a matching format!");
 }
 
-VkImage VulkanRenderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags useFlags, VkMemoryPropertyFlags propertyFlags, VkDeviceMemory* imageMemory)
-{
-    // Create Image
-
-    VkImageCreateInfo imageCreateInfo = {};
-    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;                   // 3D - Volumetric Data
-    imageCreateInfo.extent.width = width;                           // Width of image extent
-    imageCreateInfo.extent.height = height;                         // Height of image extent
-    imageCreateInfo.extent.depth = 1;                               // Depth of image (just 1, no 3D aspect)
-    imageCreateInfo.mipLevels = 1;                                  // Number of mipmap levels
-    imageCreateInfo.arrayLayers = 1;                                // Number of levels in image array
-    imageCreateInfo.format = format;
-    imageCreateInfo.tiling = tiling;                                // How image data should be "tiled" (aranged for optimal reading)
-    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;      // Layout of image data on creation
-    imageCreateInfo.usage = useFlags;                               // Bit flags defining what image will be used for
-    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;                // Number of samples for multisampling
-    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;        // Whether image can be shared between queues
-
-    VkImage image;
-    VkResult result = vkCreateImage(mainDevice.logicalDevice, &imageCreateInfo, nullptr, &image);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create Image!");
-    }
-
-    // Create Memory for image
-
-    // Get Memory Requirements for a type of image
-    VkMemoryRequirements memoryRequirements;
-    vkGetImageMemoryRequirements(mainDevice.logicalDevice, image, &memoryRequirements);
-
-    VkMemoryAllocateInfo memoryAllocateInfo = {};
-    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex = findMemoryTypeIndex(mainDevice.physicalDevice, memoryRequirements.memoryTypeBits, propertyFlags);
-
-    result = vkAllocateMemory(mainDevice.logicalDevice, &memoryAllocateInfo, nullptr, imageMemory);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to allcoate memory for image!");
-    }
-
-    // Connect memory for image
-    vkBindImageMemory(mainDevice.logicalDevice, image, *imageMemory, 0);
-
-    return image;
-}
-
 VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
 {
     VkImageViewCreateInfo imageViewCreateInfo = {};
@@ -1492,7 +2332,7 @@ VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkIm
     // Subresources allow the view to view only a part of an image
     imageViewCreateInfo.subresourceRange.aspectMask = aspectFlags;      // Which aspect of image to view (e.g. COLOR_BIT for viewing colour)
     imageViewCreateInfo.subresourceRange.baseMipLevel = 0;              // Start mipmap level to view from
-    imageViewCreateInfo.subresourceRange.levelCount = 1;                // Number of mipmap levels to view
+    imageViewCreateInfo.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;  // Number of mipmap levels to view
     imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;            // Start array level to view from
     imageViewCreateInfo.subresourceRange.layerCount = 1;                // Number of array levels to view
 
@@ -1508,68 +2348,28 @@ VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkIm
     return imageView;
 }
 
-VkShaderModule VulkanRenderer::createShaderModule(const std::vector<char> shaders)
+int VulkanRenderer::createTextureImage(const TextureData& texture)
 {
-    VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
-    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderModuleCreateInfo.codeSize = shaders.size();
-    shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(shaders.data());
+    // Create image to hold final data - whole mip chain, levels not in data are generated from first one
+    VkImage textureImage;
+    MemoryAllocation textureImageMemory;
 
-    VkShaderModule shaderModule;
-    VkResult result = vkCreateShaderModule(mainDevice.logicalDevice, &shaderModuleCreateInfo, nullptr, &shaderModule);
-    if (result != VK_SUCCESS)
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (texture.generateMipmaps)
     {
-        throw std::runtime_error("Failed to create a shader module!");
+        usage |= mipGenerator.getRequiredUsage(texture.format);
     }
 
-    return shaderModule;
-}
-
-int VulkanRenderer::createTextureImage(std::string filename)
-{
-    int width, height;
-    VkDeviceSize imageSize;
-    stbi_uc* imageData = loadTextureFile(filename, &width, &height, &imageSize);
-
-    // Create staging buffer to hold loaded data, ready to copy to device
-    VkBuffer imageStagingBuffer;
-    VkDeviceMemory imageStagingBufferMemory;
-    createBuffer(mainDevice.physicalDevice, mainDevice.logicalDevice, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &imageStagingBuffer, &imageStagingBufferMemory);
-
-    // Copy image data to staging buffer
-    void* data;
-    vkMapMemory(mainDevice.logicalDevice, imageStagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, imageData, static_cast<size_t>(imageSize));
-    vkUnmapMemory(mainDevice.logicalDevice, imageStagingBufferMemory);
+    textureImage = createImage(&memoryAllocator, mainDevice.logicalDevice, texture.width, texture.height, texture.format, VK_IMAGE_TILING_OPTIMAL, usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &textureImageMemory, texture.mipLevels);
 
-    // Free original image data
-    stbi_image_free(imageData);
-
-    // Create image to hold final data
-    VkImage textureImage;
-    VkDeviceMemory textureImageMemory;
-
-    textureImage = createImage(width, height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
-        , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &textureImageMemory);
-
-
-    // Transition image to be DST for copy operation
-    transitionImageLayout(mainDevice.logicalDevice, graphicsQueue, graphicsCommandPool, textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    // Copy data to image
-    copyImageBuffer(mainDevice.logicalDevice, graphicsQueue, graphicsCommandPool, imageStagingBuffer, textureImage, width, height);
-
-    // Transition image to be shader readable for shader usage
-    transitionImageLayout(mainDevice.logicalDevice, graphicsQueue, graphicsCommandPool, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // Record transition to DST, copy of image data and mip generation (ends shader readable) into shared upload batch
+    uploadBatch.uploadTexture(texture, textureImage);
 
     // Add texture data to vector for reference
     textureImages.push_back(textureImage);
     textureImagesMemory.push_back(textureImageMemory);
-
-    // Destroy staging buffer
-    vkDestroyBuffer(mainDevice.logicalDevice, imageStagingBuffer, nullptr);
-    vkFreeMemory(mainDevice.logicalDevice, imageStagingBufferMemory, nullptr);
+    textureInfos.push_back(TextureLoader::getInfo(texture, textureImageMemory));
 
     // Return index of new texture image
     return textureImages.size() - 1;
@@ -1578,10 +2378,10 @@ int VulkanRenderer::createTextureImage(std::string filename)
 int VulkanRenderer::createTexture(std::string filename)
 {
     // Create Texture Image 
-    int textureImageLoc = createTextureImage(filename);
+    int textureImageLoc = createTextureImage(textureLoader.load(filename));
 
     // Create Image View
-    VkImageView imageView = createImageView(textureImages[textureImageLoc], VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+    VkImageView imageView = createImageView(textureImages[textureImageLoc], textureInfos[textureImageLoc].format, VK_IMAGE_ASPECT_COLOR_BIT);
     textureImageView.push_back(imageView);
 
     // Create texture descriptor
@@ -1591,21 +2391,76 @@ int VulkanRenderer::createTexture(std::string filename)
     return textureDescriptorLoc;
 }
 
+std::vector<int> VulkanRenderer::createTextures(const std::vector<std::string>& filenames)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct DecodedTexture {
+        TextureData texture;
+        double decodeMs;
+    };
+
+    Clock::time_point batchStart = Clock::now();
+
+    textureLoadTiming = TextureBatchTiming();
+    textureLoadTiming.files.resize(filenames.size());
+
+    // Decode every file on its own pool thread
+    std::vector<std::future<DecodedTexture>> decodedTextures;
+    std::vector<int> textureDescriptors;
+    {
+        ThreadPool threadPool;
+
+        for (const auto& filename : filenames)
+        {
+            decodedTextures.push_back(threadPool.submit([this, filename]
+            {
+                Clock::time_point decodeStart = Clock::now();
+
+                DecodedTexture decoded;
+                decoded.texture = textureLoader.load(filename);
+                decoded.decodeMs = std::chrono::duration<double, std::milli>(Clock::now() - decodeStart).count();
+
+                return decoded;
+            }));
+        }
+
+        // Record uploads in file order while later files are still decoding
+        for (size_t i = 0; i < filenames.size(); i++)
+        {
+            DecodedTexture decoded = decodedTextures[i].get();
+
+            Clock::time_point stageStart = Clock::now();
+
+            int textureImageLoc = createTextureImage(decoded.texture);
+
+            VkImageView imageView = createImageView(textureImages[textureImageLoc], decoded.texture.format, VK_IMAGE_ASPECT_COLOR_BIT);
+            textureImageView.push_back(imageView);
+            textureDescriptors.push_back(createTextureDescriptor(imageView));
+
+            textureLoadTiming.files[i].filename = decoded.texture.filename;
+            textureLoadTiming.files[i].decodeMs = decoded.decodeMs;
+            textureLoadTiming.files[i].stageMs = std::chrono::duration<double, std::milli>(Clock::now() - stageStart).count();
+        }
+    }
+
+    // One submit for all textures - wait only to measure it, queue order already keeps it ahead of drawing
+    Clock::time_point uploadStart = Clock::now();
+    stagingRing.wait(uploadBatch.submit());
+    textureLoadTiming.uploadMs = std::chrono::duration<double, std::milli>(Clock::now() - uploadStart).count();
+
+    textureLoadTiming.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - batchStart).count();
+
+    return textureDescriptors;
+}
+
 int VulkanRenderer::createTextureDescriptor(VkImageView textureImage)
 {
-    VkDescriptorSet descriptorSet;
-    
-    VkDescriptorSetAllocateInfo setAllocInfo = {};
-    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    setAllocInfo.descriptorPool = samplerDescriptorPool;
-    setAllocInfo.descriptorSetCount = 1;
-    setAllocInfo.pSetLayouts = &samplerSetLayout;
-
-    // Allocate Descriptor Set
-    VkResult result = vkAllocateDescriptorSets(mainDevice.logicalDevice, &setAllocInfo, &descriptorSet);
-    if (result != VK_SUCCESS)
+    // Image view of texture was just added - its index is the next array element
+    uint32_t textureIndex = static_cast<uint32_t>(textureImageView.size()) - 1;
+    if (textureIndex >= MAX_TEXTURES)
     {
-        throw std::runtime_error("Failed to allocate Texture Descriptor Sets!");
+        throw std::runtime_error("Texture descriptor array is full!");
     }
 
     // Texture Image Info
@@ -1615,41 +2470,19 @@ int VulkanRenderer::createTextureDescriptor(VkImageView textureImage)
     imageInfo.sampler = textureSampler;                                 // Sampler to use for set
 
     // Descriptor Write Info
+    // Element isn't used by any frame in flight yet, so it can be written while set is bound (update unused while pending)
     VkWriteDescriptorSet descriptorWrite = {};
     descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstSet = samplerDescriptorSet;
     descriptorWrite.dstBinding = 0;
-    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.dstArrayElement = textureIndex;
     descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     descriptorWrite.descriptorCount = 1;
     descriptorWrite.pImageInfo = &imageInfo;
 
-    // Update new descriptor set
+    // Update element of texture array
     vkUpdateDescriptorSets(mainDevice.logicalDevice, 1, &descriptorWrite, 0, nullptr);
 
-    // Add descriptor set to list
-    samplerDescriptorSets.push_back(descriptorSet);
-
-    // Return descriptor set location
-    return samplerDescriptorSets.size() - 1;
-}
-
-stbi_uc* VulkanRenderer::loadTextureFile(std::string filename, int * width, int * height, VkDeviceSize* imageSize)
-{
-    // Number of channels image uses
-    int channels;
-    
-    // load pixel data for image
-    std::string fileLoc = "Textures/" + filename;
-    stbi_uc* image = stbi_load(fileLoc.c_str(), width, height, &channels, STBI_rgb_alpha);
-
-    if (!image)
-    {
-        throw std::runtime_error("Failed to load a Texture file (" + filename + ")");
-    }
-
-    // Mulitply by number of channels
-    *imageSize = *width * *height * 4;
-
-    return image;
+    // Return array element texture is at
+    return static_cast<int>(textureIndex);
 }
\ No newline at end of file
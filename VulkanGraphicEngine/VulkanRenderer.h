@@ -15,10 +15,37 @@
 #include <set>
 #include <algorithm>
 #include <array>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
 
 #include "Mesh.h"
+#include "UploadBatch.h"
+#include "TextureLoader.h"
+#include "AssetStreamer.h"
+#include "UniformRing.h"
+#include "ThreadPool.h"
+#include "MeshFile.h"
+#include "GpuCuller.h"
+#include "DepthPyramid.h"
+#include "OcclusionRasterizer.h"
+#include "RenderQueue.h"
 #include "Utilities.h"
 
+struct TextureLoadTiming {
+    std::string filename;
+    double decodeMs = 0.0;          // Reading and decoding file (on pool thread)
+    double stageMs = 0.0;           // Creating image, copying pixels to staging and recording upload
+};
+
+struct TextureBatchTiming {
+    std::vector<TextureLoadTiming> files;
+    double totalMs = 0.0;           // Whole createTextures call
+    double uploadMs = 0.0;          // Single GPU submit of all textures, until it finished
+};
+
 class VulkanRenderer
 {
 public:
@@ -26,9 +53,72 @@ public:
 
     int init(GLFWwindow* window);
     void updateModel(int modelId, glm::mat4 model);
+    std::vector<int> getSceneMeshes();          // Meshes created by init, in order - ids for updateModel
+    void updateColour(int modelId, glm::vec4 colour);
     void draw();
     void cleanup();
 
+    MemoryStats getMemoryStats();
+    GeometryArenaStats getGeometryStats();
+    IndexStats getIndexStats();
+    TextureBatchTiming getTextureLoadTiming();
+    TextureInfo getTextureInfo(int texture);
+    std::vector<VkFormat> getCompressedTextureFormats();   // Block compressed formats device samples, most preferred first
+
+    // Asset streaming - handles are returned straight away, assets appear in scene once they are resident
+    AssetHandle streamTexture(const std::string& filename, float priority);
+    AssetHandle streamMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, AssetHandle texture, float priority,
+        VertexLayout vertexLayout = VertexLayout::Standard);
+
+    // Model from Models/ - one mesh handle per submesh, textures are streamed along
+    // "name.obj" is drawn from "name.vmesh" cooked by AssetCooker (archive or loose file) - throws if it is missing or out of date
+    std::vector<AssetHandle> streamModel(const std::string& filename, float priority);
+    void setAssetPriority(AssetHandle asset, float priority);
+    bool cancelAsset(AssetHandle asset);
+    int getAssetIndex(AssetHandle asset);      // Texture / mesh index of resident asset, -1 if it isn't resident yet
+
+    // Close gaps left in geometry arena by freed meshes - waits for device idle, returns bytes moved
+    VkDeviceSize compactGeometry();
+
+    // Hardware instancing - mesh is drawn once for every given transform instead of once with its own model.
+    // Instances are grouped by detail level, each group takes one draw. Texture indices are per instance (empty - mesh's own).
+    void setInstances(int meshId, std::vector<glm::mat4> models, std::vector<int> textureIndices = std::vector<int>());
+    void clearInstances(int meshId);
+
+    // Scales screen space error LODs may have - above 1 coarser levels are picked sooner (faster), below 1 later
+    void setLodBias(float lodBias);
+    LodStats getLodStats();                    // Of last recorded frame
+
+    // GPU-driven drawing - draws are written to an indirect buffer and issued with one vkCmdDrawIndexedIndirectCount per pipeline / index type
+    // Off (or unsupported by device) - one vkCmdDrawIndexed per draw
+    void setIndirectDrawing(bool indirect);
+    bool isIndirectDrawingSupported();
+    DrawStats getDrawStats();                  // Of last recorded frame
+
+    // Frustum culling of every object on GPU before indirect draws - only with indirect drawing, objects are then drawn one per command
+    void setGpuCulling(bool culling);
+
+    // Two-phase occlusion culling with GPU culling - objects hidden behind depth pyramid of previous frame wait for
+    // a retest against depth of this frame's first draws, so they are only drawn if they became visible
+    void setOcclusionCulling(bool culling);
+
+    // Frustum culling on CPU of draws GPU doesn't cull - SIMD over bounding spheres of meshes and instances
+    void setCpuCulling(bool culling);
+    void setCpuCullKernel(CullKernel kernel);
+
+    // Occlusion culling on CPU of draws it frustum culls - occluder geometry (a few large triangles standing in for mesh,
+    // in its model space) is rasterized in software, meshes and instances whose bounding boxes are behind it aren't drawn.
+    // Occluder of instanced mesh is placed at every instance.
+    void setOccluder(int meshId, std::vector<glm::vec3> positions, std::vector<uint32_t> indices);
+    void clearOccluder(int meshId);
+    void setCpuOcclusionCulling(bool culling);
+
+    // Culled on GPU - of latest frame device finished (MAX_FRAME_DRAWS frames behind), on CPU - of last recorded frame
+    CullStats getCullStats();
+
+    // Trilinear sampling through full mip chain (or first level only) and anisotropy (1 - off, clamped to device limit)
+    void setTextureFiltering(bool mipmaps, float anisotropy);
+
     ~VulkanRenderer();
 
 private:
@@ -37,8 +127,48 @@ private:
 
     // Scene Objects
     std::vector<Mesh> meshes;
+    std::vector<int> sceneMeshes;               // Created by init
+
+    struct InstanceBatch {
+        std::vector<glm::mat4> models;
+        std::vector<int> textureIndices;
+    };
+    std::map<int, InstanceBatch> instanceBatches;   // Mesh index -> its instances
+    std::vector<uint32_t> instanceKeys;             // LOD of every instance of batch being recorded
+    std::vector<uint32_t> instanceGroupStarts;      // Counting sort of instances by group - first instance of every group
+    std::vector<uint32_t> instanceGroupHeads;       // Next free place in every group while instances are scattered
+
+    FrustumCuller frustumCuller;
+    BoundingSpheres cullSpheres;                    // World bounds of meshes (or instances of batch) being culled
+    std::vector<uint32_t> cullSphereMeshes;         // Mesh of every sphere
+    std::vector<uint32_t> visibleSpheres;
+    std::vector<uint32_t> visibleMeshes;            // Meshes recorded in current frame
+    std::vector<uint32_t> visibleInstances;         // Instances of batch being recorded
+
+    struct OccluderGeometry {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
+    std::map<int, OccluderGeometry> occluders;      // Mesh index -> geometry rasterized in its place
+    ThreadPool frameThreadPool;                     // Parallel parts of recording - occluder tile rows, render queue sort
+    OcclusionRasterizer occlusionRasterizer;
+
+    RenderQueue renderQueue;                        // Draws of frame, recorded in order of their sort keys
+    std::vector<float> instanceGroupDepths;         // Nearest instance of every group of batch being recorded
+    VkPipeline boundPipeline;                       // Graphics state bound in command buffer being recorded
+    VkIndexType boundIndexType;
 
     // Scene Settings
+    float lodBias = 1.0f;
+    LodStats lodStats;
+    bool indirectDrawing = true;
+    bool indirectDrawingSupported = false;      // multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount
+    bool gpuCulling = true;
+    bool occlusionCulling = true;
+    bool cpuCulling = true;
+    bool cpuOcclusionCulling = true;
+    CullStats cullStats;                        // Of CPU culling
+    DrawStats drawStats;
 
     struct UboViewProjection {
         glm::mat4 projection;           // How camera views the world (depth - 3D, flat - 2D)
@@ -53,8 +183,28 @@ private:
         VkDevice logicalDevice;
     } mainDevice;
 
+    // Sub-allocates device memory for all buffers and images
+    MemoryAllocator memoryAllocator;
+
+    // Vertex and index data of all meshes - buffers are bound once per frame
+    GeometryArena geometryArena;
+
+    // Shared staging memory for all uploads to device local resources
+    StagingRing stagingRing;
+    MipGenerator mipGenerator;                 // Fills mip chains of textures uploaded through uploadBatch
+    UploadBatch uploadBatch;                   // Uploads recorded by asset creation, submitted together
+
+    // Background loading of assets after startup
+    AssetStreamer assetStreamer;
+    std::map<AssetHandle, int> residentAssets;  // Streamed asset -> texture descriptor / mesh index
+    std::vector<StreamedMesh> waitingMeshes;    // Resident meshes whose texture isn't resident yet
+    std::mutex queueMutex;                      // Queues are shared with streaming thread
+
+    TextureBatchTiming textureLoadTiming;       // Timings of last createTextures call
+
     VkQueue graphicsQueue;
     VkQueue presentationQueue;
+    VkQueue transferQueue;                     // Same as graphicsQueue when device has no separate transfer family
     VkSurfaceKHR surface;
     VkSwapchainKHR swapchain;
     std::vector<SwapChainImage> swapChainImages;
@@ -62,8 +212,9 @@ private:
     std::vector<VkCommandBuffer> commandBuffers;
 
     VkImage depthBufferImage;
-    VkDeviceMemory depthBufferImageMemory;
+    MemoryAllocation depthBufferImageMemory;
     VkImageView depthBufferImageView;
+    DepthPyramid depthPyramid;                 // Of depth buffer, for occlusion culling (with indirect drawing support only)
 
     // Descriptors
     VkDescriptorSetLayout descriptorSetLayout;
@@ -71,26 +222,36 @@ private:
 
     VkDescriptorPool descriptorPool;
     VkDescriptorPool samplerDescriptorPool;
-    std::vector<VkDescriptorSet> descriptorSets;
-    std::vector<VkDescriptorSet> samplerDescriptorSets;
+    VkDescriptorSet descriptorSet;
+    VkDescriptorSet samplerDescriptorSet;      // Array of every texture - element i is texture i, indexed in shader by ObjectData::textureIndex
 
-    std::vector<VkBuffer> vpUniformBuffer;
-    std::vector<VkDeviceMemory> vpUniformBufferMemory;
+    UniformRing uniformRing;
+    uint32_t vpUniformOffset;                  // Dynamic offset of current frame's ViewProjection data in uniform ring
+    UniformRing objectRing;                    // ObjectData of everything drawn in current frame, storage buffer indexed by gl_InstanceIndex
+    UniformRing indirectRing;                  // Indirect draw commands and draw counts of current frame
+
+    // Indirect draws of frame being recorded - [vertex layout * 2 + index type], every list is one indirect call
+    std::array<std::vector<VkDrawIndexedIndirectCommand>, VERTEX_LAYOUT_COUNT * 2> indirectDraws;
+    GpuCuller gpuCuller;                       // Turns same lists into candidates culled on GPU (CULL_DRAW_LISTS == VERTEX_LAYOUT_COUNT * 2)
 
     //std::vector<VkBuffer> modelUniformBuffer;
     //std::vector<VkDeviceMemory> modelUniformBufferMemory;
 
-    VkPushConstantRange pushConstantRange;
-
-    //VkDeviceSize minUniformBufferOffset;
+    VkDeviceSize minUniformBufferOffset;
     //size_t modelUniformAlignment;
     //Model* modelTransferSpace;
 
     // - Assets
     VkSampler textureSampler;
+    bool textureMipmaps = true;                 // Sampler uses all mip levels of textures
+    float textureAnisotropy = DEFAULT_ANISOTROPY;
+    float maxSamplerAnisotropy;                 // Device limit
     std::vector<VkImage> textureImages;
-    std::vector<VkDeviceMemory> textureImagesMemory;
+    std::vector<MemoryAllocation> textureImagesMemory;
     std::vector<VkImageView> textureImageView;
+    std::vector<TextureInfo> textureInfos;
+    TextureLoader textureLoader;
+    AssetArchive assetArchive;                 // Mapped Assets.pak - shader code and cooked textures are read from it in place
 
     VkFormat swapChainFormat;
     VkExtent2D swapChainExtent;
@@ -101,12 +262,14 @@ private:
     std::vector<VkFence> drawFences;
 
     // Pipeline
-    VkPipeline graphicsPipeline;
+    std::array<VkPipeline, VERTEX_LAYOUT_COUNT> graphicsPipelines;     // Indexed by VertexLayout
     VkPipelineLayout pipelineLayout;
     VkRenderPass renderPass;
+    VkRenderPass loadRenderPass;               // Compatible with renderPass, continues on its stored attachments - draws after occlusion retest
 
     // Pools
     VkCommandPool graphicsCommandPool;
+    VkCommandPool transferCommandPool;
 
     // Vulkan Functions
     // - Create Functions
@@ -116,11 +279,13 @@ private:
     void createSwapchain();
     void createRenderPass();
     void createDescriptorSetLayout();
-    void createPushConstantRange();
     void createGraphicsPipeline();
     void createDepthBufferImage();
     void createFramebuffers();
     void createCommandPool();
+    void createGeometryArena();
+    void createStagingRing();
+    void createAssetStreamer();
     void createCommandBuffers();
     void createSynchronisation();
     void createTextureSampler();
@@ -129,10 +294,22 @@ private:
     void createDescriptorPool();
     void createDescriptorSets();
 
-    void updateUniformBuffers(uint32_t imageIndex);
+    void updateUniformBuffers();
+    void updateStreaming();
 
     // - Record Functions
     void recordCommands(uint32_t currentImage);
+    // frustumPlanes - instances are culled against them first (nullptr - all are drawn), occluded - then against rasterized occluders
+    void queueInstances(int meshId, const InstanceBatch& batch, const glm::vec3& cameraPosition, float pixelsPerUnit,
+        const glm::vec4* frustumPlanes, bool occluded);
+    void rasterizeOccluders(const glm::mat4& viewProjection);
+    // depth - distance of draw from camera, orders draws sharing state front to back
+    void queueMeshDraw(int meshId, uint32_t lod, uint32_t firstInstance, uint32_t instanceCount, float depth);
+    void recordQueuedDraws(VkCommandBuffer commandBuffer);
+    void bindDrawState(VkCommandBuffer commandBuffer, VertexLayout vertexLayout, VkIndexType indexType);
+    void recordIndirectDraws(VkCommandBuffer commandBuffer);
+    void recordCulledDraws(VkCommandBuffer commandBuffer, const std::array<CullDrawList, CULL_DRAW_LISTS>& drawLists);
+    void writeObject(ObjectData* object, Mesh& mesh, const glm::mat4& model, int textureIndex);
 
     // - Get Functions
     void getPhysicalDevice();
@@ -160,15 +337,11 @@ private:
     VkFormat chooseSupportedFormat(const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags);
 
     // -- Create Functions
-    VkImage createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags useFlags, VkMemoryPropertyFlags propertyFlags, VkDeviceMemory *imageMemory);
     VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-    VkShaderModule createShaderModule(const std::vector<char> shaders);
 
-    int createTextureImage(std::string filename);
+    int createTextureImage(const TextureData& texture);
     int createTexture(std::string filename);
+    std::vector<int> createTextures(const std::vector<std::string>& filenames);
     int createTextureDescriptor(VkImageView textureImage);
-
-    // -- Loader Functions
-    stbi_uc* loadTextureFile(std::string filename, int* width, int* height, VkDeviceSize* imageSize);
 };
 
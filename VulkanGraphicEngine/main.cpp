@@ -11,6 +11,8 @@
 #include <iostream>
 #include <string>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 #include "VulkanRenderer.h"
 
@@ -27,7 +29,43 @@ void initWindow(std::string name = "", const int width = 800, const int height =
     window = glfwCreateWindow(width, height, name.c_str(), nullptr, nullptr);
 }
 
-int main() {
+// Startup textures, device memory and geometry after loading the scene
+void printSceneStats()
+{
+    // Startup texture loading - decode runs in parallel, upload is a single submit
+    TextureBatchTiming textureTiming = vulkanRenderer.getTextureLoadTiming();
+    printf("Textures: %zu loaded in %.2f ms (GPU upload %.2f ms)\n", textureTiming.files.size(), textureTiming.totalMs, textureTiming.uploadMs);
+    for (size_t i = 0; i < textureTiming.files.size(); i++)
+    {
+        // Startup textures are first ones created - file i is texture i
+        TextureInfo textureInfo = vulkanRenderer.getTextureInfo(static_cast<int>(i));
+        printf("  %s: decode %.2f ms, stage %.2f ms, %ux%u %u mips, %s %llu KB (RGBA8 %llu KB)\n", textureTiming.files[i].filename.c_str(),
+            textureTiming.files[i].decodeMs, textureTiming.files[i].stageMs, textureInfo.width, textureInfo.height, textureInfo.mipLevels,
+            TextureLoader::getFormatSuffix(textureInfo.format), static_cast<unsigned long long>(textureInfo.memorySize / 1024),
+            static_cast<unsigned long long>(textureInfo.uncompressedSize / 1024));
+    }
+
+    // Device memory usage
+    MemoryStats memoryStats = vulkanRenderer.getMemoryStats();
+    printf("Memory: %u allocations, %u blocks, %u dedicated, fragmentation %.2f\n",
+        memoryStats.allocationCount, memoryStats.blockCount, memoryStats.dedicatedCount, memoryStats.fragmentation);
+    GeometryArenaStats geometryStats = vulkanRenderer.getGeometryStats();
+    printf("Geometry arena: %u meshes, vertices %llu of %llu KB, indices %llu of %llu KB, fragmentation %.2f\n", geometryStats.allocationCount,
+        static_cast<unsigned long long>(geometryStats.vertexBytes / 1024), static_cast<unsigned long long>(geometryStats.vertexCapacity / 1024),
+        static_cast<unsigned long long>(geometryStats.indexBytes / 1024), static_cast<unsigned long long>(geometryStats.indexCapacity / 1024),
+        geometryStats.fragmentation);
+    IndexStats indexStats = vulkanRenderer.getIndexStats();
+    printf("Indices: %u of %u meshes 16 bit, %llu bytes (%llu bytes as 32 bit)\n", indexStats.uint16MeshCount, indexStats.meshCount,
+        static_cast<unsigned long long>(indexStats.indexBytes), static_cast<unsigned long long>(indexStats.uint32IndexBytes));
+    for (size_t i = 0; i < memoryStats.heaps.size(); i++)
+    {
+        printf("  Heap %zu: %llu KB used, %llu KB allocated, %llu KB size\n", i,
+            static_cast<unsigned long long>(memoryStats.heaps[i].usedBytes / 1024), static_cast<unsigned long long>(memoryStats.heaps[i].allocatedBytes / 1024),
+            static_cast<unsigned long long>(memoryStats.heaps[i].heapSize / 1024));
+    }
+}
+
+int main(int argc, char** argv) {
 
     initWindow(title.c_str(), 800, 600);
 
@@ -35,6 +73,48 @@ int main() {
         return EXIT_FAILURE;
     }
 
+    // --stats : textures, memory and geometry of loaded scene
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--stats") == 0)
+        {
+            printSceneStats();
+        }
+    }
+
+    // Streamed in background while scene is already being drawn - shows up once it is resident
+    AssetHandle streamedTexture = vulkanRenderer.streamTexture("wall_brick_plain.tga", 0.0f);
+    AssetHandle streamedMesh = vulkanRenderer.streamMesh({
+            {{-0.2, 0.2, 0.0}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}},
+            {{-0.2, -0.2, 0.0}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f}},
+            {{ 0.2, -0.2, 0.0}, {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f}},
+            {{ 0.2, 0.2, 0.0}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}},
+        }, { 0, 1, 2, 2, 3, 0 }, streamedTexture, 0.0f);
+
+    // --model name.obj : model from Models/ streamed in behind the quads
+    // --lod-bias x : LOD error tolerance scale (higher - coarser levels, fewer triangles)
+    std::vector<AssetHandle> modelMeshes;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--lod-bias") == 0)
+        {
+            vulkanRenderer.setLodBias(static_cast<float>(atof(argv[i + 1])));
+        }
+        else if (strcmp(argv[i], "--model") == 0)
+        {
+            try
+            {
+                modelMeshes = vulkanRenderer.streamModel(argv[i + 1], 1.0f);
+            }
+            catch (const std::runtime_error& e)
+            {
+                printf("ERROR: %s\n", e.what());
+            }
+        }
+    }
+
+    std::vector<int> sceneMeshes = vulkanRenderer.getSceneMeshes();
+
     // Rotation
     float angle = 0.0f;
     float deltaTime = 0.0f;
@@ -64,23 +144,43 @@ int main() {
         if (framesDeltaTime >= 1.0f)
         {
             double fps = double(framesCounter) / deltaTime;
-            std::string windowTitle = title + " [ fps: " + std::to_string(fps) + " ]";
+            LodStats lodStats = vulkanRenderer.getLodStats();
+            CullStats cullStats = vulkanRenderer.getCullStats();
+            DrawStats drawStats = vulkanRenderer.getDrawStats();
+            std::string windowTitle = title + " [ fps: " + std::to_string(fps) + ", triangles: " + std::to_string(lodStats.triangles) +
+                " of " + std::to_string(lodStats.fullTriangles) + ", visible: " + std::to_string(cullStats.visibleObjects) + " of " +
+                std::to_string(cullStats.totalObjects) + ", occluded: " + std::to_string(cullStats.occludedObjects) + ", binds: " +
+                std::to_string(drawStats.bindCalls) + " (" + std::to_string(drawStats.avoidedBinds) + " avoided) ]";
             glfwSetWindowTitle(window, windowTitle.c_str());
             framesCounter = 0;
             framesLastTime = 0;
         }
 
-        glm::mat4 firstModel(1.0f);
-        glm::mat4 secondModel(1.0f);
-
-        //firstModel = glm::translate(firstModel, glm::vec3(-2.0f, 0.0f, -5.0f));
-        firstModel = glm::rotate(firstModel, glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f));
+        // Meshes init created spin in turns one way slowly and the other way fast
+        for (size_t i = 0; i < sceneMeshes.size(); i++)
+        {
+            float meshAngle = i % 2 == 0 ? angle : -angle * 100;
+            vulkanRenderer.updateModel(sceneMeshes[i], glm::rotate(glm::mat4(1.0f), glm::radians(meshAngle), glm::vec3(0.0f, 0.0f, 1.0f)));
+        }
 
-        //secondModel = glm::translate(secondModel, glm::vec3(2.0f, 0.0f, -5.0f));
-        secondModel = glm::rotate(secondModel, glm::radians(-angle * 100), glm::vec3(0.0f, 0.0f, 1.0f));
+        int streamedMeshIndex = vulkanRenderer.getAssetIndex(streamedMesh);
+        if (streamedMeshIndex >= 0)
+        {
+            glm::mat4 streamedModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.6f, -1.0f));
+            vulkanRenderer.updateModel(streamedMeshIndex, glm::rotate(streamedModel, glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f)));
+        }
 
-        vulkanRenderer.updateModel(0, firstModel);
-        vulkanRenderer.updateModel(1, secondModel);
+        for (AssetHandle modelMesh : modelMeshes)
+        {
+            int modelMeshIndex = vulkanRenderer.getAssetIndex(modelMesh);
+            if (modelMeshIndex >= 0)
+            {
+                // Moves away and back - LOD switches on the way
+                float modelDistance = 3.0f + 12.0f * (0.5f - 0.5f * std::cos(glm::radians(angle * 4.0f)));
+                glm::mat4 modelTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -modelDistance));
+                vulkanRenderer.updateModel(modelMeshIndex, glm::rotate(modelTransform, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f)));
+            }
+        }
 
         vulkanRenderer.draw();
     }
@@ -0,0 +1,658 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+#include "VulkanRenderer.h"
+
+const std::string title = "Benchmark Window";
+GLFWwindow* window;
+VulkanRenderer vulkanRenderer;
+
+void initWindow(std::string name = "", const int width = 800, const int height = 600) {
+
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(width, height, name.c_str(), nullptr, nullptr);
+}
+
+// Average frame time of given number of frames (after a short warm up)
+double measureFrameTime(int frameCount)
+{
+    for (int i = 0; i < 30 && !glfwWindowShouldClose(window); i++)
+    {
+        glfwPollEvents();
+        vulkanRenderer.draw();
+    }
+
+    double start = glfwGetTime();
+    for (int i = 0; i < frameCount && !glfwWindowShouldClose(window); i++)
+    {
+        glfwPollEvents();
+        vulkanRenderer.draw();
+    }
+
+    return (glfwGetTime() - start) * 1000.0 / frameCount;
+}
+
+// Long textured ground plane going into the distance - minified texture is where mip chain matters
+// Note: with FIFO presentation (no mailbox support) both results are capped by display refresh rate
+void runMipBenchmark()
+{
+    AssetHandle groundTexture = vulkanRenderer.streamTexture("wall_brick_plain.tga", 0.0f);
+    AssetHandle groundMesh = vulkanRenderer.streamMesh({
+            {{-5.0, -0.3, -40.0}, {1.0f, 1.0f, 1.0f}, {0.0f, 40.0f}},
+            {{-5.0, -0.3, 1.5}, {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f}},
+            {{ 5.0, -0.3, 1.5}, {1.0f, 1.0f, 1.0f}, {10.0f, 0.0f}},
+            {{ 5.0, -0.3, -40.0}, {1.0f, 1.0f, 1.0f}, {10.0f, 40.0f}},
+        }, { 0, 1, 2, 2, 3, 0 }, groundTexture, 0.0f);
+
+    while (vulkanRenderer.getAssetIndex(groundMesh) < 0 && !glfwWindowShouldClose(window))
+    {
+        glfwPollEvents();
+        vulkanRenderer.draw();
+    }
+
+    const int frameCount = 500;
+
+    vulkanRenderer.setTextureFiltering(true, DEFAULT_ANISOTROPY);
+    double mipmappedMs = measureFrameTime(frameCount);
+
+    vulkanRenderer.setTextureFiltering(false, DEFAULT_ANISOTROPY);
+    double firstLevelMs = measureFrameTime(frameCount);
+
+    printf("Mip benchmark (%d frames): full mip chain %.3f ms/frame, first level only %.3f ms/frame\n", frameCount, mipmappedMs, firstLevelMs);
+}
+
+// Dense grid facing camera - big enough for vertex fetch to show in frame time
+void createGrid(uint32_t size, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices)
+{
+    for (uint32_t y = 0; y <= size; y++)
+    {
+        for (uint32_t x = 0; x <= size; x++)
+        {
+            float u = static_cast<float>(x) / size;
+            float v = static_cast<float>(y) / size;
+            vertices->push_back({ { u - 0.5f, v - 0.5f, 0.0f }, { 1.0f, 1.0f, 1.0f }, { u, v } });
+        }
+    }
+
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            uint32_t corner = y * (size + 1) + x;
+            indices->insert(indices->end(), { corner, corner + 1, corner + size + 2, corner + size + 2, corner + size + 1, corner });
+        }
+    }
+}
+
+// Frame time added by same grid mesh in Standard (32 byte) and Compact (16 byte) vertex layout
+// Note: with FIFO presentation (no mailbox support) results are capped by display refresh rate
+void runVertexBenchmark()
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    createGrid(1000, &vertices, &indices);
+
+    const int frameCount = 300;
+    double baseMs = measureFrameTime(frameCount);
+
+    double layoutMs[VERTEX_LAYOUT_COUNT];
+    for (uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+    {
+        AssetHandle grid = vulkanRenderer.streamMesh(vertices, indices, INVALID_ASSET, 0.0f, static_cast<VertexLayout>(i));
+        while (vulkanRenderer.getAssetIndex(grid) < 0 && !glfwWindowShouldClose(window))
+        {
+            glfwPollEvents();
+            vulkanRenderer.draw();
+        }
+
+        // Every grid streamed so far stays in scene - cost of this one is the difference
+        layoutMs[i] = measureFrameTime(frameCount);
+    }
+
+    printf("Vertex benchmark (%zu vertices, %d frames): Standard %u B/vertex +%.3f ms/frame, Compact %u B/vertex +%.3f ms/frame\n",
+        vertices.size(), frameCount, VertexPacker::getStride(VertexLayout::Standard), layoutMs[0] - baseMs,
+        VertexPacker::getStride(VertexLayout::Compact), layoutMs[1] - layoutMs[0]);
+}
+
+// Field of small grids in front of camera, count of them spread over a 50 x 40 x 50 lattice
+std::vector<glm::mat4> createInstanceField(uint32_t count)
+{
+    std::vector<glm::mat4> models;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 position(static_cast<float>(i % 50) * 0.4f - 10.0f, static_cast<float>((i / 50) % 40) * 0.4f - 8.0f, -3.0f - static_cast<float>(i / 2000));
+        models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.2f)));
+    }
+
+    return models;
+}
+
+// Frame time added by the same small mesh drawn as instances of one mesh (one draw) and as separate meshes (one draw each)
+// Note: with FIFO presentation (no mailbox support) results are capped by display refresh rate
+void runInstancingBenchmark()
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    createGrid(4, &vertices, &indices);
+
+    const int frameCount = 300;
+    const uint32_t meshCount = 1000;
+    const uint32_t instanceCounts[] = { meshCount, 10000, 100000 };
+    double baseMs = measureFrameTime(frameCount);
+
+    std::vector<AssetHandle> grids;
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        grids.push_back(vulkanRenderer.streamMesh(vertices, indices, INVALID_ASSET, 0.0f));
+    }
+    while (vulkanRenderer.getAssetIndex(grids.back()) < 0 && !glfwWindowShouldClose(window))
+    {
+        glfwPollEvents();
+        vulkanRenderer.draw();
+    }
+
+    // Every grid but first is moved out of view (behind camera) while first one is instanced
+    std::vector<glm::mat4> models = createInstanceField(meshCount);
+    for (uint32_t i = 1; i < meshCount; i++)
+    {
+        vulkanRenderer.updateModel(vulkanRenderer.getAssetIndex(grids[i]), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 100.0f)));
+    }
+
+    int instancedMesh = vulkanRenderer.getAssetIndex(grids[0]);
+    for (uint32_t instanceCount : instanceCounts)
+    {
+        vulkanRenderer.setInstances(instancedMesh, createInstanceField(instanceCount));
+        double instancedMs = measureFrameTime(frameCount);
+        LodStats lodStats = vulkanRenderer.getLodStats();
+        printf("Instancing benchmark: %u instances of one mesh +%.3f ms/frame (%u draws, %llu triangles)\n", instanceCount, instancedMs - baseMs,
+            lodStats.drawCount, static_cast<unsigned long long>(lodStats.triangles));
+    }
+    vulkanRenderer.clearInstances(instancedMesh);
+
+    // Same field as separate meshes
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        vulkanRenderer.updateModel(vulkanRenderer.getAssetIndex(grids[i]), models[i]);
+    }
+    double separateMs = measureFrameTime(frameCount);
+    printf("Instancing benchmark: %u separate meshes +%.3f ms/frame (%u draws)\n", meshCount, separateMs - baseMs, vulkanRenderer.getLodStats().drawCount);
+}
+
+// Same scene of many separate meshes recorded with one draw call per mesh and with indirect draws. Every other mesh has compact
+// vertices, so in mesh order pipelines alternate - render queue sorts draws of one pipeline together.
+// Recording time is measured on CPU and doesn't depend on presentation - frame time is capped by display refresh rate with FIFO.
+void runIndirectBenchmark()
+{
+    if (!vulkanRenderer.isIndirectDrawingSupported())
+    {
+        printf("Indirect benchmark: device doesn't support multiDrawIndirect / drawIndirectCount\n");
+        return;
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    createGrid(2, &vertices, &indices);
+
+    const int frameCount = 300;
+    const uint32_t meshCounts[] = { 1000, 10000, 30000 };
+    vulkanRenderer.setGpuCulling(false);
+    vulkanRenderer.setCpuCulling(false);
+
+    std::vector<AssetHandle> grids;
+    for (uint32_t meshCount : meshCounts)
+    {
+        while (grids.size() < meshCount)
+        {
+            VertexLayout vertexLayout = grids.size() % 2 == 0 ? VertexLayout::Standard : VertexLayout::Compact;
+            grids.push_back(vulkanRenderer.streamMesh(vertices, indices, INVALID_ASSET, 0.0f, vertexLayout));
+        }
+        while (vulkanRenderer.getAssetIndex(grids.back()) < 0 && !glfwWindowShouldClose(window))
+        {
+            glfwPollEvents();
+            vulkanRenderer.draw();
+        }
+
+        std::vector<glm::mat4> models = createInstanceField(meshCount);
+        for (uint32_t i = 0; i < meshCount; i++)
+        {
+            vulkanRenderer.updateModel(vulkanRenderer.getAssetIndex(grids[i]), models[i]);
+        }
+
+        double frameMs[2];
+        DrawStats drawStats[2];
+        for (int indirect = 0; indirect < 2; indirect++)
+        {
+            vulkanRenderer.setIndirectDrawing(indirect == 1);
+            frameMs[indirect] = measureFrameTime(frameCount);
+            drawStats[indirect] = vulkanRenderer.getDrawStats();
+        }
+
+        printf("Indirect benchmark (%u meshes): per-mesh draws %u calls, %u binds (%u avoided), record %.3f ms, frame %.3f ms; "
+            "indirect %u calls, %u binds (%u avoided), record %.3f ms, frame %.3f ms\n", meshCount, drawStats[0].drawCalls, drawStats[0].bindCalls,
+            drawStats[0].avoidedBinds, drawStats[0].recordMs, frameMs[0], drawStats[1].drawCalls, drawStats[1].bindCalls, drawStats[1].avoidedBinds,
+            drawStats[1].recordMs, frameMs[1]);
+    }
+
+    vulkanRenderer.setIndirectDrawing(true);
+    vulkanRenderer.setGpuCulling(true);
+    vulkanRenderer.setCpuCulling(true);
+}
+
+// Instances of one mesh drawn indirectly without culling, with frustum culling on GPU and with occlusion culling as well.
+// Camera sees only part of the field, rest is spread around it, and a wall instance in front hides what it sees.
+// Visible counts are read back after frame's fence, so they are a few frames old.
+void runCullingBenchmark()
+{
+    if (!vulkanRenderer.isIndirectDrawingSupported())
+    {
+        printf("Culling benchmark: device doesn't support multiDrawIndirect / drawIndirectCount\n");
+        return;
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    createGrid(16, &vertices, &indices);
+
+    const int frameCount = 300;
+    const uint32_t instanceCounts[] = { 10000, 100000 };
+
+    AssetHandle grid = vulkanRenderer.streamMesh(vertices, indices, INVALID_ASSET, 0.0f);
+    while (vulkanRenderer.getAssetIndex(grid) < 0 && !glfwWindowShouldClose(window))
+    {
+        glfwPollEvents();
+        vulkanRenderer.draw();
+    }
+    int gridMesh = vulkanRenderer.getAssetIndex(grid);
+
+    for (uint32_t instanceCount : instanceCounts)
+    {
+        // Every fourth instance stays in field in front of camera, others are turned around behind it
+        std::vector<glm::mat4> models = createInstanceField(instanceCount);
+        for (uint32_t i = 0; i < instanceCount; i++)
+        {
+            if (i % 4 != 0)
+            {
+                models[i] = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f * static_cast<float>(i % 4)), glm::vec3(0.0f, 1.0f, 0.0f)) * models[i];
+            }
+        }
+        models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -2.5f)), glm::vec3(40.0f)));
+        vulkanRenderer.setInstances(gridMesh, models);
+
+        // Unculled, frustum, frustum and occlusion
+        double frameMs[3];
+        DrawStats drawStats[3];
+        CullStats cullStats[3];
+        for (int mode = 0; mode < 3; mode++)
+        {
+            vulkanRenderer.setCpuCulling(mode > 0);
+            vulkanRenderer.setGpuCulling(mode > 0);
+            vulkanRenderer.setOcclusionCulling(mode > 1);
+            frameMs[mode] = measureFrameTime(frameCount);
+            drawStats[mode] = vulkanRenderer.getDrawStats();
+            cullStats[mode] = vulkanRenderer.getCullStats();
+        }
+
+        printf("Culling benchmark (%u instances): unculled %u draws, record %.3f ms, frame %.3f ms\n", instanceCount + 1, drawStats[0].indirectDraws,
+            drawStats[0].recordMs, frameMs[0]);
+        printf("  frustum: %u visible, record %.3f ms, frame %.3f ms\n", cullStats[1].visibleObjects, drawStats[1].recordMs, frameMs[1]);
+        printf("  frustum + occlusion: %u visible (%u disoccluded), %u occluded, record %.3f ms, frame %.3f ms\n", cullStats[2].visibleObjects,
+            cullStats[2].disoccludedObjects, cullStats[2].occludedObjects, drawStats[2].recordMs, frameMs[2]);
+    }
+
+    vulkanRenderer.clearInstances(gridMesh);
+    vulkanRenderer.setCpuCulling(true);
+    vulkanRenderer.setGpuCulling(true);
+    vulkanRenderer.setOcclusionCulling(true);
+}
+
+// Loads every entry of asset archive into a staging sized buffer - once through ifstream of loose file, once from mapped archive.
+// Run after AssetCooker --pack, loose files have to be present too. Second and later rounds of both paths hit OS file cache.
+int runArchiveBenchmark()
+{
+    AssetArchive archive;
+    if (!archive.open(ASSET_ARCHIVE_FILE))
+    {
+        printf("Archive benchmark: %s not found, run AssetCooker --pack first\n", ASSET_ARCHIVE_FILE);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> names = archive.getNames();
+    const int rounds = 20;
+
+    // Stands in for mapped staging memory
+    size_t largestEntry = 0;
+    size_t totalBytes = 0;
+    for (const std::string& name : names)
+    {
+        const char* data;
+        size_t size;
+        archive.find(name, &data, &size);
+        largestEntry = std::max(largestEntry, size);
+        totalBytes += size;
+    }
+    std::vector<char> staging(largestEntry);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        for (const std::string& name : names)
+        {
+            std::vector<char> file = readFile(name);
+            memcpy(staging.data(), file.data(), file.size());
+        }
+    }
+    double streamMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        for (const std::string& name : names)
+        {
+            const char* data;
+            size_t size;
+            archive.find(name, &data, &size);
+            memcpy(staging.data(), data, size);
+        }
+    }
+    double archiveMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    double megabytes = static_cast<double>(totalBytes) * rounds / (1024.0 * 1024.0);
+    printf("Archive benchmark (%zu entries, %.2f MB, %d rounds): ifstream %.2f ms (%.0f MB/s), mapped archive %.2f ms (%.0f MB/s)\n",
+        names.size(), static_cast<double>(totalBytes) / (1024.0 * 1024.0), rounds, streamMs, megabytes * 1000.0 / streamMs, archiveMs, megabytes * 1000.0 / archiveMs);
+
+    archive.close();
+
+    return 0;
+}
+
+// Culls random bounding spheres around camera with every kernel CPU supports (results are checked by FrustumCullerTests)
+int runFrustumBenchmark()
+{
+    const uint32_t sphereCounts[] = { 10000, 100000, 1000000 };
+    const int rounds = 20;
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    projection[1][1] *= -1;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec4 planes[6];
+    FrustumCuller::getFrustumPlanes(projection * view, planes);
+
+    // Fixed seed - same spheres on every run
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> radius(0.05f, 4.0f);
+
+    FrustumCuller culler;
+    std::vector<uint32_t> visible;
+    for (uint32_t sphereCount : sphereCounts)
+    {
+        BoundingSpheres spheres;
+        for (uint32_t i = 0; i < sphereCount; i++)
+        {
+            spheres.add(glm::vec4(position(random), position(random), position(random), radius(random)));
+        }
+
+        for (uint32_t kernel = static_cast<uint32_t>(CullKernel::Scalar); kernel <= static_cast<uint32_t>(CullKernel::Avx2); kernel++)
+        {
+            if (!FrustumCuller::isKernelSupported(static_cast<CullKernel>(kernel)))
+            {
+                continue;
+            }
+            culler.setKernel(static_cast<CullKernel>(kernel));
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < rounds; i++)
+            {
+                culler.cull(spheres, planes, &visible);
+            }
+            double cullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+            printf("Frustum benchmark (%u spheres): %s %.3f ms (%.2f ns/sphere), %zu visible\n", sphereCount, FrustumCuller::getKernelName(culler.getKernel()),
+                cullMs, cullMs * 1000000.0 / sphereCount, visible.size());
+        }
+    }
+
+    return 0;
+}
+
+// Rasterizes a street of box buildings in software and tests random boxes behind and between them, with every kernel CPU
+// supports on calling thread and on a thread pool (results are checked by OcclusionRasterizerTests)
+int runOcclusionBenchmark()
+{
+    const uint32_t buildingCount = 400;
+    const uint32_t boxCount = 100000;
+    const int rounds = 20;
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 200.0f);
+    projection[1][1] *= -1;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.5f, 0.0f), glm::vec3(0.0f, 1.5f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    // Unit cube - twelve triangles
+    std::vector<glm::vec3> cube;
+    for (int i = 0; i < 8; i++)
+    {
+        cube.push_back(glm::vec3((i & 1) != 0 ? 0.5f : -0.5f, (i & 2) != 0 ? 1.0f : 0.0f, (i & 4) != 0 ? 0.5f : -0.5f));
+    }
+    std::vector<uint32_t> cubeIndices = {
+        0, 1, 3, 3, 2, 0,   4, 6, 7, 7, 5, 4,   0, 4, 5, 5, 1, 0,
+        2, 3, 7, 7, 6, 2,   0, 2, 6, 6, 4, 0,   1, 5, 7, 7, 3, 1
+    };
+
+    // Fixed seed - same scene on every run. Buildings line both sides of street going away from camera.
+    std::mt19937 random(4321);
+    std::uniform_real_distribution<float> side(8.0f, 40.0f);
+    std::uniform_real_distribution<float> distance(-150.0f, -5.0f);
+    std::uniform_real_distribution<float> size(2.0f, 6.0f);
+    std::vector<glm::mat4> buildings;
+    for (uint32_t i = 0; i < buildingCount; i++)
+    {
+        float x = (i % 2 == 0 ? -1.0f : 1.0f) * side(random);
+        buildings.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, distance(random))), glm::vec3(size(random), size(random) * 2.0f, size(random))));
+    }
+
+    std::uniform_real_distribution<float> boxX(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> boxY(0.0f, 6.0f);
+    std::vector<glm::mat4> boxes;
+    for (uint32_t i = 0; i < boxCount; i++)
+    {
+        boxes.push_back(viewProjection * glm::translate(glm::mat4(1.0f), glm::vec3(boxX(random), boxY(random), distance(random))));
+    }
+    glm::vec3 boxMin(-0.5f);
+    glm::vec3 boxMax(0.5f);
+
+    ThreadPool threadPool;
+
+    for (uint32_t kernel = static_cast<uint32_t>(CullKernel::Scalar); kernel <= static_cast<uint32_t>(CullKernel::Avx2); kernel++)
+    {
+        if (!FrustumCuller::isKernelSupported(static_cast<CullKernel>(kernel)))
+        {
+            continue;
+        }
+
+        for (int threaded = 0; threaded < 2; threaded++)
+        {
+            OcclusionRasterizer rasterizer(threaded != 0 ? &threadPool : nullptr, OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_WIDTH * 600 / 800);
+            rasterizer.setKernel(static_cast<CullKernel>(kernel));
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < rounds; i++)
+            {
+                rasterizer.clear();
+                for (const glm::mat4& building : buildings)
+                {
+                    rasterizer.addOccluder(cube, cubeIndices, viewProjection * building);
+                }
+                rasterizer.rasterize();
+            }
+            double rasterizeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+            start = std::chrono::high_resolution_clock::now();
+            uint32_t occluded = 0;
+            for (uint32_t i = 0; i < boxCount; i++)
+            {
+                occluded += rasterizer.isBoxVisible(boxMin, boxMax, boxes[i]) ? 0 : 1;
+            }
+            double testMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            printf("Occlusion benchmark (%u triangles, %ux%u): %s%s rasterize %.3f ms, %u boxes tested %.3f ms (%.1f ns/box), %u occluded or off screen\n",
+                rasterizer.getTriangleCount(), rasterizer.getWidth(), rasterizer.getHeight(), FrustumCuller::getKernelName(rasterizer.getKernel()),
+                threaded != 0 ? " threaded" : "", rasterizeMs, boxCount, testMs, testMs * 1000000.0 / boxCount, occluded);
+        }
+    }
+
+    return 0;
+}
+
+// Times render queue sorts of random draw keys on calling thread and on a thread pool against std::stable_sort of same keys -
+// their order is checked by RenderQueueTests.
+int runSortBenchmark()
+{
+    const uint32_t drawCounts[] = { 1000, 10000, 100000, 1000000 };
+    const int rounds = 20;
+
+    // Fixed seed - same keys on every run
+    std::mt19937 random(2468);
+    std::uniform_int_distribution<uint32_t> pipeline(0, VERTEX_LAYOUT_COUNT - 1);
+    std::uniform_int_distribution<uint32_t> indexType(0, 1);
+    std::uniform_int_distribution<uint32_t> texture(0, MAX_TEXTURES - 1);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+    ThreadPool threadPool;
+    for (uint32_t drawCount : drawCounts)
+    {
+        std::vector<uint64_t> keys(drawCount);
+        for (uint32_t i = 0; i < drawCount; i++)
+        {
+            keys[i] = RenderQueue::makeKey(DrawPass::Opaque, pipeline(random), indexType(random), texture(random), depth(random));
+        }
+
+        // Key and index it was added at
+        std::vector<std::pair<uint64_t, uint32_t>> unsorted(drawCount);
+        for (uint32_t i = 0; i < drawCount; i++)
+        {
+            unsorted[i] = std::make_pair(keys[i], i);
+        }
+        std::vector<std::pair<uint64_t, uint32_t>> expected;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < rounds; i++)
+        {
+            expected = unsorted;
+            std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) { return a.first < b.first; });
+        }
+        double stableSortMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+        double sortMs[2];
+        for (int threaded = 0; threaded < 2; threaded++)
+        {
+            RenderQueue queue(threaded != 0 ? &threadPool : nullptr);
+            QueuedDraw draw = {};
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < rounds; i++)
+            {
+                queue.clear();
+                for (uint32_t j = 0; j < drawCount; j++)
+                {
+                    draw.meshId = j;
+                    queue.add(keys[j], draw);
+                }
+                queue.sort();
+            }
+            sortMs[threaded] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+        }
+
+        printf("Sort benchmark (%u draws): radix %.3f ms, threaded radix %.3f ms (both with queue fill), std::stable_sort %.3f ms\n",
+            drawCount, sortMs[0], sortMs[1], stableSortMs);
+    }
+
+    return 0;
+}
+
+// Runs benchmark named by first argument - from VulkanGraphicEngine directory, where shaders, textures and models are
+int main(int argc, char** argv) {
+
+    if (argc < 2)
+    {
+        printf("Usage: VulkanGraphicEngineBench <benchmark>\n");
+        printf("  CPU only: archive, frustum, occlusion, sort\n");
+        printf("  Rendering: mip, vertex, instancing, indirect, culling\n");
+        return EXIT_FAILURE;
+    }
+    std::string benchmark = argv[1];
+
+    // Doesn't need a device - only file loading is measured
+    if (benchmark == "archive")
+    {
+        return runArchiveBenchmark();
+    }
+
+    // CPU only as well
+    if (benchmark == "frustum")
+    {
+        return runFrustumBenchmark();
+    }
+
+    if (benchmark == "occlusion")
+    {
+        return runOcclusionBenchmark();
+    }
+
+    if (benchmark == "sort")
+    {
+        return runSortBenchmark();
+    }
+
+    if (benchmark != "mip" && benchmark != "vertex" && benchmark != "instancing" && benchmark != "indirect" && benchmark != "culling")
+    {
+        printf("Unknown benchmark %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    initWindow(title.c_str(), 800, 600);
+
+    if (vulkanRenderer.init(window) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    if (benchmark == "mip")
+    {
+        runMipBenchmark();
+    }
+    else if (benchmark == "vertex")
+    {
+        runVertexBenchmark();
+    }
+    else if (benchmark == "instancing")
+    {
+        runInstancingBenchmark();
+    }
+    else if (benchmark == "indirect")
+    {
+        runIndirectBenchmark();
+    }
+    else
+    {
+        runCullingBenchmark();
+    }
+
+    vulkanRenderer.cleanup();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return 0;
+}
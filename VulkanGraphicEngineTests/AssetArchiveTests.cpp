@@ -0,0 +1,82 @@
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+#include "TestFramework.h"
+#include "AssetArchive.h"
+
+// Archive with a single entry - its data is written at ARCHIVE_ALIGNMENT whatever offset and size the entry claims
+static std::string makeArchive(const std::string& name, const std::string& data, uint64_t offset, uint64_t size)
+{
+    ArchiveHeader header = {};
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = 1;
+    header.namesSize = static_cast<uint32_t>(name.size());
+
+    ArchiveEntry entry = {};
+    entry.offset = offset;
+    entry.size = size;
+    entry.nameOffset = 0;
+    entry.nameLength = static_cast<uint32_t>(name.size());
+
+    std::string archive(reinterpret_cast<const char*>(&header), sizeof(ArchiveHeader));
+    archive.append(reinterpret_cast<const char*>(&entry), sizeof(ArchiveEntry));
+    archive += name;
+    archive.resize(static_cast<size_t>(ARCHIVE_ALIGNMENT), '\0');
+    archive += data;
+
+    return archive;
+}
+
+static bool openThrows(const std::string& filename)
+{
+    AssetArchive archive;
+    try
+    {
+        archive.open(filename);
+    }
+    catch (const std::runtime_error&)
+    {
+        return !archive.isOpen();
+    }
+    return false;
+}
+
+TEST(archiveFindsEntriesInPlace)
+{
+    std::string data = "SPIR-V words";
+    TemporaryFile file("ArchiveTest.pak", makeArchive("Shaders/vert.spv", data, ARCHIVE_ALIGNMENT, data.size()));
+
+    // Declared after file - destructor unmaps it before file is removed
+    AssetArchive archive;
+    CHECK(archive.open(file.filename));
+
+    const char* found = nullptr;
+    size_t foundSize = 0;
+    CHECK(archive.find("Shaders/vert.spv", &found, &foundSize));
+    CHECK(foundSize == data.size() && found != nullptr && std::string(found, foundSize) == data);
+    CHECK(!archive.find("Shaders/frag.spv", &found, &foundSize));
+
+    AssetArchive missing;
+    CHECK(!missing.open("MissingArchiveTest.pak"));
+}
+
+TEST(archiveRejectsEntriesOutOfBounds)
+{
+    // Offset + size wraps around to less than file size
+    TemporaryFile wrapping("ArchiveTest.pak", makeArchive("a", "data", ARCHIVE_ALIGNMENT, UINT64_MAX - ARCHIVE_ALIGNMENT + 2));
+    CHECK(openThrows(wrapping.filename));
+
+    TemporaryFile beyond("ArchiveTest2.pak", makeArchive("a", "data", UINT64_MAX - 1, 1));
+    CHECK(openThrows(beyond.filename));
+
+    TemporaryFile longer("ArchiveTest3.pak", makeArchive("a", "data", ARCHIVE_ALIGNMENT, 5));
+    CHECK(openThrows(longer.filename));
+}
+
+TEST(archiveRejectsMisalignedEntries)
+{
+    TemporaryFile file("ArchiveTest.pak", makeArchive("a", "data", ARCHIVE_ALIGNMENT + 1, 3));
+    CHECK(openThrows(file.filename));
+}
@@ -0,0 +1,91 @@
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+
+#include "TestFramework.h"
+#include "FrustumCuller.h"
+
+// Camera at origin looking down -z, 45 degree vertical field of view, 4:3, depth 0.1 to 100
+static void getTestPlanes(glm::vec4 planes[6])
+{
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    projection[1][1] *= -1;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    FrustumCuller::getFrustumPlanes(projection * view, planes);
+}
+
+static bool isSphereVisible(CullKernel kernel, const glm::vec4& sphere)
+{
+    glm::vec4 planes[6];
+    getTestPlanes(planes);
+
+    BoundingSpheres spheres;
+    spheres.add(sphere);
+
+    FrustumCuller culler;
+    culler.setKernel(kernel);
+    std::vector<uint32_t> visible;
+    culler.cull(spheres, planes, &visible);
+
+    return visible.size() == 1;
+}
+
+TEST(frustumCullsSpheresOutsideEveryPlane)
+{
+    for (uint32_t kernel = static_cast<uint32_t>(CullKernel::Scalar); kernel <= static_cast<uint32_t>(CullKernel::Avx2); kernel++)
+    {
+        CullKernel cullKernel = static_cast<CullKernel>(kernel);
+        CHECK(isSphereVisible(cullKernel, glm::vec4(0.0f, 0.0f, -10.0f, 1.0f)));
+        CHECK(!isSphereVisible(cullKernel, glm::vec4(0.0f, 0.0f, 10.0f, 1.0f)));        // Behind camera
+        CHECK(!isSphereVisible(cullKernel, glm::vec4(0.0f, 0.0f, -110.0f, 1.0f)));      // Beyond far plane
+        CHECK(isSphereVisible(cullKernel, glm::vec4(0.0f, 0.0f, -100.5f, 1.0f)));       // Crossing far plane
+
+        // Left plane is about 5.5 units from axis at depth 10 - sphere 1.3 units outside of it
+        CHECK(!isSphereVisible(cullKernel, glm::vec4(-7.0f, 0.0f, -10.0f, 1.0f)));
+        CHECK(isSphereVisible(cullKernel, glm::vec4(-7.0f, 0.0f, -10.0f, 2.0f)));
+        CHECK(!isSphereVisible(cullKernel, glm::vec4(0.0f, 7.0f, -10.0f, 1.0f)));
+    }
+}
+
+// SIMD kernels handle groups of 4 / 8 spheres and the rest one by one - every count gives the same indices as scalar one
+TEST(frustumKernelsMatchScalar)
+{
+    glm::vec4 planes[6];
+    getTestPlanes(planes);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> radius(0.05f, 4.0f);
+    std::vector<glm::vec4> spheres;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        spheres.push_back(glm::vec4(position(random), position(random), position(random), radius(random)));
+    }
+
+    const uint32_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 19, 10000 };
+    FrustumCuller culler;
+    std::vector<uint32_t> expected, visible;
+    for (uint32_t count : counts)
+    {
+        BoundingSpheres subset;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            subset.add(spheres[i]);
+        }
+
+        culler.setKernel(CullKernel::Scalar);
+        culler.cull(subset, planes, &expected);
+        CHECK(std::is_sorted(expected.begin(), expected.end()));
+
+        // Unsupported kernel falls back to a supported one - still has to match
+        for (uint32_t kernel = static_cast<uint32_t>(CullKernel::Sse); kernel <= static_cast<uint32_t>(CullKernel::Avx2); kernel++)
+        {
+            culler.setKernel(static_cast<CullKernel>(kernel));
+            culler.cull(subset, planes, &visible);
+            CHECK(visible == expected);
+        }
+    }
+}
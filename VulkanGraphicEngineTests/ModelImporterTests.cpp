@@ -0,0 +1,86 @@
+#include <string>
+
+#include "TestFramework.h"
+#include "ModelImporter.h"
+
+// Triangle i has positions (3i, 3i + 1, 3i + 2, 0, 0) and texture coordinates with same u. Faces only use relative indices,
+// and comment lines make file big enough to be split into many chunks - some faces end up in later chunk than their vertices.
+static std::string makeRelativeObj(uint32_t triangleCount)
+{
+    std::string text;
+    std::string padding = "# " + std::string(120, '-') + "\n";
+    for (uint32_t i = 0; i < triangleCount * 3; i++)
+    {
+        text += "v " + std::to_string(i) + " 0 0\n";
+        text += "vt " + std::to_string(i) + " 0\n";
+        text += padding;
+        if (i % 3 == 2)
+        {
+            text += "f -3/-3 -2/-2 -1/-1\n";
+        }
+    }
+    return text;
+}
+
+TEST(objRelativeIndicesReachAcrossChunks)
+{
+    const uint32_t triangleCount = 2000;
+    TemporaryFile file("RelativeIndicesTest.obj", makeRelativeObj(triangleCount));
+
+    // Thread count fixes number of chunks text is split into
+    ThreadPool threadPool(4);
+    ModelImporter importer(&threadPool);
+    std::vector<MeshData> meshes = importer.importObj(file.filename);
+
+    CHECK(meshes.size() == 1);
+    if (meshes.size() != 1)
+    {
+        return;
+    }
+
+    const MeshData& mesh = meshes[0];
+    CHECK(mesh.indices.size() == triangleCount * 3);
+    CHECK(mesh.vertices.size() == triangleCount * 3);
+
+    uint32_t wrongCorners = 0;
+    for (size_t i = 0; i < mesh.indices.size(); i++)
+    {
+        const Vertex& vertex = mesh.vertices[mesh.indices[i]];
+        wrongCorners += vertex.pos.x == static_cast<float>(i) && vertex.tex.x == static_cast<float>(i) ? 0 : 1;
+    }
+    CHECK(wrongCorners == 0);
+}
+
+TEST(objRelativeIndexBeforeFirstVertexThrows)
+{
+    TemporaryFile file("RelativeIndicesTest.obj", "v 0 0 0\nv 1 0 0\nf -1 -2 -3\n");
+
+    ThreadPool threadPool(4);
+    ModelImporter importer(&threadPool);
+    bool threw = false;
+    try
+    {
+        importer.importObj(file.filename);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Cooker hashes these files with model - they have to be the ones importObj opens
+TEST(objMaterialLibrariesAreRelativeToModel)
+{
+    std::string text = "# mtllib commented.mtl\nmtllib first.mtl\nv 0 0 0\n  mtllib Materials/second.mtl \r\nf 1 1 1";
+    std::vector<std::string> libraries = ModelImporter::getMaterialLibraries("Models/house.obj", std::vector<char>(text.begin(), text.end()));
+
+    CHECK(libraries.size() == 2);
+    if (libraries.size() != 2)
+    {
+        return;
+    }
+
+    CHECK(libraries[0] == "Models/first.mtl");
+    CHECK(libraries[1] == "Models/Materials/second.mtl");
+}
@@ -0,0 +1,137 @@
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <cstring>
+
+#include "TestFramework.h"
+#include "OcclusionRasterizer.h"
+
+const uint32_t TEST_BUFFER_WIDTH = 256;
+const uint32_t TEST_BUFFER_HEIGHT = 192;
+
+// Unit cube centered at origin - twelve triangles
+static void getCube(std::vector<glm::vec3>* positions, std::vector<uint32_t>* indices)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        positions->push_back(glm::vec3((i & 1) != 0 ? 0.5f : -0.5f, (i & 2) != 0 ? 0.5f : -0.5f, (i & 4) != 0 ? 0.5f : -0.5f));
+    }
+    *indices = {
+        0, 1, 3, 3, 2, 0,   4, 6, 7, 7, 5, 4,   0, 4, 5, 5, 1, 0,
+        2, 3, 7, 7, 6, 2,   0, 2, 6, 6, 4, 0,   1, 5, 7, 7, 3, 1
+    };
+}
+
+// Camera at origin looking down -z, 45 degree vertical field of view, 4:3, depth 0.1 to 100
+static glm::mat4 getTestViewProjection()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    projection[1][1] *= -1;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return projection * view;
+}
+
+static bool isUnitBoxVisible(const OcclusionRasterizer& rasterizer, const glm::vec3& center)
+{
+    glm::mat4 modelViewProjection = getTestViewProjection() * glm::translate(glm::mat4(1.0f), center);
+    return rasterizer.isBoxVisible(glm::vec3(-0.5f), glm::vec3(0.5f), modelViewProjection);
+}
+
+// Wall 4 x 4 units at depth 10 - everything within 4 units of the axis at depth 20 is behind it
+TEST(occlusionBoxesAroundWall)
+{
+    std::vector<glm::vec3> cube;
+    std::vector<uint32_t> cubeIndices;
+    getCube(&cube, &cubeIndices);
+    glm::mat4 wall = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec3(4.0f, 4.0f, 0.5f));
+
+    ThreadPool threadPool(4);
+    for (uint32_t kernel = static_cast<uint32_t>(CullKernel::Scalar); kernel <= static_cast<uint32_t>(CullKernel::Avx2); kernel++)
+    {
+        for (int threaded = 0; threaded < 2; threaded++)
+        {
+            OcclusionRasterizer rasterizer(threaded != 0 ? &threadPool : nullptr, TEST_BUFFER_WIDTH, TEST_BUFFER_HEIGHT);
+            rasterizer.setKernel(static_cast<CullKernel>(kernel));
+
+            // Nothing rasterized yet - every box on screen is visible
+            rasterizer.clear();
+            rasterizer.rasterize();
+            CHECK(isUnitBoxVisible(rasterizer, glm::vec3(0.0f, 0.0f, -20.0f)));
+
+            rasterizer.clear();
+            rasterizer.addOccluder(cube, cubeIndices, getTestViewProjection() * wall);
+            rasterizer.rasterize();
+            CHECK(rasterizer.getTriangleCount() > 0);
+
+            CHECK(!isUnitBoxVisible(rasterizer, glm::vec3(0.0f, 0.0f, -20.0f)));     // Fully behind
+            CHECK(!isUnitBoxVisible(rasterizer, glm::vec3(2.0f, 1.0f, -20.0f)));     // Behind, off center
+            CHECK(isUnitBoxVisible(rasterizer, glm::vec3(0.0f, 0.0f, -5.0f)));       // In front
+            CHECK(isUnitBoxVisible(rasterizer, glm::vec3(7.0f, 0.0f, -20.0f)));      // Beside
+            CHECK(isUnitBoxVisible(rasterizer, glm::vec3(4.0f, 0.0f, -20.0f)));      // Partly behind edge
+            CHECK(isUnitBoxVisible(rasterizer, glm::vec3(0.0f, 0.0f, 0.0f)));        // Crossing near plane
+            CHECK(!isUnitBoxVisible(rasterizer, glm::vec3(30.0f, 0.0f, -20.0f)));    // Off screen
+        }
+    }
+}
+
+// Depth tiles and visibility of random scene have to be the same for every kernel and thread count
+TEST(occlusionKernelsAndThreadsMatch)
+{
+    std::vector<glm::vec3> cube;
+    std::vector<uint32_t> cubeIndices;
+    getCube(&cube, &cubeIndices);
+    glm::mat4 viewProjection = getTestViewProjection();
+
+    std::mt19937 random(4321);
+    std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> distance(-90.0f, -3.0f);
+    std::uniform_real_distribution<float> size(0.5f, 6.0f);
+    std::vector<glm::mat4> occluders;
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random) * 0.5f, distance(random)));
+        occluders.push_back(viewProjection * glm::scale(model, glm::vec3(size(random), size(random), size(random))));
+    }
+    std::vector<glm::vec3> boxes;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        boxes.push_back(glm::vec3(position(random) * 2.0f, position(random), distance(random)));
+    }
+
+    ThreadPool threadPool(4);
+    std::vector<OcclusionTile> expectedTiles;
+    std::vector<bool> expectedVisible;
+    for (uint32_t kernel = static_cast<uint32_t>(CullKernel::Scalar); kernel <= static_cast<uint32_t>(CullKernel::Avx2); kernel++)
+    {
+        for (int threaded = 0; threaded < 2; threaded++)
+        {
+            OcclusionRasterizer rasterizer(threaded != 0 ? &threadPool : nullptr, TEST_BUFFER_WIDTH, TEST_BUFFER_HEIGHT);
+            rasterizer.setKernel(static_cast<CullKernel>(kernel));
+            rasterizer.clear();
+            for (const glm::mat4& occluder : occluders)
+            {
+                rasterizer.addOccluder(cube, cubeIndices, occluder);
+            }
+            rasterizer.rasterize();
+
+            std::vector<bool> visible;
+            for (const glm::vec3& box : boxes)
+            {
+                visible.push_back(isUnitBoxVisible(rasterizer, box));
+            }
+
+            const std::vector<OcclusionTile>& tiles = rasterizer.getTiles();
+            if (expectedTiles.empty())
+            {
+                expectedTiles = tiles;
+                expectedVisible = visible;
+                continue;
+            }
+            CHECK(tiles.size() == expectedTiles.size() && memcmp(tiles.data(), expectedTiles.data(), tiles.size() * sizeof(OcclusionTile)) == 0);
+            CHECK(visible == expectedVisible);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#include <random>
+#include <algorithm>
+
+#include "TestFramework.h"
+#include "RenderQueue.h"
+
+TEST(renderQueueKeysOrderStateThenDepth)
+{
+    // Every field outranks all fields after it
+    CHECK(RenderQueue::makeKey(DrawPass::Opaque, 0, 1, 65535, 1000.0f) < RenderQueue::makeKey(DrawPass::Opaque, 1, 0, 0, 0.0f));
+    CHECK(RenderQueue::makeKey(DrawPass::Opaque, 1, 0, 65535, 1000.0f) < RenderQueue::makeKey(DrawPass::Opaque, 1, 1, 0, 0.0f));
+    CHECK(RenderQueue::makeKey(DrawPass::Opaque, 1, 1, 3, 1000.0f) < RenderQueue::makeKey(DrawPass::Opaque, 1, 1, 4, 0.0f));
+
+    // Same state - near first, negative depth counts as 0
+    CHECK(RenderQueue::makeKey(DrawPass::Opaque, 2, 0, 7, 1.0f) < RenderQueue::makeKey(DrawPass::Opaque, 2, 0, 7, 2.0f));
+    CHECK(RenderQueue::makeKey(DrawPass::Opaque, 2, 0, 7, 0.5f) < RenderQueue::makeKey(DrawPass::Opaque, 2, 0, 7, 50.0f));
+    CHECK(RenderQueue::makeKey(DrawPass::Opaque, 2, 0, 7, -1.0f) == RenderQueue::makeKey(DrawPass::Opaque, 2, 0, 7, 0.0f));
+}
+
+// Radix sort has to give exactly the order of std::stable_sort - draws with equal keys keep the order they were added in.
+// Counts from RENDER_QUEUE_PARALLEL_DRAWS up are sorted in chunks on thread pool.
+TEST(renderQueueSortIsStable)
+{
+    const uint32_t drawCounts[] = { 0, 1, 2, 100, 5000, static_cast<uint32_t>(RENDER_QUEUE_PARALLEL_DRAWS), 100000 };
+
+    std::mt19937 random(2468);
+    std::uniform_int_distribution<uint32_t> pipeline(0, 3);
+    std::uniform_int_distribution<uint32_t> indexType(0, 1);
+    std::uniform_int_distribution<uint32_t> texture(0, 15);                 // Few textures and depths - many equal keys
+    std::uniform_int_distribution<uint32_t> depth(0, 20);
+
+    ThreadPool threadPool(4);
+    for (uint32_t drawCount : drawCounts)
+    {
+        std::vector<std::pair<uint64_t, uint32_t>> expected(drawCount);
+        for (uint32_t i = 0; i < drawCount; i++)
+        {
+            expected[i] = std::make_pair(RenderQueue::makeKey(DrawPass::Opaque, pipeline(random), indexType(random), texture(random),
+                static_cast<float>(depth(random))), i);
+        }
+
+        for (int threaded = 0; threaded < 2; threaded++)
+        {
+            RenderQueue queue(threaded != 0 ? &threadPool : nullptr);
+            QueuedDraw draw = {};
+            for (uint32_t i = 0; i < drawCount; i++)
+            {
+                draw.meshId = i;
+                queue.add(expected[i].first, draw);
+            }
+            queue.sort();
+
+            std::vector<std::pair<uint64_t, uint32_t>> sorted(drawCount);
+            for (uint32_t i = 0; i < drawCount; i++)
+            {
+                sorted[i] = std::make_pair(queue.getKey(i), queue.getDraw(i).meshId);
+            }
+
+            std::vector<std::pair<uint64_t, uint32_t>> reference = expected;
+            std::stable_sort(reference.begin(), reference.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b)
+            {
+                return a.first < b.first;
+            });
+
+            CHECK(queue.size() == drawCount);
+            CHECK(sorted == reference);
+        }
+    }
+}
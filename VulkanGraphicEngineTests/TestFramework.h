@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+
+// Test function registered by TEST - main runs every one of them
+struct TestCase {
+    const char* name;
+    void (*function)();
+};
+
+std::vector<TestCase>& getTests();
+
+// Failed CHECK - test carries on, runner reports it as failed once it returns
+void reportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistration {
+    TestRegistration(const char* name, void (*function)())
+    {
+        getTests().push_back({ name, function });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name); \
+    static void name()
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) \
+        { \
+            reportFailure(__FILE__, __LINE__, #expression); \
+        } \
+    } while (false)
+
+// Writes text to a file removed again when test is done
+class TemporaryFile
+{
+public:
+    TemporaryFile(const std::string& filename, const std::string& text)
+    {
+        this->filename = filename;
+        std::ofstream file(filename, std::ios::binary);
+        file << text;
+    }
+
+    ~TemporaryFile()
+    {
+        std::remove(filename.c_str());
+    }
+
+    std::string filename;
+};
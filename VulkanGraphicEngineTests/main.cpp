@@ -0,0 +1,55 @@
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include "TestFramework.h"
+
+static int failureCount = 0;
+
+std::vector<TestCase>& getTests()
+{
+    // Function local - registrations of other files run before main, in no particular order
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void reportFailure(const char* file, int line, const char* expression)
+{
+    printf("    %s(%d): CHECK(%s) failed\n", file, line, expression);
+    failureCount++;
+}
+
+// Runs every test, or only those whose name contains first argument. Exit code is non-zero if any test failed.
+int main(int argc, char** argv)
+{
+    int runCount = 0;
+    int failedCount = 0;
+    for (const TestCase& test : getTests())
+    {
+        if (argc > 1 && strstr(test.name, argv[1]) == nullptr)
+        {
+            continue;
+        }
+
+        int failuresBefore = failureCount;
+        try
+        {
+            test.function();
+        }
+        catch (const std::exception& e)
+        {
+            printf("    exception: %s\n", e.what());
+            failureCount++;
+        }
+
+        bool passed = failureCount == failuresBefore;
+        printf("%s %s\n", passed ? "[  OK  ]" : "[FAILED]", test.name);
+        runCount++;
+        failedCount += passed ? 0 : 1;
+    }
+
+    printf("%d of %d tests passed\n", runCount - failedCount, runCount);
+
+    return failedCount > 0 ? EXIT_FAILURE : 0;
+}